@@ -0,0 +1,149 @@
+"""Compile Mage's Descent text content into a .mdpak content pack.
+
+Reads the same block format as src/rpg_data.h ([ENEMY], [ITEM], [SPELL],
+[QUEST] and [SHOP] blocks; dungeon files starting with [INFO]) and writes a
+binary pack the game mounts from /rpg/packs on the SD card. A pack record
+replaces the built-in record with the same id.
+
+Usage:
+    python build_content_pack.py [-o OUT.mdpak] [SOURCE ...]
+
+Sources are .txt files or folders of them. With none given, the files under
+sd_card_files/rpg/data and sd_card_files/rpg/dungeons are compiled.
+"""
+
+import argparse
+import os
+import re
+import struct
+import sys
+
+BASE_DIR = os.path.dirname(os.path.abspath(__file__))
+DEFAULT_SOURCES = [
+    os.path.join(BASE_DIR, "sd_card_files", "rpg", "data"),
+    os.path.join(BASE_DIR, "sd_card_files", "rpg", "dungeons"),
+]
+DEFAULT_OUTPUT = os.path.join(BASE_DIR, "content.mdpak")
+
+# Must match src/rpg_pack.h
+PACK_MAGIC = b"MDPK"
+PACK_VERSION = 1
+PACK_RECORD_MAX = 512
+# In PackType order
+TYPES = ["ENEMY", "ITEM", "SPELL", "QUEST", "SHOP", "DUNGEON"]
+DUNGEON = TYPES.index("DUNGEON")
+
+ID_LINE = re.compile(r"^id=(\d+)\s*$", re.MULTILINE)
+
+
+def split_blocks(text):
+    """Yield (tag, block_text) for each [TAG] block in a record file."""
+    tag, lines = None, []
+    for line in text.splitlines():
+        header = re.match(r"^\[([A-Z]+)\]\s*$", line.strip())
+        if header:
+            if tag:
+                yield tag, "\n".join(lines).strip() + "\n"
+            tag, lines = header.group(1), [line.strip()]
+        elif tag:
+            lines.append(line.rstrip())
+    if tag:
+        yield tag, "\n".join(lines).strip() + "\n"
+
+
+def record_id(block, where):
+    match = ID_LINE.search(block)
+    if not match:
+        sys.exit(f"{where}: block has no id= line")
+    record = int(match.group(1))
+    if not 0 < record < 65536:
+        sys.exit(f"{where}: id {record} out of range")
+    return record
+
+
+def read_source(path, records):
+    with open(path, "r", encoding="utf-8") as f:
+        text = f.read().replace("\r\n", "\n")
+
+    # A dungeon file is one record: [INFO] plus all of its [FLOORn] sections
+    if text.lstrip().startswith("[INFO]"):
+        info = next(block for tag, block in split_blocks(text) if tag == "INFO")
+        records[DUNGEON][record_id(info, path)] = text.strip() + "\n"
+        return 1
+
+    count = 0
+    for tag, block in split_blocks(text):
+        if tag not in TYPES or tag == "DUNGEON":
+            continue
+        if len(block.encode("utf-8")) >= PACK_RECORD_MAX:
+            sys.exit(f"{path}: [{tag}] record is over {PACK_RECORD_MAX - 1} bytes")
+        records[TYPES.index(tag)][record_id(block, path)] = block
+        count += 1
+    return count
+
+
+def collect(sources):
+    files = []
+    for source in sources:
+        if os.path.isdir(source):
+            for root, _, names in os.walk(source):
+                files += [os.path.join(root, n) for n in names if n.endswith(".txt")]
+        else:
+            files.append(source)
+    return sorted(files)
+
+
+def build_pack(records):
+    """Header, type table, per-type index, then the record bodies."""
+    header_size = 8 + 8 * len(TYPES)
+    index_size = 0
+    for by_id in records:
+        ids_bytes = 2 * len(by_id)
+        index_size += ((ids_bytes + 3) & ~3) + 4 * (len(by_id) + 1)
+
+    table, index, body = [], b"", b""
+    offset = header_size + index_size
+    for by_id in records:
+        ids = sorted(by_id)
+        table.append((len(ids), header_size + len(index)))
+        offsets = []
+        for record in ids:
+            data = by_id[record].encode("utf-8")
+            offsets.append(offset + len(body))
+            body += data
+        offsets.append(offset + len(body))
+
+        ids_bytes = struct.pack(f"<{len(ids)}H", *ids)
+        index += ids_bytes + b"\0" * (-len(ids_bytes) % 4)
+        index += struct.pack(f"<{len(offsets)}I", *offsets)
+
+    head = PACK_MAGIC + struct.pack("<HH", PACK_VERSION, len(TYPES))
+    for count, index_offset in table:
+        head += struct.pack("<II", count, index_offset)
+    assert len(head) == header_size and len(index) == index_size
+    return head + index + body
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Build a Mage's Descent .mdpak content pack")
+    parser.add_argument("sources", nargs="*", help=".txt files or folders (default: sd_card_files/rpg)")
+    parser.add_argument("-o", "--output", default=DEFAULT_OUTPUT, help="pack to write")
+    args = parser.parse_args()
+
+    records = [{} for _ in TYPES]
+    for path in collect(args.sources or DEFAULT_SOURCES):
+        count = read_source(path, records)
+        print(f"Read {os.path.relpath(path)}: {count} records")
+
+    pack = build_pack(records)
+    os.makedirs(os.path.dirname(os.path.abspath(args.output)), exist_ok=True)
+    with open(args.output, "wb") as f:
+        f.write(pack)
+
+    summary = ", ".join(f"{len(by_id)} {name.lower()}" for name, by_id in zip(TYPES, records))
+    print(f"\nWrote {args.output}: {len(pack)} bytes ({summary})")
+    print("Copy it to /rpg/packs/ on the SD card.")
+
+
+if __name__ == "__main__":
+    main()
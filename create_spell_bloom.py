@@ -0,0 +1,95 @@
+#!/usr/bin/env python3
+"""Build the spell check Bloom filter (spell.bloom) from the LEXICON dictionary.
+
+Usage: python create_spell_bloom.py <dict_dir> [output]
+
+<dict_dir> holds A.txt ... Z.txt in the LEXICON format ("Word (pos.) definition").
+Copy the output to /dict/spell.bloom on the SD card.
+
+File layout (little endian), must match src/spell_check.cpp:
+    uint32 magic    "PMBF"
+    uint16 version  1
+    uint8  k        probes per word
+    uint8  reserved
+    uint32 mBits    filter size in bits (multiple of 32)
+    uint32 nWords   headwords added
+    bits            mBits / 8 bytes, bit i = byte[i >> 3] & (1 << (i & 7))
+"""
+
+import os
+import re
+import struct
+import sys
+
+MAGIC = 0x46424D50  # "PMBF"
+VERSION = 1
+BITS_PER_WORD = 10  # ~1% false positives with K = 7
+K = 7
+
+WORD_RE = re.compile(r"^[a-z']+$")
+
+
+def fnv1a(word):
+    h = 2166136261
+    for b in word.encode("ascii"):
+        h ^= b
+        h = (h * 16777619) & 0xFFFFFFFF
+    return h
+
+
+def fmix32(h):
+    h ^= h >> 16
+    h = (h * 0x85EBCA6B) & 0xFFFFFFFF
+    h ^= h >> 13
+    h = (h * 0xC2B2AE35) & 0xFFFFFFFF
+    h ^= h >> 16
+    return h
+
+
+def probes(word, m_bits):
+    h1 = fnv1a(word)
+    h2 = fmix32(h1) | 1
+    for i in range(K):
+        yield ((h1 + i * h2) & 0xFFFFFFFF) % m_bits
+
+
+def headwords(dict_dir):
+    words = set()
+    for letter in "ABCDEFGHIJKLMNOPQRSTUVWXYZ":
+        path = os.path.join(dict_dir, letter + ".txt")
+        if not os.path.exists(path):
+            print(f"  missing {path}")
+            continue
+        with open(path, encoding="utf-8", errors="ignore") as f:
+            for line in f:
+                key = line.split("(", 1)[0].strip().lower()
+                for part in re.split(r"[\s\-]+", key):
+                    part = part.strip("'")
+                    if len(part) >= 2 and WORD_RE.match(part):
+                        words.add(part)
+    return words
+
+
+def main():
+    if len(sys.argv) < 2:
+        print(__doc__)
+        sys.exit(1)
+    dict_dir = sys.argv[1]
+    out_path = sys.argv[2] if len(sys.argv) > 2 else "spell.bloom"
+
+    words = headwords(dict_dir)
+    m_bits = max(8192, (len(words) * BITS_PER_WORD + 31) // 32 * 32)
+    bits = bytearray(m_bits // 8)
+    for w in words:
+        for i in probes(w, m_bits):
+            bits[i >> 3] |= 1 << (i & 7)
+
+    with open(out_path, "wb") as f:
+        f.write(struct.pack("<IHBBII", MAGIC, VERSION, K, 0, m_bits, len(words)))
+        f.write(bits)
+
+    print(f"Wrote {out_path}: {len(words)} words, {len(bits) // 1024} KB, k={K}")
+
+
+if __name__ == "__main__":
+    main()
@@ -1,13 +1,26 @@
 // ===================================================================== //
 // MAGE'S DESCENT - A Classic RPG for Pocket Mage PDA                    //
-// OTA APP VERSION - Game data embedded in flash, saves on SD card        //
+// OTA APP VERSION - Game data embedded in flash (plus SD content packs), //
+//                   saves on SD card                                    //
 // ===================================================================== //
 
 #include <globals.h>
 #include "esp32-hal-log.h"
 #include "esp_log.h"
+#include "esp_heap_caps.h"
 #include "rpg_data.h"
 #include "rpg_graphics.h"
+#include "glyph_cache.h"
+#include "io_session.h"
+#include "rpg_world.h"
+#include "rpg_tiles.h"
+#include "rpg_mapgen.h"
+#include "rpg_map.h"
+#include "rpg_fov.h"
+#include "rpg_path.h"
+#include "rpg_timeline.h"
+#include "rpg_alias.h"
+#include "rpg_pack.h"
 
 #include <Fonts/FreeMonoBold18pt8b.h>
 #include <Fonts/FreeMonoBold12pt8b.h>
@@ -41,19 +54,6 @@ enum GameState {
   GAME_STATUS
 };
 
-enum TileType : uint8_t {
-  TILE_WALL = 0,
-  TILE_FLOOR = 1,
-  TILE_DOOR = 2,
-  TILE_STAIRS_DOWN = 3,
-  TILE_STAIRS_UP = 4,
-  TILE_CHEST = 5,
-  TILE_NPC = 6,
-  TILE_TRAP = 7,
-  TILE_BOSS = 8,
-  TILE_ENTRANCE = 9
-};
-
 enum ItemType : uint8_t {
   ITYPE_CONSUMABLE = 0,
   ITYPE_WEAPON = 1,
@@ -87,7 +87,7 @@ struct Player {
   uint32_t gold;
   uint8_t dungeonId;
   uint8_t posX, posY;
-  uint8_t floorNum;
+  uint16_t floorNum;
   uint16_t equipWeapon;
   uint16_t equipArmor;
   uint16_t equipAccessory;
@@ -97,7 +97,8 @@ struct Player {
   uint16_t activeQuests[8];
   uint8_t questProgress[8];
   uint8_t questCount;
-  uint32_t worldFlags;
+  uint32_t worldSeed;      // generated floors derive from this
+  uint32_t playSeconds;
 };
 
 struct Enemy {
@@ -139,6 +140,7 @@ struct DungeonInfo {
   uint16_t enemyPool[8];
   uint8_t enemyPoolSize;
   uint16_t bossId;
+  bool endless;            // floors are generated, no bottom
 };
 
 struct Quest {
@@ -165,8 +167,20 @@ GameState previousState = GAME_TITLE;
 Player player;
 Enemy currentEnemy;
 DungeonInfo currentDungeon;
-uint8_t dungeonMap[192]; // 16x12 tiles
+ChunkMap dungeonMap;
+
+// Auto-travel destinations, each with a distance field built on first use
+// after a floor loads
+enum TravelTarget : uint8_t {
+  TRAVEL_STAIRS = 0,   // stairs down, once seen
+  TRAVEL_CHEST = 1,    // nearest seen, unopened chest
+  TRAVEL_EXIT = 2,     // entrance, by way of each floor's stairs up
+  TRAVEL_TARGETS
+};
+DistanceField travelFields[TRAVEL_TARGETS];
 bool einkNeedsRefresh = false;
+// Set while autoTravel() walks; the e-ink task holds its refresh until the end
+volatile bool travelling = false;
 
 // Combat state
 bool playerDefending = false;
@@ -216,6 +230,28 @@ bool graphicsLoaded = false;
 // Save slot selection
 int saveSlot = 1;
 
+// Save slot summaries. Every save file starts with a fixed-size SaveSummary
+// (the text body follows it) and /rpg/slots.idx holds one per slot, so the
+// load screen reads all of them with a single open and read.
+#define SAVE_SLOTS 3
+static constexpr uint32_t SAVE_SUMMARY_MAGIC = 0x53564D50; // "PMVS"
+static constexpr const char* SLOT_INDEX_PATH = "/rpg/slots.idx";
+
+struct SaveSummary {
+  uint32_t magic;        // SAVE_SUMMARY_MAGIC when the slot holds a save
+  char name[16];
+  char location[24];
+  uint32_t gold;
+  uint32_t playSeconds;
+  uint32_t savedAt;      // unix time
+  uint8_t level;
+  uint8_t floorNum;
+  uint8_t pad[2];
+};
+SaveSummary slotSummaries[SAVE_SLOTS];
+bool slotIndexLoaded = false;
+unsigned long playStartMillis = 0;
+
 // Timing
 int currentMillisKB = 0;
 int currentMillisOLED = 0;
@@ -411,15 +447,14 @@ int getBgmForState(GameState state) {
 
 // ===================== FILE HELPERS =====================
 
+// Sessions nest and share one clock raise, so back-to-back calls (e.g. the
+// three saveExists() checks on the load screen) cost no extra switching
 void sdBegin() {
-  SDActive = true;
-  pocketmage::setCpuSpeed(240);
-  delay(50);
+  IOSESSION().begin();
 }
 
 void sdEnd() {
-  if (SAVE_POWER) pocketmage::setCpuSpeed(POWER_SAVE_FREQ);
-  SDActive = false;
+  IOSESSION().end();
 }
 
 // Load a 320x240 1-bit graphic from embedded PROGMEM data
@@ -504,10 +539,19 @@ bool parseKV(const String& line, const char* key, String& outVal) {
 }
 
 // ===================== CONTENT LOADERS (from embedded PROGMEM) =====================
+// A mounted content pack's record wins over the embedded one: it is read into
+// buf and scanned like a one-block table.
+
+const char* contentSource(PackType type, uint16_t id, const char* embedded, char* buf, size_t cap) {
+  uint32_t len = PACKS().read(type, id, buf, cap);
+  if (len >= cap) ESP_LOGW(TAG, "Pack record %d/%d truncated", type, id);
+  return len > 0 ? buf : embedded;
+}
 
 bool loadEnemyById(uint16_t id, Enemy& out) {
+  char rec[PACK_RECORD_MAX];
   ProgmemReader r;
-  r.init(DATA_ENEMIES);
+  r.init(contentSource(PACK_ENEMY, id, DATA_ENEMIES, rec, sizeof(rec)));
 
   memset(&out, 0, sizeof(Enemy));
   bool inBlock = false;
@@ -547,8 +591,9 @@ bool loadEnemyById(uint16_t id, Enemy& out) {
 }
 
 bool loadItemById(uint16_t id, Item& out) {
+  char rec[PACK_RECORD_MAX];
   ProgmemReader r;
-  r.init(DATA_ITEMS);
+  r.init(contentSource(PACK_ITEM, id, DATA_ITEMS, rec, sizeof(rec)));
 
   memset(&out, 0, sizeof(Item));
   bool inBlock = false;
@@ -583,8 +628,9 @@ bool loadItemById(uint16_t id, Item& out) {
 }
 
 bool loadSpellById(uint16_t id, Spell& out) {
+  char rec[PACK_RECORD_MAX];
   ProgmemReader r;
-  r.init(DATA_SPELLS);
+  r.init(contentSource(PACK_SPELL, id, DATA_SPELLS, rec, sizeof(rec)));
 
   memset(&out, 0, sizeof(Spell));
   bool inBlock = false;
@@ -617,19 +663,48 @@ bool loadSpellById(uint16_t id, Spell& out) {
   return found;
 }
 
-// Helper to get the PROGMEM dungeon data for a given ID
-const char* getDungeonData(uint16_t id) {
+// Whole dungeon records from packs are read into one buffer (PSRAM when
+// there is some), kept until another pack dungeon is entered
+char* packDungeonText = nullptr;
+uint16_t packDungeonId = 0;
+
+const char* embeddedDungeonData(uint16_t id) {
   switch (id) {
     case 1: return DATA_DUNGEON_1;
     case 2: return DATA_DUNGEON_2;
     case 3: return DATA_DUNGEON_3;
     case 4: return DATA_DUNGEON_4;
+    case 5: return DATA_DUNGEON_5;
     default: return nullptr;
   }
 }
 
+// Helper to get the dungeon data for a given ID
+const char* getDungeonData(uint16_t id) {
+  uint32_t len = PACKS().size(PACK_DUNGEON, id);
+  if (len == 0) return embeddedDungeonData(id);
+  if (packDungeonText && packDungeonId == id) return packDungeonText;
+
+  free(packDungeonText);
+  packDungeonText = nullptr;
+  packDungeonId = 0;
+  char* buf = nullptr;
+  if (psramFound()) buf = (char*)heap_caps_malloc(len + 1, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+  if (!buf) buf = (char*)malloc(len + 1);
+  if (!buf || PACKS().read(PACK_DUNGEON, id, buf, len + 1) != len) {
+    ESP_LOGE(TAG, "Cannot load pack dungeon %d (%lu bytes)", id, (unsigned long)len);
+    free(buf);
+    return embeddedDungeonData(id);
+  }
+  packDungeonText = buf;
+  packDungeonId = id;
+  return buf;
+}
+
 bool loadDungeonInfo(uint16_t id, DungeonInfo& out) {
-  const char* data = getDungeonData(id);
+  // [INFO] comes first, so a pack dungeon's info needs only its opening bytes
+  char rec[PACK_RECORD_MAX * 2];
+  const char* data = PACKS().read(PACK_DUNGEON, id, rec, sizeof(rec)) ? rec : embeddedDungeonData(id);
   if (!data) return false;
 
   ProgmemReader r;
@@ -663,11 +738,204 @@ bool loadDungeonInfo(uint16_t id, DungeonInfo& out) {
       }
     }
     else if (parseKV(line, "bossId", val)) out.bossId = val.toInt();
+    else if (parseKV(line, "endless", val)) out.endless = val.toInt() != 0;
   }
   return (out.id > 0);
 }
 
-bool loadDungeonFloor(uint16_t dungeonId, uint8_t floor) {
+// ===================== WEIGHTED TABLES =====================
+// Encounters and chest loot are drawn from alias tables, one random value per
+// draw. A dungeon's [INFO] may weight its enemies by floor band:
+//   encounter=1-2|1:40,2:35,3:25     floors 1-2: id:weight pairs
+// The first band holding the floor wins; with none, the enemies= pool is
+// drawn evenly. The table is recompiled on every floor change. Chest loot
+// comes from DATA_LOOT, compiled once at start:
+//   [LOOT] floors=1-4, then drop=itemId,weight,minQty,maxQty (item 0 = gold)
+
+#define LOOT_MAX_BANDS 4
+
+struct LootDrop {
+  uint16_t itemId;         // 0 = gold
+  uint16_t minQty, maxQty;
+};
+
+struct LootBand {
+  uint16_t firstFloor, lastFloor;
+  LootDrop drops[ALIAS_MAX];
+  uint8_t dropCount;
+  AliasTable table;
+};
+
+AliasTable encounterTable;
+uint16_t encounterIds[ALIAS_MAX];
+LootBand lootBands[LOOT_MAX_BANDS];
+uint8_t lootBandCount = 0;
+
+// "a-b" or "a" into a floor range
+void parseFloorRange(const String& s, uint16_t& first, uint16_t& last) {
+  int dash = s.indexOf('-');
+  first = s.toInt();
+  last = dash > 0 ? s.substring(dash + 1).toInt() : first;
+}
+
+// Endless dungeons list their pool weakest first and open it up with depth
+int encounterPoolSize() {
+  if (!currentDungeon.endless) return currentDungeon.enemyPoolSize;
+  return min((int)currentDungeon.enemyPoolSize, 2 + player.floorNum / 3);
+}
+
+void compileEncounterTable(uint16_t floor) {
+  uint16_t weights[ALIAS_MAX];
+  int count = 0;
+
+  const char* data = getDungeonData(currentDungeon.id);
+  if (data) {
+    ProgmemReader r;
+    r.init(data);
+    bool inInfo = false;
+    String val;
+    while (r.available() && count == 0) {
+      String line = r.readLine();
+      line.trim();
+      if (line == "[INFO]") { inInfo = true; continue; }
+      if (line.startsWith("[") && inInfo) break;
+      if (!inInfo || !parseKV(line, "encounter", val)) continue;
+
+      int bar = val.indexOf('|');
+      uint16_t first, last;
+      parseFloorRange(val.substring(0, bar), first, last);
+      if (bar < 0 || floor < first || floor > last) continue;
+      const char* p = val.c_str() + bar + 1;
+      while (*p && count < ALIAS_MAX) {
+        char* end;
+        uint16_t id = strtoul(p, &end, 10);
+        if (end != p) {
+          encounterIds[count] = id;
+          weights[count] = *end == ':' ? strtoul(end + 1, &end, 10) : 1;
+          count++;
+        }
+        while (*end && *end != ',') end++;
+        p = *end ? end + 1 : end;
+      }
+    }
+  }
+
+  if (count == 0) {
+    count = min(encounterPoolSize(), ALIAS_MAX);
+    for (int i = 0; i < count; i++) {
+      encounterIds[i] = currentDungeon.enemyPool[i];
+      weights[i] = 1;
+    }
+  }
+  if (!encounterTable.build(weights, count)) {
+    ESP_LOGW(TAG, "No encounters on dungeon %d floor %d", currentDungeon.id, floor);
+  }
+}
+
+void loadLootTables() {
+  ProgmemReader r;
+  r.init(DATA_LOOT);
+
+  lootBandCount = 0;
+  LootBand* band = nullptr;
+  uint16_t weights[ALIAS_MAX];
+  String val;
+  auto finish = [&]() {
+    if (band && band->table.build(weights, band->dropCount)) lootBandCount++;
+    band = nullptr;
+  };
+
+  while (r.available()) {
+    String line = r.readLine();
+    line.trim();
+    if (line == "[LOOT]") {
+      finish();
+      if (lootBandCount < LOOT_MAX_BANDS) {
+        band = &lootBands[lootBandCount];
+        memset(band, 0, sizeof(LootBand));
+      }
+      continue;
+    }
+    if (!band) continue;
+    if (parseKV(line, "floors", val)) parseFloorRange(val, band->firstFloor, band->lastFloor);
+    else if (parseKV(line, "drop", val) && band->dropCount < ALIAS_MAX) {
+      LootDrop& d = band->drops[band->dropCount];
+      unsigned id = 0, weight = 0, lo = 0, hi = 0;
+      if (sscanf(val.c_str(), "%u,%u,%u,%u", &id, &weight, &lo, &hi) < 2) continue;
+      d.itemId = id;
+      d.minQty = lo;
+      d.maxQty = max(lo, hi);
+      weights[band->dropCount++] = weight;
+    }
+  }
+  finish();
+  ESP_LOGI(TAG, "%d loot bands", lootBandCount);
+}
+
+// ===================== FLOOR SOURCES =====================
+// The chunk map pulls 16x16 pieces of the current floor through these
+
+uint16_t mapDungeon = 0, mapFloor = 0;
+const char* floorText = nullptr;       // PROGMEM data holding the floor's map= rows
+uint32_t floorRows[MAP_MAX_SIDE];      // offset of each row's first tile
+uint8_t generatedFloor[DUNGEON_TILES];
+
+// Sprung traps and defeated bosses stay gone
+void applyWorldState(uint8_t cx, uint8_t cy, uint8_t* tiles) {
+  for (int y = 0; y < MAP_CHUNK; y++) {
+    for (int x = 0; x < MAP_CHUNK; x++) {
+      int gx = cx * MAP_CHUNK + x, gy = cy * MAP_CHUNK + y;
+      if (!dungeonMap.inside(gx, gy)) continue;
+      uint8_t& t = tiles[y * MAP_CHUNK + x];
+      uint16_t idx = dungeonMap.index(gx, gy);
+      if ((t == TILE_TRAP && WORLD().test(WORLD_TRAP, mapDungeon, mapFloor, idx)) ||
+          (t == TILE_BOSS && WORLD().test(WORLD_BOSS, mapDungeon, mapFloor, idx))) {
+        t = TILE_FLOOR;
+      }
+    }
+  }
+}
+
+void loadTextChunk(uint8_t cx, uint8_t cy, uint8_t* tiles) {
+  int x0 = cx * MAP_CHUNK;
+  for (int y = 0; y < MAP_CHUNK && cy * MAP_CHUNK + y < dungeonMap.height(); y++) {
+    const char* row = floorText + floorRows[cy * MAP_CHUNK + y];
+    // Rows may be shorter than the map; stop at the line end
+    for (int x = 0; x < x0 + MAP_CHUNK; x++) {
+      char c = pgm_read_byte(&row[x]);
+      if (c < '0' || c > '9') break;
+      if (x >= x0) tiles[y * MAP_CHUNK + x - x0] = c - '0';
+    }
+  }
+  applyWorldState(cx, cy, tiles);
+}
+
+void loadGeneratedChunk(uint8_t cx, uint8_t cy, uint8_t* tiles) {
+  if (cx != 0 || cy != 0) return;
+  for (int y = 0; y < DUNGEON_H; y++) memcpy(&tiles[y * MAP_CHUNK], &generatedFloor[y * DUNGEON_W], DUNGEON_W);
+  applyWorldState(cx, cy, tiles);
+}
+
+// Tiles whose position the map remembers for arrivals
+const uint8_t LANDMARK_TILES[3] = { TILE_ENTRANCE, TILE_STAIRS_UP, TILE_STAIRS_DOWN };
+
+bool loadDungeonFloor(uint16_t dungeonId, uint16_t floor) {
+  mapDungeon = dungeonId;
+  mapFloor = floor;
+  for (DistanceField& field : travelFields) field.invalidate();
+  compileEncounterTable(floor);
+
+  if (currentDungeon.id == dungeonId && currentDungeon.endless) {
+    generateFloor(floorSeed(player.worldSeed, dungeonId, floor), floor, generatedFloor);
+    dungeonMap.open(DUNGEON_W, DUNGEON_H, loadGeneratedChunk);
+    for (int i = 0; i < DUNGEON_TILES; i++) {
+      for (uint8_t t : LANDMARK_TILES) {
+        if (generatedFloor[i] == t) dungeonMap.setMark(t, i % DUNGEON_W, i / DUNGEON_W);
+      }
+    }
+    return true;
+  }
+
   const char* data = getDungeonData(dungeonId);
   if (!data) return false;
 
@@ -678,25 +946,36 @@ bool loadDungeonFloor(uint16_t dungeonId, uint8_t floor) {
   snprintf(sectionName, sizeof(sectionName), "[FLOOR%d]", floor);
   bool inSection = false;
   int mapRow = 0;
-  memset(dungeonMap, 0, 192);
+  int mapWidth = 0;
+  int landmarks[3] = { -1, -1, -1 };  // y << 8 | x per LANDMARK_TILES entry
 
+  // Only note where each row starts; chunks are read from flash on demand
   while (r.available()) {
+    int lineStart = r.pos;
     String line = r.readLine();
     line.trim();
     if (line == sectionName) { inSection = true; continue; }
     if (line.startsWith("[") && inSection) break;
     if (!inSection) continue;
 
-    if (line.startsWith("map=")) {
-      String mapLine = line.substring(4);
-      if (mapRow < 12) {
-        for (int x = 0; x < 16 && x < (int)mapLine.length(); x++) {
-          dungeonMap[mapRow * 16 + x] = mapLine[x] - '0';
+    if (line.startsWith("map=") && mapRow < MAP_MAX_SIDE) {
+      int len = min((int)line.length() - 4, MAP_MAX_SIDE);
+      for (int x = 0; x < len; x++) {
+        uint8_t t = line[4 + x] - '0';
+        for (int k = 0; k < 3; k++) {
+          if (t == LANDMARK_TILES[k]) landmarks[k] = (mapRow << 8) | x;
         }
-        mapRow++;
       }
+      floorRows[mapRow++] = lineStart + 4;
+      mapWidth = max(mapWidth, len);
     }
   }
+
+  floorText = data;
+  dungeonMap.open(mapWidth, mapRow, loadTextChunk);
+  for (int k = 0; k < 3; k++) {
+    if (landmarks[k] >= 0) dungeonMap.setMark(LANDMARK_TILES[k], landmarks[k] & 0xFF, landmarks[k] >> 8);
+  }
   return (mapRow > 0);
 }
 
@@ -722,8 +1001,9 @@ uint32_t getXpForLevel(uint8_t level) {
 
 // Load shop inventory
 int loadShopItems(int shopId) {
+  char rec[PACK_RECORD_MAX];
   ProgmemReader r;
-  r.init(DATA_SHOPS);
+  r.init(contentSource(PACK_SHOP, shopId, DATA_SHOPS, rec, sizeof(rec)));
 
   shopItemCount = 0;
   bool inBlock = false;
@@ -769,14 +1049,27 @@ void loadShopInventory(int shopId) {
   loadShopItems(shopId);
 }
 
+void parseQuestField(const String& line, Quest& out) {
+  String val;
+  if (parseKV(line, "id", val)) out.id = val.toInt();
+  else if (parseKV(line, "name", val)) strncpy(out.name, val.c_str(), 23);
+  else if (parseKV(line, "desc", val)) strncpy(out.desc, val.c_str(), 63);
+  else if (parseKV(line, "type", val)) out.type = val.toInt();
+  else if (parseKV(line, "target", val)) out.targetId = val.toInt();
+  else if (parseKV(line, "count", val)) out.targetCount = val.toInt();
+  else if (parseKV(line, "gold", val)) out.rewardGold = val.toInt();
+  else if (parseKV(line, "item", val)) out.rewardItemId = val.toInt();
+  else if (parseKV(line, "xp", val)) out.rewardXp = val.toInt();
+}
+
 bool loadQuestById(uint16_t id, Quest& out) {
+  char rec[PACK_RECORD_MAX];
   ProgmemReader r;
-  r.init(DATA_QUESTS);
+  r.init(contentSource(PACK_QUEST, id, DATA_QUESTS, rec, sizeof(rec)));
 
   memset(&out, 0, sizeof(Quest));
   bool inBlock = false;
   bool found = false;
-  String val;
 
   while (r.available()) {
     String line = r.readLine();
@@ -793,31 +1086,218 @@ bool loadQuestById(uint16_t id, Quest& out) {
       inBlock = false;
       continue;
     }
-    if (parseKV(line, "id", val)) out.id = val.toInt();
-    else if (parseKV(line, "name", val)) strncpy(out.name, val.c_str(), 23);
-    else if (parseKV(line, "desc", val)) strncpy(out.desc, val.c_str(), 63);
-    else if (parseKV(line, "type", val)) out.type = val.toInt();
-    else if (parseKV(line, "target", val)) out.targetId = val.toInt();
-    else if (parseKV(line, "count", val)) out.targetCount = val.toInt();
-    else if (parseKV(line, "gold", val)) out.rewardGold = val.toInt();
-    else if (parseKV(line, "item", val)) out.rewardItemId = val.toInt();
-    else if (parseKV(line, "xp", val)) out.rewardXp = val.toInt();
+    parseQuestField(line, out);
   }
   if (inBlock && out.id == id) found = true;
   return found;
 }
 
+// Every quest with an id in [firstId, lastId], in one pass; returns how many
+int loadQuestRange(uint16_t firstId, uint16_t lastId, Quest* out, int maxOut) {
+  ProgmemReader r;
+  r.init(DATA_QUESTS);
+
+  int n = 0;
+  bool inBlock = false;
+  Quest q;
+  auto keep = [&]() {
+    if (inBlock && n < maxOut && q.id >= firstId && q.id <= lastId) out[n++] = q;
+  };
+
+  while (r.available() && n < maxOut) {
+    String line = r.readLine();
+    line.trim();
+    if (line.startsWith("[")) {
+      keep();
+      inBlock = line == "[QUEST]";
+      memset(&q, 0, sizeof(Quest));
+      continue;
+    }
+    if (inBlock) parseQuestField(line, q);
+  }
+  keep();
+
+  // Packs add or replace ids; only those cost an indexed read each
+  std::vector<uint16_t> packIds;
+  if (PACKS().mounted() > 0) PACKS().ids(PACK_QUEST, packIds);
+  for (uint16_t id : packIds) {
+    if (id < firstId || id > lastId) continue;
+    int i = 0;
+    while (i < n && out[i].id < id) i++;
+    if (i >= maxOut || !loadQuestById(id, q)) continue;
+    if (i < n && out[i].id == id) {
+      out[i] = q;
+      continue;
+    }
+    // Keep the page in id order; the last entry drops off a full page
+    for (int j = min(n, maxOut - 1); j > i; j--) out[j] = out[j - 1];
+    out[i] = q;
+    n = min(n + 1, maxOut);
+  }
+  return n;
+}
+
+// ===================== QUEST INDEX =====================
+// What each active quest slot needs, so a victory is a table lookup rather
+// than a parse of every active quest, and the board and OLED know which
+// quests are ready to turn in. Rebuilt whenever the active list changes.
+
+struct QuestKillEntry {
+  uint16_t enemyId;
+  uint8_t slots;           // bit i = player.activeQuests[i] counts this enemy
+};
+
+QuestKillEntry questKills[8];
+uint8_t questKillCount = 0;
+uint8_t questTarget[8];    // kills (or items) needed, per slot
+bool questReady[8];        // progress has reached the target
+
+void rebuildQuestIndex() {
+  questKillCount = 0;
+  for (int i = 0; i < player.questCount; i++) {
+    Quest q;
+    if (!loadQuestById(player.activeQuests[i], q)) {
+      // Unknown quest: never completes
+      questTarget[i] = UINT8_MAX;
+      questReady[i] = false;
+      continue;
+    }
+    questTarget[i] = q.targetCount;
+    questReady[i] = player.questProgress[i] >= q.targetCount;
+    if (q.type != 0) continue;
+
+    int k = 0;
+    while (k < questKillCount && questKills[k].enemyId != q.targetId) k++;
+    if (k == questKillCount) {
+      questKills[questKillCount++] = { q.targetId, 0 };
+    }
+    questKills[k].slots |= 1 << i;
+  }
+}
+
+uint8_t questSlotsForKill(uint16_t enemyId) {
+  for (int k = 0; k < questKillCount; k++) {
+    if (questKills[k].enemyId == enemyId) return questKills[k].slots;
+  }
+  return 0;
+}
+
 // ===================== SAVE / LOAD =====================
 
+const char* dungeonNameFor(uint16_t id) {
+  for (int i = 0; i < dungeonCount; i++) {
+    if (dungeonList[i].id == id) return dungeonList[i].name;
+  }
+  return "Dungeon";
+}
+
+// Fold the time since the last save/load into the player's play time
+void updatePlayTime() {
+  unsigned long now = millis();
+  player.playSeconds += (now - playStartMillis) / 1000;
+  playStartMillis = now - (now - playStartMillis) % 1000;
+}
+
+void fillSaveSummary(SaveSummary& s) {
+  memset(&s, 0, sizeof(s));
+  s.magic = SAVE_SUMMARY_MAGIC;
+  strncpy(s.name, player.name, sizeof(s.name) - 1);
+  strncpy(s.location, player.dungeonId ? dungeonNameFor(player.dungeonId) : "Town", sizeof(s.location) - 1);
+  s.gold = player.gold;
+  s.playSeconds = player.playSeconds;
+  s.savedAt = CLOCK().nowDT().unixtime();
+  s.level = player.level;
+  s.floorNum = player.dungeonId ? min((int)player.floorNum, 255) : 0;
+}
+
+// Summary for one slot straight from its save file. Saves written before the
+// header existed get one built from their [PLAYER] section. Call inside sdBegin().
+bool readSaveSummary(int slot, SaveSummary& s) {
+  char path[24];
+  snprintf(path, sizeof(path), "/rpg/save%d.dat", slot);
+  memset(&s, 0, sizeof(s));
+  File f = SD_MMC.open(path, "r");
+  if (!f) return false;
+
+  if (f.read((uint8_t*)&s, sizeof(s)) == sizeof(s) && s.magic == SAVE_SUMMARY_MAGIC) {
+    f.close();
+    return true;
+  }
+
+  memset(&s, 0, sizeof(s));
+  s.magic = SAVE_SUMMARY_MAGIC;
+  strcpy(s.location, "Town");
+  f.seek(0);
+  String val;
+  while (f.available()) {
+    String line = f.readStringUntil('\n');
+    line.trim();
+    if (line == "[INVENTORY]") break;
+    if (parseKV(line, "name", val)) strncpy(s.name, val.c_str(), sizeof(s.name) - 1);
+    else if (parseKV(line, "level", val)) s.level = val.toInt();
+    else if (parseKV(line, "gold", val)) s.gold = val.toInt();
+    else if (parseKV(line, "floor", val)) s.floorNum = val.toInt();
+    else if (parseKV(line, "dungeon", val) && val.toInt() != 0) {
+      strncpy(s.location, dungeonNameFor(val.toInt()), sizeof(s.location) - 1);
+    }
+  }
+  if (strcmp(s.location, "Town") == 0) s.floorNum = 0;
+  s.savedAt = f.getLastWrite();
+  f.close();
+  return true;
+}
+
+// Call inside sdBegin()
+void writeSlotIndex() {
+  File f = SD_MMC.open(SLOT_INDEX_PATH, "w");
+  if (!f) {
+    ESP_LOGE(TAG, "Failed to write %s", SLOT_INDEX_PATH);
+    return;
+  }
+  f.write((const uint8_t*)slotSummaries, sizeof(slotSummaries));
+  f.close();
+}
+
+// Fill slotSummaries once per run: one read of slots.idx, or a rebuild from
+// the save files if the index is missing or from another version
+void loadSlotIndex() {
+  if (slotIndexLoaded) return;
+  slotIndexLoaded = true;
+
+  sdBegin();
+  File f = SD_MMC.open(SLOT_INDEX_PATH, "r");
+  bool ok = f && f.size() == sizeof(slotSummaries) &&
+            f.read((uint8_t*)slotSummaries, sizeof(slotSummaries)) == sizeof(slotSummaries);
+  if (f) f.close();
+  for (int i = 0; ok && i < SAVE_SLOTS; i++) {
+    if (slotSummaries[i].magic != 0 && slotSummaries[i].magic != SAVE_SUMMARY_MAGIC) ok = false;
+  }
+
+  if (!ok) {
+    ESP_LOGI(TAG, "Rebuilding %s", SLOT_INDEX_PATH);
+    for (int i = 0; i < SAVE_SLOTS; i++) readSaveSummary(i + 1, slotSummaries[i]);
+    writeSlotIndex();
+  }
+  sdEnd();
+}
+
 void saveGame(int slot) {
   char path[24];
   snprintf(path, sizeof(path), "/rpg/save%d.dat", slot);
+  loadSlotIndex();
+  updatePlayTime();
+
+  SaveSummary summary;
+  fillSaveSummary(summary);
+
   sdBegin();
   SD_MMC.remove(path);
 
   File f = SD_MMC.open(path, "w");
   if (!f) { sdEnd(); return; }
 
+  f.write((const uint8_t*)&summary, sizeof(summary));
+  f.println();
   f.println("[PLAYER]");
   f.println("name=" + String(player.name));
   f.println("hp=" + String(player.hp));
@@ -839,6 +1319,8 @@ void saveGame(int slot) {
   f.println("weapon=" + String(player.equipWeapon));
   f.println("armor=" + String(player.equipArmor));
   f.println("accessory=" + String(player.equipAccessory));
+  f.println("playtime=" + String(player.playSeconds));
+  f.println("seed=" + String(player.worldSeed));
 
   f.println("[INVENTORY]");
   for (int i = 0; i < player.invCount; i++) {
@@ -850,10 +1332,16 @@ void saveGame(int slot) {
     f.println(String(player.activeQuests[i]) + "=" + String(player.questProgress[i]));
   }
 
-  f.println("[FLAGS]");
-  f.println("worldFlags=" + String(player.worldFlags));
+  f.println("[WORLD]");
+  WORLD().save(f);
 
   f.close();
+
+  // The index is only written after the save itself is complete
+  if (slot >= 1 && slot <= SAVE_SLOTS) {
+    slotSummaries[slot - 1] = summary;
+    writeSlotIndex();
+  }
   sdEnd();
   setOledMsg("Game Saved!");
   ESP_LOGI(TAG, "Saved to slot %d", slot);
@@ -866,7 +1354,15 @@ bool loadGame(int slot) {
   File f = SD_MMC.open(path, "r");
   if (!f) { sdEnd(); return false; }
 
+  // Skip the summary header; older saves start directly with the text
+  SaveSummary summary;
+  if (f.read((uint8_t*)&summary, sizeof(summary)) != sizeof(summary) ||
+      summary.magic != SAVE_SUMMARY_MAGIC) {
+    f.seek(0);
+  }
+
   memset(&player, 0, sizeof(Player));
+  WORLD().clear();
   String section = "";
   String val;
 
@@ -896,6 +1392,8 @@ bool loadGame(int slot) {
       else if (parseKV(line, "weapon", val)) player.equipWeapon = val.toInt();
       else if (parseKV(line, "armor", val)) player.equipArmor = val.toInt();
       else if (parseKV(line, "accessory", val)) player.equipAccessory = val.toInt();
+      else if (parseKV(line, "playtime", val)) player.playSeconds = strtoul(val.c_str(), NULL, 10);
+      else if (parseKV(line, "seed", val)) player.worldSeed = strtoul(val.c_str(), NULL, 10);
     }
     else if (section == "[INVENTORY]") {
       int eq = line.indexOf('=');
@@ -913,29 +1411,40 @@ bool loadGame(int slot) {
         player.questCount++;
       }
     }
+    else if (section == "[WORLD]") {
+      if (line.length() > 0) WORLD().parse(line);
+    }
     else if (section == "[FLAGS]") {
-      if (parseKV(line, "worldFlags", val)) player.worldFlags = strtoul(val.c_str(), NULL, 10);
+      // Pre-[WORLD] saves kept chests in one 32-bit word keyed by floor and
+      // row only; it cannot be mapped onto tiles, so those chests refill
+      if (parseKV(line, "worldFlags", val) && val.toInt() != 0) {
+        ESP_LOGW(TAG, "Dropping legacy chest flags %s", val.c_str());
+      }
     }
   }
   f.close();
   sdEnd();
+  // Saves from before generated floors get their seed now; it is kept from the next save on
+  if (player.worldSeed == 0) player.worldSeed = esp_random();
+  rebuildQuestIndex();
+  playStartMillis = millis();
   setOledMsg("Game Loaded!");
   return true;
 }
 
+// Answered from the slot index; no SD access once it is loaded
 bool saveExists(int slot) {
-  char path[24];
-  snprintf(path, sizeof(path), "/rpg/save%d.dat", slot);
-  sdBegin();
-  bool exists = SD_MMC.exists(path);
-  sdEnd();
-  return exists;
+  if (slot < 1 || slot > SAVE_SLOTS) return false;
+  loadSlotIndex();
+  return slotSummaries[slot - 1].magic == SAVE_SUMMARY_MAGIC;
 }
 
 // ===================== NEW GAME SETUP =====================
 
 void initNewGame() {
   memset(&player, 0, sizeof(Player));
+  WORLD().clear();
+  rebuildQuestIndex();
   strncpy(player.name, "Arlen", 15);
   player.hp = 30; player.maxHp = 30;
   player.mp = 10; player.maxMp = 10;
@@ -946,6 +1455,8 @@ void initNewGame() {
   player.xpNext = getXpForLevel(2);
   player.gold = 50;
   player.dungeonId = 0;
+  player.worldSeed = esp_random();
+  playStartMillis = millis();
   // Start with an herb
   player.invId[0] = 1; // Herb
   player.invQty[0] = 3;
@@ -955,10 +1466,22 @@ void initNewGame() {
 // ===================== DUNGEON SCANNING =====================
 
 void scanDungeonFiles() {
+  // Embedded dungeons (a pack may replace them), then new ids from packs
+  std::vector<uint16_t> ids, packIds;
+  for (int i = 1; i <= EMBEDDED_DUNGEON_COUNT; i++) ids.push_back(i);
+  PACKS().ids(PACK_DUNGEON, packIds);
+  for (uint16_t id : packIds) {
+    if (id > EMBEDDED_DUNGEON_COUNT) ids.push_back(id);
+  }
+
   dungeonCount = 0;
-  for (int i = 1; i <= EMBEDDED_DUNGEON_COUNT; i++) {
+  for (uint16_t id : ids) {
+    if (dungeonCount >= 9) {
+      ESP_LOGW(TAG, "Dungeon list full; %d dungeons not shown", (int)ids.size() - 9);
+      break;
+    }
     DungeonInfo info;
-    if (loadDungeonInfo(i, info)) {
+    if (loadDungeonInfo(id, info)) {
       dungeonList[dungeonCount].id = info.id;
       strncpy(dungeonList[dungeonCount].name, info.name, 23);
       dungeonList[dungeonCount].minLevel = info.minLevel;
@@ -1075,10 +1598,34 @@ void startCombat(uint16_t enemyId) {
   setOledMsg("Encounter!");
 }
 
+// Fill in the chest: treasureItemId/Qty for the result screen, gold paid now
+void rollChestLoot() {
+  treasureItemId = 0;
+  treasureQty = 0;
+  if (lootBandCount == 0) return;
+  // Past the listed bands, the last band's loot
+  const LootBand* band = &lootBands[lootBandCount - 1];
+  for (int i = 0; i < lootBandCount; i++) {
+    if (player.floorNum >= lootBands[i].firstFloor && player.floorNum <= lootBands[i].lastFloor) {
+      band = &lootBands[i];
+      break;
+    }
+  }
+
+  const LootDrop& d = band->drops[band->table.pick(esp_random())];
+  uint16_t qty = d.minQty + random(d.maxQty - d.minQty + 1);
+  if (d.itemId == 0) {
+    player.gold += qty;
+  } else {
+    treasureItemId = d.itemId;
+    treasureQty = qty;
+    addItem(treasureItemId, treasureQty);
+  }
+}
+
 void rollEncounter() {
-  if (random(100) < currentDungeon.encounterRate) {
-    int idx = random(currentDungeon.enemyPoolSize);
-    startCombat(currentDungeon.enemyPool[idx]);
+  if (random(100) < currentDungeon.encounterRate && encounterTable.size() > 0) {
+    startCombat(encounterIds[encounterTable.pick(esp_random())]);
   }
 }
 
@@ -1109,36 +1656,288 @@ bool checkLevelUp() {
 
 // Check quest progress after killing an enemy
 void checkQuestKill(uint16_t enemyId) {
-  for (int i = 0; i < player.questCount; i++) {
-    Quest q;
-    if (loadQuestById(player.activeQuests[i], q)) {
-      if (q.type == 0 && q.targetId == enemyId) {
-        if (player.questProgress[i] < q.targetCount) {
-          player.questProgress[i]++;
-        }
+  uint8_t slots = questSlotsForKill(enemyId);
+  for (int i = 0; slots; i++, slots >>= 1) {
+    if (!(slots & 1) || questReady[i]) continue;
+    player.questProgress[i]++;
+    if (player.questProgress[i] >= questTarget[i]) {
+      questReady[i] = true;
+      setOledMsg("Quest ready to turn in!");
+    }
+  }
+}
+
+// World state of a tile on the current floor
+bool isTileFlagged(WorldFlag kind, uint16_t tile) {
+  return WORLD().test(kind, player.dungeonId, player.floorNum, tile);
+}
+
+void setTileFlag(WorldFlag kind, uint16_t tile) {
+  WORLD().set(kind, player.dungeonId, player.floorNum, tile);
+}
+
+// Player moves; each sets combatMsg
+void playerAttack() {
+  playerDefending = false;
+  int dmg = calcPlayerDamage();
+  currentEnemy.hp = max(0, currentEnemy.hp - dmg);
+  snprintf(combatMsg, sizeof(combatMsg), "Hit %s for %d!", currentEnemy.name, dmg);
+}
+
+// Caller checks the MP cost
+void castSpell(const Spell& spell) {
+  playerDefending = false;
+  player.mp -= spell.mpCost;
+  if (spell.type == STYPE_DAMAGE) {
+    int dmg = calcMagicDamage(spell.power);
+    currentEnemy.hp = max(0, currentEnemy.hp - dmg);
+    snprintf(combatMsg, sizeof(combatMsg), "%s! %d dmg!", spell.name, dmg);
+  }
+  else if (spell.type == STYPE_HEAL) {
+    int heal = spell.power + player.mag / 2;
+    player.hp = min((int)player.maxHp, player.hp + heal);
+    snprintf(combatMsg, sizeof(combatMsg), "%s! +%d HP!", spell.name, heal);
+  }
+  else if (spell.type == STYPE_BUFF) {
+    // Temporary defense buff
+    player.def += spell.power;
+    snprintf(combatMsg, sizeof(combatMsg), "%s! DEF+%d!", spell.name, spell.power);
+  }
+  else if (spell.type == STYPE_DEBUFF) {
+    // Reduce enemy defense
+    int reduction = min((int)spell.power, (int)currentEnemy.def);
+    currentEnemy.def -= reduction;
+    snprintf(combatMsg, sizeof(combatMsg), "%s! DEF-%d!", spell.name, reduction);
+  }
+}
+
+void useCombatItem(const Item& item) {
+  playerDefending = false;
+  if (item.stat1 > 0) player.hp = min((int)player.maxHp, player.hp + item.stat1);
+  if (item.stat2 > 0) player.mp = min((int)player.maxMp, player.mp + item.stat2);
+  removeItem(item.id, 1);
+  snprintf(combatMsg, sizeof(combatMsg), "Used %s!", item.name);
+}
+
+// Enemy defeated: rewards, quest progress, then the result screen
+void winCombat() {
+  combatVictory = true;
+  combatXpGain = currentEnemy.xpReward;
+  combatGoldGain = currentEnemy.goldReward;
+  combatDropId = 0;
+  if (random(100) < currentEnemy.dropChance && currentEnemy.dropItemId > 0) {
+    combatDropId = currentEnemy.dropItemId;
+  }
+  player.xp += combatXpGain;
+  player.gold += combatGoldGain;
+  if (combatDropId > 0) addItem(combatDropId, 1);
+  checkQuestKill(currentEnemy.id);
+  // A boss is fought by stepping onto its tile; once beaten it stays gone
+  if (previousState == GAME_DUNGEON && dungeonMap.tile(player.posX, player.posY) == TILE_BOSS) {
+    setTileFlag(WORLD_BOSS, dungeonMap.index(player.posX, player.posY));
+    dungeonMap.setTile(player.posX, player.posY, TILE_FLOOR);
+  }
+  playJingleWithBgm(VictoryJingle);
+  gameState = GAME_COMBAT_RESULT;
+  newState = true;
+  einkNeedsRefresh = true;
+}
+
+// The enemy's move this turn; sets combatMsg and returns the damage dealt
+int enemyTurnDamage() {
+  int eDmg;
+  if (currentEnemy.aiType == AI_BOSS) {
+    int roll = random(100);
+    if (roll < 30 && currentEnemy.mag > 0) {
+      // Magic blast
+      eDmg = currentEnemy.mag + random(2, 6) - (player.def / 3);
+      eDmg = max(2, eDmg);
+      if (playerDefending) eDmg /= 2;
+      snprintf(combatMsg, sizeof(combatMsg), "%s blasts! %d!", currentEnemy.name, eDmg);
+    } else if (roll < 50) {
+      // Heavy strike (1.5x ATK)
+      eDmg = (currentEnemy.atk * 3 / 2) - player.def + random(-1, 3);
+      eDmg = max(2, eDmg);
+      if (playerDefending) eDmg /= 2;
+      snprintf(combatMsg, sizeof(combatMsg), "%s SMASH! %d!", currentEnemy.name, eDmg);
+    } else {
+      eDmg = calcEnemyDamage();
+      snprintf(combatMsg, sizeof(combatMsg), "%s hits! %d dmg!", currentEnemy.name, eDmg);
+    }
+  }
+  else if (currentEnemy.aiType == AI_MAGIC && random(100) < 50) {
+    eDmg = currentEnemy.mag + random(-1, 3) - (player.def / 2);
+    eDmg = max(1, eDmg);
+    if (playerDefending) eDmg /= 2;
+    snprintf(combatMsg, sizeof(combatMsg), "%s casts! %d dmg!", currentEnemy.name, eDmg);
+  }
+  else if (currentEnemy.aiType == AI_DEFENSIVE && random(100) < 30) {
+    enemyDefending = true;
+    snprintf(combatMsg, sizeof(combatMsg), "%s defends!", currentEnemy.name);
+    eDmg = 0;
+  }
+  else {
+    eDmg = calcEnemyDamage();
+    snprintf(combatMsg, sizeof(combatMsg), "%s hits! %d dmg!", currentEnemy.name, eDmg);
+  }
+  return eDmg;
+}
+
+// ===================== TURN PACING =====================
+// The player's move shows on the OLED for COMBAT_PLAYER_MSG_MS, the enemy's
+// for COMBAT_ENEMY_MSG_MS, then the e-ink redraws the menu. Both waits run on
+// the timeline; a key press skips ahead.
+
+#define COMBAT_PLAYER_MSG_MS  600
+#define COMBAT_ENEMY_MSG_MS   800
+
+void endEnemyTurn() {
+  if (player.hp <= 0) {
+    playJingleWithBgm(DefeatJingle);
+    gameState = GAME_GAME_OVER;
+    newState = true;
+  } else {
+    combatTurnPhase = 0;
+    playerDefending = false;
+  }
+  einkNeedsRefresh = true;
+}
+
+void enemyTurn() {
+  if (currentEnemy.hp <= 0) {
+    winCombat();
+    return;
+  }
+  int eDmg = enemyTurnDamage();
+  if (eDmg > 0) {
+    player.hp = max(0, (int)player.hp - eDmg);
+    playJingleWithBgm(HitJingle);
+  }
+  setOledMsg(combatMsg);
+  TIMELINE().after(COMBAT_ENEMY_MSG_MS, endEnemyTurn);
+}
+
+// The player has acted and combatMsg says how; the enemy answers after a beat
+void queueEnemyTurn() {
+  combatTurnPhase = 2;
+  TIMELINE().say(0, combatMsg);
+  // Show the player's move (enemy HP drop) before the enemy acts
+  einkNeedsRefresh = true;
+  TIMELINE().after(COMBAT_PLAYER_MSG_MS, enemyTurn);
+}
+
+// ===================== AUTO-BATTLE =====================
+// Plays the fight out with the normal damage rules and a fixed policy: heal
+// below AUTO_BATTLE_HEAL_PCT of max HP, cast the strongest damage spell when
+// it beats a weapon hit by half again and still leaves MP for a heal,
+// otherwise attack. Each half-turn is logged to the OLED only; the e-ink is
+// redrawn once, when the fight ends or control is handed back. Any key stops.
+
+#define AUTO_BATTLE_STEP_MS    350
+#define AUTO_BATTLE_HEAL_PCT   35
+#define AUTO_BATTLE_MAX_TURNS  60
+
+bool autoBattle = false;
+unsigned long autoBattleMillis = 0;
+int autoBattleTurns = 0;
+Spell autoHealSpell;     // best unlocked spells, id 0 if none
+Spell autoDamageSpell;
+
+void startAutoBattle() {
+  memset(&autoHealSpell, 0, sizeof(Spell));
+  memset(&autoDamageSpell, 0, sizeof(Spell));
+  Spell spell;
+  for (uint16_t id = 1; loadSpellById(id, spell); id++) {
+    if (spell.unlockLevel > player.level) continue;
+    if (spell.type == STYPE_HEAL && spell.power > autoHealSpell.power) autoHealSpell = spell;
+    else if (spell.type == STYPE_DAMAGE && spell.power > autoDamageSpell.power) autoDamageSpell = spell;
+  }
+  autoBattle = true;
+  autoBattleTurns = 0;
+  autoBattleMillis = millis();
+  setOledMsg("Auto-battle! Any key stops");
+}
+
+// Player's half of an auto turn; sets combatMsg
+void autoPlayerTurn() {
+  if (player.hp * 100 < player.maxHp * AUTO_BATTLE_HEAL_PCT) {
+    if (autoHealSpell.id && player.mp >= autoHealSpell.mpCost) {
+      castSpell(autoHealSpell);
+      return;
+    }
+    for (int i = 0; i < player.invCount; i++) {
+      Item item;
+      if (loadItemById(player.invId[i], item) && item.type == ITYPE_CONSUMABLE && item.stat1 > 0) {
+        useCombatItem(item);
+        return;
       }
     }
   }
+
+  int reserve = autoHealSpell.id ? autoHealSpell.mpCost : 0;
+  if (autoDamageSpell.id && player.mp >= autoDamageSpell.mpCost + reserve) {
+    // Expected damage, without the random spread
+    int spellDmg = autoDamageSpell.power + player.mag + getAccessoryBonus() - currentEnemy.def / 2;
+    int hitDmg = max(1, player.atk + getWeaponBonus() - currentEnemy.def);
+    if (spellDmg * 2 >= hitDmg * 3) {
+      castSpell(autoDamageSpell);
+      return;
+    }
+  }
+  playerAttack();
 }
 
-// Check if a chest flag is set
-bool isChestOpened(uint8_t chestIdx) {
-  return (player.worldFlags >> chestIdx) & 1;
+// Run the next half-turn (player, then enemy); ends auto-battle with the fight
+void autoBattleStep() {
+  if (combatTurnPhase == 0) {
+    autoPlayerTurn();
+    setOledMsg(combatMsg);
+    combatTurnPhase = 2;
+    return;
+  }
+
+  if (currentEnemy.hp <= 0) {
+    autoBattle = false;
+    winCombat();
+    return;
+  }
+  int eDmg = enemyTurnDamage();
+  if (eDmg > 0) player.hp = max(0, (int)player.hp - eDmg);
+  setOledMsg(combatMsg);
+  combatTurnPhase = 0;
+  playerDefending = false;
+
+  if (player.hp <= 0) {
+    autoBattle = false;
+    playJingleWithBgm(DefeatJingle);
+    gameState = GAME_GAME_OVER;
+    newState = true;
+    einkNeedsRefresh = true;
+  }
+  else if (++autoBattleTurns >= AUTO_BATTLE_MAX_TURNS) {
+    autoBattle = false;
+    einkNeedsRefresh = true;
+  }
 }
 
-void setChestOpened(uint8_t chestIdx) {
-  player.worldFlags |= (1UL << chestIdx);
+// Hand control back at the start of the player's turn
+void stopAutoBattle() {
+  if (combatTurnPhase == 2) autoBattleStep();
+  if (!autoBattle) return;
+  autoBattle = false;
+  setOledMsg("Auto-battle off");
+  einkNeedsRefresh = true;
 }
 
 // ===================== DRAWING HELPERS =====================
 
 void drawCentered(const char* text, int y, const GFXfont* font) {
-  display.setFont(font);
+  GLYPHS().setFont(font);
   int16_t x1, y1;
   uint16_t w, h;
-  display.getTextBounds(text, 0, 0, &x1, &y1, &w, &h);
+  GLYPHS().getTextBounds(text, 0, 0, &x1, &y1, &w, &h);
   display.setCursor((320 - w) / 2, y);
-  display.print(text);
+  GLYPHS().print(text);
 }
 
 // Clear a rectangular area to white (for text over graphics)
@@ -1154,71 +1953,292 @@ void drawHpBar(int x, int y, int w, int h, int current, int maximum) {
   }
 }
 
-// Draw the dungeon tile map
-void drawDungeonMap() {
+// ===================== FOG OF WAR =====================
+// Tiles are drawn once explored; the player sees FOV_RADIUS tiles around them
+// past anything but walls. Tiles revealed by a step are queued so the next
+// redraw only touches them and the player's old and new tile. The keyboard
+// task fills the queue while the e-ink task may be drawing, so the e-ink task
+// takes it over whole under revealLock.
+
+uint16_t revealedTiles[FOV_MAX_TILES];
+int revealedCount = 0;
+bool mapFullRedraw = true;
+SemaphoreHandle_t revealLock = xSemaphoreCreateMutex();
+uint8_t drawnPlayerX = 0, drawnPlayerY = 0;
+uint16_t drawnFloor = 0;
+
+bool fovOpaque(int x, int y) {
+  return dungeonMap.tile(x, y) == TILE_WALL;
+}
+
+void fovReveal(int x, int y) {
+  if (!dungeonMap.inside(x, y)) return;
+  uint16_t idx = dungeonMap.index(x, y);
+  if (isTileFlagged(WORLD_SEEN, idx)) return;
+  setTileFlag(WORLD_SEEN, idx);
+  // Newly seen goals change where travel leads
+  uint8_t tile = dungeonMap.tile(x, y);
+  if (tile == TILE_CHEST) travelFields[TRAVEL_CHEST].invalidate();
+  else if (tile == TILE_STAIRS_DOWN) travelFields[TRAVEL_STAIRS].invalidate();
+  xSemaphoreTake(revealLock, portMAX_DELAY);
+  if (revealedCount < FOV_MAX_TILES) revealedTiles[revealedCount++] = idx;
+  else mapFullRedraw = true;
+  xSemaphoreGive(revealLock);
+}
+
+// Move the queued tiles into out and empty the queue; true if the queue
+// overflowed since the last take and the map needs a full redraw
+bool takeRevealed(uint16_t* out, int& count) {
+  xSemaphoreTake(revealLock, portMAX_DELAY);
+  count = revealedCount;
+  memcpy(out, revealedTiles, count * sizeof(uint16_t));
+  bool full = mapFullRedraw;
+  revealedCount = 0;
+  mapFullRedraw = false;
+  xSemaphoreGive(revealLock);
+  return full;
+}
+
+// Call after the player moved or arrived on a floor
+void updateVisibility() {
+  computeFov(player.posX, player.posY, fovOpaque, fovReveal);
+}
+
+// ===================== DUNGEON MAP DRAWING =====================
+
+// Draw one tile at its place under the camera; clear wipes what was there
+void drawMapTile(int x, int y, bool clear) {
   const int tileW = 16;
   const int tileH = 14;
   const int mapX = 4;
   const int mapY = 18;
 
-  for (int y = 0; y < 12; y++) {
-    for (int x = 0; x < 16; x++) {
-      int px = mapX + x * tileW;
-      int py = mapY + y * tileH;
-      uint8_t tile = dungeonMap[y * 16 + x];
-
-      switch (tile) {
-        case TILE_WALL:
-          display.fillRect(px, py, tileW, tileH, GxEPD_BLACK);
-          break;
-        case TILE_FLOOR:
-          // Leave white, draw light border
-          display.drawRect(px, py, tileW, tileH, GxEPD_BLACK);
-          break;
-        case TILE_DOOR:
-          display.drawRect(px, py, tileW, tileH, GxEPD_BLACK);
-          display.drawLine(px + tileW/2, py, px + tileW/2, py + tileH - 1, GxEPD_BLACK);
-          break;
-        case TILE_STAIRS_DOWN:
-          display.drawRect(px, py, tileW, tileH, GxEPD_BLACK);
-          display.drawLine(px + 8, py + 2, px + 8, py + 10, GxEPD_BLACK);
-          display.drawLine(px + 5, py + 7, px + 8, py + 10, GxEPD_BLACK);
-          display.drawLine(px + 11, py + 7, px + 8, py + 10, GxEPD_BLACK);
-          break;
-        case TILE_STAIRS_UP:
-          display.drawRect(px, py, tileW, tileH, GxEPD_BLACK);
-          display.drawLine(px + 8, py + 10, px + 8, py + 2, GxEPD_BLACK);
-          display.drawLine(px + 5, py + 5, px + 8, py + 2, GxEPD_BLACK);
-          display.drawLine(px + 11, py + 5, px + 8, py + 2, GxEPD_BLACK);
-          break;
-        case TILE_CHEST:
-          display.drawRect(px, py, tileW, tileH, GxEPD_BLACK);
-          if (!isChestOpened(y * 16 + x)) {
-            display.fillRect(px + 4, py + 4, 8, 6, GxEPD_BLACK);
-          }
-          break;
-        case TILE_BOSS:
-          display.drawRect(px, py, tileW, tileH, GxEPD_BLACK);
-          display.fillCircle(px + 8, py + 7, 4, GxEPD_BLACK);
-          break;
-        case TILE_ENTRANCE:
-          display.drawRect(px, py, tileW, tileH, GxEPD_BLACK);
-          display.setFont(NULL);
-          display.setCursor(px + 5, py + 4);
-          display.print("E");
-          break;
-        default:
-          display.drawRect(px, py, tileW, tileH, GxEPD_BLACK);
-          break;
-      }
-
-      // Draw player
-      if (x == player.posX && y == player.posY) {
-        display.fillCircle(px + tileW / 2, py + tileH / 2, 4, GxEPD_BLACK);
-        display.fillCircle(px + tileW / 2, py + tileH / 2, 2, GxEPD_WHITE);
-      }
+  int vx = x - dungeonMap.viewX();
+  int vy = y - dungeonMap.viewY();
+  if (!dungeonMap.inside(x, y) || vx < 0 || vy < 0 || vx >= MAP_VIEW_W || vy >= MAP_VIEW_H) return;
+  int px = mapX + vx * tileW;
+  int py = mapY + vy * tileH;
+  if (clear) clearArea(px, py, tileW, tileH);
+
+  if (isTileFlagged(WORLD_SEEN, dungeonMap.index(x, y))) {
+    uint8_t tile = dungeonMap.tile(x, y);
+
+    switch (tile) {
+      case TILE_WALL:
+        display.fillRect(px, py, tileW, tileH, GxEPD_BLACK);
+        break;
+      case TILE_FLOOR:
+        // Leave white, draw light border
+        display.drawRect(px, py, tileW, tileH, GxEPD_BLACK);
+        break;
+      case TILE_DOOR:
+        display.drawRect(px, py, tileW, tileH, GxEPD_BLACK);
+        display.drawLine(px + tileW/2, py, px + tileW/2, py + tileH - 1, GxEPD_BLACK);
+        break;
+      case TILE_STAIRS_DOWN:
+        display.drawRect(px, py, tileW, tileH, GxEPD_BLACK);
+        display.drawLine(px + 8, py + 2, px + 8, py + 10, GxEPD_BLACK);
+        display.drawLine(px + 5, py + 7, px + 8, py + 10, GxEPD_BLACK);
+        display.drawLine(px + 11, py + 7, px + 8, py + 10, GxEPD_BLACK);
+        break;
+      case TILE_STAIRS_UP:
+        display.drawRect(px, py, tileW, tileH, GxEPD_BLACK);
+        display.drawLine(px + 8, py + 10, px + 8, py + 2, GxEPD_BLACK);
+        display.drawLine(px + 5, py + 5, px + 8, py + 2, GxEPD_BLACK);
+        display.drawLine(px + 11, py + 5, px + 8, py + 2, GxEPD_BLACK);
+        break;
+      case TILE_CHEST:
+        display.drawRect(px, py, tileW, tileH, GxEPD_BLACK);
+        if (!isTileFlagged(WORLD_CHEST, dungeonMap.index(x, y))) {
+          display.fillRect(px + 4, py + 4, 8, 6, GxEPD_BLACK);
+        }
+        break;
+      case TILE_BOSS:
+        display.drawRect(px, py, tileW, tileH, GxEPD_BLACK);
+        display.fillCircle(px + 8, py + 7, 4, GxEPD_BLACK);
+        break;
+      case TILE_ENTRANCE:
+        display.drawRect(px, py, tileW, tileH, GxEPD_BLACK);
+        GLYPHS().setFont(NULL);
+        display.setCursor(px + 5, py + 4);
+        GLYPHS().print("E");
+        break;
+      default:
+        display.drawRect(px, py, tileW, tileH, GxEPD_BLACK);
+        break;
     }
   }
+
+  // Draw player
+  if (x == player.posX && y == player.posY) {
+    display.fillCircle(px + tileW / 2, py + tileH / 2, 4, GxEPD_BLACK);
+    display.fillCircle(px + tileW / 2, py + tileH / 2, 2, GxEPD_WHITE);
+  }
+}
+
+// Draw the part of the dungeon map under the camera
+void drawDungeonMap() {
+  for (int vy = 0; vy < MAP_VIEW_H; vy++) {
+    for (int vx = 0; vx < MAP_VIEW_W; vx++) {
+      drawMapTile(dungeonMap.viewX() + vx, dungeonMap.viewY() + vy, false);
+    }
+  }
+  drawnPlayerX = player.posX;
+  drawnPlayerY = player.posY;
+  drawnFloor = player.floorNum;
+}
+
+// Redraw only what changed since the last draw, over the previous frame
+void drawMapChanges(const uint16_t* tiles, int count) {
+  drawMapTile(drawnPlayerX, drawnPlayerY, true);
+  for (int i = 0; i < count; i++) {
+    drawMapTile(tiles[i] % dungeonMap.width(), tiles[i] / dungeonMap.width(), true);
+  }
+  drawMapTile(player.posX, player.posY, true);
+  drawnPlayerX = player.posX;
+  drawnPlayerY = player.posY;
+}
+
+// ===================== DUNGEON MOVEMENT =====================
+
+// Move the player onto (newX, newY) and trigger what is there. False for
+// walls and tiles off the map.
+bool stepPlayer(int newX, int newY) {
+  if (!dungeonMap.inside(newX, newY)) return false;
+  uint8_t tile = dungeonMap.tile(newX, newY);
+  if (tile == TILE_WALL) return false;
+
+  player.posX = newX;
+  player.posY = newY;
+  einkNeedsRefresh = true;
+
+  // Tile interactions
+  if (tile == TILE_STAIRS_DOWN) {
+    if (currentDungeon.endless ? player.floorNum < UINT16_MAX : player.floorNum < currentDungeon.floors) {
+      player.floorNum++;
+      loadDungeonFloor(currentDungeon.id, player.floorNum);
+      // Find stairs up on new floor
+      dungeonMap.findMark(TILE_STAIRS_UP, player.posX, player.posY);
+      char msg[32];
+      snprintf(msg, sizeof(msg), "Floor %d", player.floorNum);
+      setOledMsg(msg);
+      EINK().forceSlowFullUpdate(true);
+    }
+  }
+  else if (tile == TILE_STAIRS_UP) {
+    if (player.floorNum > 1) {
+      player.floorNum--;
+      loadDungeonFloor(currentDungeon.id, player.floorNum);
+      dungeonMap.findMark(TILE_STAIRS_DOWN, player.posX, player.posY);
+      char msg[32];
+      snprintf(msg, sizeof(msg), "Floor %d", player.floorNum);
+      setOledMsg(msg);
+      EINK().forceSlowFullUpdate(true);
+    } else {
+      // Exit dungeon
+      player.dungeonId = 0;
+      gameState = GAME_TOWN;
+      newState = true;
+      EINK().forceSlowFullUpdate(true);
+      setOledMsg("Returned to town");
+    }
+  }
+  else if (tile == TILE_CHEST) {
+    uint16_t chestIdx = dungeonMap.index(newX, newY);
+    if (!isTileFlagged(WORLD_CHEST, chestIdx)) {
+      setTileFlag(WORLD_CHEST, chestIdx);
+      travelFields[TRAVEL_CHEST].invalidate();
+      rollChestLoot();
+      playJingleWithBgm(TreasureJingle);
+      gameState = GAME_TREASURE;
+      newState = true;
+      einkNeedsRefresh = true;
+    }
+  }
+  else if (tile == TILE_BOSS) {
+    // Boss encounter - use bossId if set, fallback to the strongest enemy in reach
+    uint16_t bId = currentDungeon.bossId > 0 ? currentDungeon.bossId :
+                   currentDungeon.enemyPool[encounterPoolSize() - 1];
+    startCombat(bId);
+  }
+  else if (tile == TILE_TRAP) {
+    // Hidden trap! Deal damage and convert to floor
+    int trapDmg = 3 + player.floorNum * 2 + random(4);
+    player.hp = max(0, (int)player.hp - trapDmg);
+    dungeonMap.setTile(newX, newY, TILE_FLOOR);
+    setTileFlag(WORLD_TRAP, dungeonMap.index(newX, newY));
+    char msg[32];
+    snprintf(msg, sizeof(msg), "Trap! -%d HP!", trapDmg);
+    setOledMsg(msg);
+    playJingleWithBgm(HitJingle);
+    einkNeedsRefresh = true;
+    if (player.hp <= 0) {
+      playJingleWithBgm(DefeatJingle);
+      gameState = GAME_GAME_OVER;
+      newState = true;
+    }
+  }
+  else if (tile == TILE_FLOOR || tile == TILE_DOOR) {
+    rollEncounter();
+  }
+
+  if (player.dungeonId) updateVisibility();
+  return true;
+}
+
+// ===================== AUTO-TRAVEL =====================
+// Walks the distance field of a target one stepPlayer() at a time, so
+// encounters, traps and chests along the way behave as if walked by hand. The
+// walk stops at the target or at anything that interrupts it, and the screen
+// is redrawn once for the whole walk.
+
+#define TRAVEL_MAX_STEPS 4096
+
+bool travelPassable(int x, int y) {
+  return dungeonMap.tile(x, y) != TILE_WALL;
+}
+
+bool travelToStairs(int x, int y) {
+  return dungeonMap.tile(x, y) == TILE_STAIRS_DOWN && isTileFlagged(WORLD_SEEN, dungeonMap.index(x, y));
+}
+
+bool travelToChest(int x, int y) {
+  uint16_t idx = dungeonMap.index(x, y);
+  return dungeonMap.tile(x, y) == TILE_CHEST && isTileFlagged(WORLD_SEEN, idx) &&
+         !isTileFlagged(WORLD_CHEST, idx);
+}
+
+bool travelToExit(int x, int y) {
+  uint8_t tile = dungeonMap.tile(x, y);
+  return tile == TILE_ENTRANCE || tile == TILE_STAIRS_UP;
+}
+
+void autoTravel(TravelTarget target) {
+  static const DistanceField::TileFn goals[TRAVEL_TARGETS] = { travelToStairs, travelToChest, travelToExit };
+  int steps = 0;
+
+  // Steps flag a refresh; the e-ink task must not draw a half-walked state
+  travelling = true;
+  while (steps < TRAVEL_MAX_STEPS) {
+    DistanceField& field = travelFields[target];
+    if (!field.valid() && !field.build(dungeonMap.width(), dungeonMap.height(), travelPassable, goals[target])) break;
+
+    int nx, ny;
+    if (!field.next(player.posX, player.posY, nx, ny)) break;
+
+    uint16_t floor = player.floorNum;
+    uint16_t hp = player.hp;
+    stepPlayer(nx, ny);
+    steps++;
+    if (gameState != GAME_DUNGEON || player.hp < hp) break;
+    // Only the way out carries on past a change of floor
+    if (player.floorNum != floor && target != TRAVEL_EXIT) break;
+  }
+  travelling = false;
+  if (steps > 0) einkNeedsRefresh = true;
+
+  if (steps == 0) setOledMsg("No known way there");
+  ESP_LOGI(TAG, "Travelled %d steps", steps);
 }
 
 // ===================== OTA APP ENTRY POINTS =====================
@@ -1232,7 +2252,9 @@ void APP_INIT() {
   sdBegin();
   // Only need /rpg directory for save files
   if (!SD_MMC.exists("/rpg")) SD_MMC.mkdir("/rpg");
+  int packCount = PACKS().mount();
   sdEnd();
+  if (packCount > 0) ESP_LOGI(TAG, "%d content packs mounted", packCount);
 
   scanDungeonFiles();
   EINK().forceSlowFullUpdate(true);
@@ -1240,6 +2262,8 @@ void APP_INIT() {
   einkNeedsRefresh = true;
   playJingleWithBgm(Jingles::Startup);
   setBgm(BGM_TITLE);
+  TIMELINE().begin(setOledMsg);
+  loadLootTables();
   ESP_LOGI(TAG, "Mage's Descent initialized. %d dungeons found.", dungeonCount);
 }
 
@@ -1253,6 +2277,9 @@ void processKB_APP() {
   // Update background music
   updateBgm();
 
+  // Timed messages and deferred turns
+  TIMELINE().update(currentMillisKB);
+
   // OLED update
   currentMillisOLED = millis();
   if (currentMillisOLED - OLEDFPSMillis >= (1000 / OLED_MAX_FPS)) {
@@ -1273,11 +2300,24 @@ void processKB_APP() {
     }
   }
 
+  // Auto-battle runs on its own clock, not on key presses
+  if (autoBattle && gameState == GAME_COMBAT && currentMillisKB - autoBattleMillis >= AUTO_BATTLE_STEP_MS) {
+    autoBattleMillis = currentMillisKB;
+    autoBattleStep();
+  }
+
   if (currentMillisKB - KBBounceMillis < KB_COOLDOWN) return;
 
   char inchar = KB().updateKeypress();
   if (inchar == 0) return;
 
+  // While a message or turn is pending, a key skips ahead to it
+  if (TIMELINE().busy()) {
+    TIMELINE().skip();
+    KBBounceMillis = currentMillisKB;
+    return;
+  }
+
   // SHIFT toggle (all states)
   if (inchar == 17) {
     if (KB().getKeyboardState() == SHIFT || KB().getKeyboardState() == FN_SHIFT)
@@ -1321,9 +2361,8 @@ void processKB_APP() {
   // Global exit: BACKSPACE at title = exit to PocketMage OS
   if (gameState == GAME_TITLE && (inchar == 127 || inchar == 8 || inchar == 12)) {
     stopBgm();
-    setOledMsg("Exiting...");
-    delay(500);
-    rebootToPocketMage();
+    TIMELINE().say(0, "Exiting...");
+    TIMELINE().after(500, [] { rebootToPocketMage(); });
     KBBounceMillis = currentMillisKB;
     return;
   }
@@ -1539,6 +2578,7 @@ void processKB_APP() {
             player.activeQuests[player.questCount] = q.id;
             player.questProgress[player.questCount] = 0;
             player.questCount++;
+            rebuildQuestIndex();
             char msg[48];
             snprintf(msg, sizeof(msg), "Accepted: %s", q.name);
             setOledMsg(msg);
@@ -1546,7 +2586,7 @@ void processKB_APP() {
           } else if (alreadyHave) {
             // Check if quest is complete
             for (int i = 0; i < player.questCount; i++) {
-              if (player.activeQuests[i] == q.id && player.questProgress[i] >= q.targetCount) {
+              if (player.activeQuests[i] == q.id && questReady[i]) {
                 // Complete quest
                 player.gold += q.rewardGold;
                 player.xp += q.rewardXp;
@@ -1557,6 +2597,7 @@ void processKB_APP() {
                   player.questProgress[j] = player.questProgress[j + 1];
                 }
                 player.questCount--;
+                rebuildQuestIndex();
                 char msg[48];
                 snprintf(msg, sizeof(msg), "Quest done! +%dg +%luxp", q.rewardGold, q.rewardXp);
                 setOledMsg(msg);
@@ -1647,13 +2688,8 @@ void processKB_APP() {
             loadDungeonFloor(currentDungeon.id, 1);
             // Find entrance
             player.posX = 1; player.posY = 1;
-            for (int y = 0; y < 12; y++) {
-              for (int x = 0; x < 16; x++) {
-                if (dungeonMap[y * 16 + x] == TILE_ENTRANCE) {
-                  player.posX = x; player.posY = y;
-                }
-              }
-            }
+            dungeonMap.findMark(TILE_ENTRANCE, player.posX, player.posY);
+            updateVisibility();
             gameState = GAME_DUNGEON;
             newState = true;
             einkNeedsRefresh = true;
@@ -1680,6 +2716,9 @@ void processKB_APP() {
       else if (inchar == 's' || inchar == 'S') { newY++; moved = true; }
       else if (inchar == 'a' || inchar == 'A') { newX--; moved = true; }
       else if (inchar == 'd' || inchar == 'D') { newX++; moved = true; }
+      else if (inchar == 'g' || inchar == 'G') autoTravel(TRAVEL_STAIRS);
+      else if (inchar == 'c' || inchar == 'C') autoTravel(TRAVEL_CHEST);
+      else if (inchar == 'e' || inchar == 'E') autoTravel(TRAVEL_EXIT);
       else if (inchar == 'i' || inchar == 'I') {
         invPage = 0;
         previousState = GAME_DUNGEON;
@@ -1696,125 +2735,27 @@ void processKB_APP() {
         setOledMsg("Left dungeon");
       }
 
-      if (moved && newX >= 0 && newX < 16 && newY >= 0 && newY < 12) {
-        uint8_t tile = dungeonMap[newY * 16 + newX];
-        if (tile != TILE_WALL) {
-          player.posX = newX;
-          player.posY = newY;
-          einkNeedsRefresh = true;
-
-          // Tile interactions
-          if (tile == TILE_STAIRS_DOWN) {
-            if (player.floorNum < currentDungeon.floors) {
-              player.floorNum++;
-              loadDungeonFloor(currentDungeon.id, player.floorNum);
-              // Find stairs up on new floor
-              for (int y = 0; y < 12; y++) {
-                for (int x = 0; x < 16; x++) {
-                  if (dungeonMap[y * 16 + x] == TILE_STAIRS_UP) {
-                    player.posX = x; player.posY = y;
-                  }
-                }
-              }
-              char msg[32];
-              snprintf(msg, sizeof(msg), "Floor %d", player.floorNum);
-              setOledMsg(msg);
-              EINK().forceSlowFullUpdate(true);
-            }
-          }
-          else if (tile == TILE_STAIRS_UP) {
-            if (player.floorNum > 1) {
-              player.floorNum--;
-              loadDungeonFloor(currentDungeon.id, player.floorNum);
-              for (int y = 0; y < 12; y++) {
-                for (int x = 0; x < 16; x++) {
-                  if (dungeonMap[y * 16 + x] == TILE_STAIRS_DOWN) {
-                    player.posX = x; player.posY = y;
-                  }
-                }
-              }
-              char msg[32];
-              snprintf(msg, sizeof(msg), "Floor %d", player.floorNum);
-              setOledMsg(msg);
-              EINK().forceSlowFullUpdate(true);
-            } else {
-              // Exit dungeon
-              player.dungeonId = 0;
-              gameState = GAME_TOWN;
-              newState = true;
-              EINK().forceSlowFullUpdate(true);
-              setOledMsg("Returned to town");
-            }
-          }
-          else if (tile == TILE_CHEST) {
-            uint8_t chestIdx = (player.floorNum - 1) * 16 + (newY % 12);
-            if (!isChestOpened(chestIdx)) {
-              setChestOpened(chestIdx);
-              // Random loot
-              int lootRoll = random(100);
-              if (lootRoll < 40) { treasureItemId = 1; treasureQty = 1 + random(2); } // Herb
-              else if (lootRoll < 60) { treasureItemId = 2; treasureQty = 1; } // Ether
-              else if (lootRoll < 80) { treasureItemId = 0; treasureQty = 0; player.gold += 20 + random(30); } // Gold
-              else { treasureItemId = 5; treasureQty = 1; } // Elixir
-              if (treasureItemId > 0) addItem(treasureItemId, treasureQty);
-              playJingleWithBgm(TreasureJingle);
-              gameState = GAME_TREASURE;
-              newState = true;
-              einkNeedsRefresh = true;
-            }
-          }
-          else if (tile == TILE_BOSS) {
-            // Boss encounter - use bossId if set, fallback to last enemy in pool
-            uint16_t bId = currentDungeon.bossId > 0 ? currentDungeon.bossId :
-                           currentDungeon.enemyPool[currentDungeon.enemyPoolSize - 1];
-            startCombat(bId);
-          }
-          else if (tile == TILE_TRAP) {
-            // Hidden trap! Deal damage and convert to floor
-            int trapDmg = 3 + player.floorNum * 2 + random(4);
-            player.hp = max(0, (int)player.hp - trapDmg);
-            dungeonMap[newY * 16 + newX] = TILE_FLOOR;
-            char msg[32];
-            snprintf(msg, sizeof(msg), "Trap! -%d HP!", trapDmg);
-            setOledMsg(msg);
-            playJingleWithBgm(HitJingle);
-            einkNeedsRefresh = true;
-            if (player.hp <= 0) {
-              playJingleWithBgm(DefeatJingle);
-              gameState = GAME_GAME_OVER;
-              newState = true;
-            }
-          }
-          else if (tile == TILE_FLOOR || tile == TILE_DOOR) {
-            rollEncounter();
-          }
-        }
-      }
+      if (moved) stepPlayer(newX, newY);
       break;
     }
 
     // =================== COMBAT ===================
     case GAME_COMBAT:
+      if (autoBattle) {
+        stopAutoBattle();
+        break;
+      }
       if (combatTurnPhase == 0) {
         if (inchar == '1') {
           // Attack
-          playerDefending = false;
-          int dmg = calcPlayerDamage();
-          currentEnemy.hp = max(0, currentEnemy.hp - dmg);
-          snprintf(combatMsg, sizeof(combatMsg), "Hit %s for %d!", currentEnemy.name, dmg);
-          setOledMsg(combatMsg);
-          combatTurnPhase = 2;
-          einkNeedsRefresh = true;
-          delay(600);
+          playerAttack();
+          queueEnemyTurn();
         }
         else if (inchar == '2') {
           // Defend
           playerDefending = true;
           snprintf(combatMsg, sizeof(combatMsg), "Defending!");
-          setOledMsg(combatMsg);
-          combatTurnPhase = 2;
-          einkNeedsRefresh = true;
-          delay(600);
+          queueEnemyTurn();
         }
         else if (inchar == '3') {
           // Magic submenu
@@ -1830,100 +2771,26 @@ void processKB_APP() {
           newState = true;
           einkNeedsRefresh = true;
         }
+        else if (inchar == 'a' || inchar == 'A') {
+          // Auto-battle; the screen stays as is until the fight is decided
+          startAutoBattle();
+        }
         else if (inchar == '5' || inchar == 'f' || inchar == 'F') {
           // Flee
           int fleeChance = 40 + (player.spd - currentEnemy.spd) * 5;
           if (fleeChance < 15) fleeChance = 15; // Always at least 15% chance
           if (fleeChance > 90) fleeChance = 90; // Cap at 90%
           if (random(100) < fleeChance) {
-            setOledMsg("Escaped!");
-            delay(800);
-            gameState = GAME_DUNGEON;
-            newState = true;
-            einkNeedsRefresh = true;
-            EINK().forceSlowFullUpdate(true);
-          } else {
-            setOledMsg("Can't escape!");
-            combatTurnPhase = 2;
-            einkNeedsRefresh = true;
-            delay(600);
-          }
-        }
-      }
-
-      // Enemy turn
-      if (combatTurnPhase == 2) {
-        if (currentEnemy.hp <= 0) {
-          // Victory
-          combatVictory = true;
-          combatXpGain = currentEnemy.xpReward;
-          combatGoldGain = currentEnemy.goldReward;
-          combatDropId = 0;
-          if (random(100) < currentEnemy.dropChance && currentEnemy.dropItemId > 0) {
-            combatDropId = currentEnemy.dropItemId;
-          }
-          player.xp += combatXpGain;
-          player.gold += combatGoldGain;
-          if (combatDropId > 0) addItem(combatDropId, 1);
-          checkQuestKill(currentEnemy.id);
-          playJingleWithBgm(VictoryJingle);
-          gameState = GAME_COMBAT_RESULT;
-          newState = true;
-          einkNeedsRefresh = true;
-        } else {
-          // Enemy attacks
-          int eDmg;
-          if (currentEnemy.aiType == AI_BOSS) {
-            int roll = random(100);
-            if (roll < 30 && currentEnemy.mag > 0) {
-              // Magic blast
-              eDmg = currentEnemy.mag + random(2, 6) - (player.def / 3);
-              eDmg = max(2, eDmg);
-              if (playerDefending) eDmg /= 2;
-              snprintf(combatMsg, sizeof(combatMsg), "%s blasts! %d!", currentEnemy.name, eDmg);
-            } else if (roll < 50) {
-              // Heavy strike (1.5x ATK)
-              eDmg = (currentEnemy.atk * 3 / 2) - player.def + random(-1, 3);
-              eDmg = max(2, eDmg);
-              if (playerDefending) eDmg /= 2;
-              snprintf(combatMsg, sizeof(combatMsg), "%s SMASH! %d!", currentEnemy.name, eDmg);
-            } else {
-              eDmg = calcEnemyDamage();
-              snprintf(combatMsg, sizeof(combatMsg), "%s hits! %d dmg!", currentEnemy.name, eDmg);
-            }
-          }
-          else if (currentEnemy.aiType == AI_MAGIC && random(100) < 50) {
-            eDmg = currentEnemy.mag + random(-1, 3) - (player.def / 2);
-            eDmg = max(1, eDmg);
-            if (playerDefending) eDmg /= 2;
-            snprintf(combatMsg, sizeof(combatMsg), "%s casts! %d dmg!", currentEnemy.name, eDmg);
-          }
-          else if (currentEnemy.aiType == AI_DEFENSIVE && random(100) < 30) {
-            enemyDefending = true;
-            snprintf(combatMsg, sizeof(combatMsg), "%s defends!", currentEnemy.name);
-            eDmg = 0;
-          }
-          else {
-            eDmg = calcEnemyDamage();
-            snprintf(combatMsg, sizeof(combatMsg), "%s hits! %d dmg!", currentEnemy.name, eDmg);
-          }
-
-          if (eDmg > 0) {
-            player.hp = max(0, (int)player.hp - eDmg);
-            playJingleWithBgm(HitJingle);
-          }
-          setOledMsg(combatMsg);
-          delay(800);
-
-          if (player.hp <= 0) {
-            playJingleWithBgm(DefeatJingle);
-            gameState = GAME_GAME_OVER;
-            newState = true;
-            einkNeedsRefresh = true;
+            TIMELINE().say(0, "Escaped!");
+            TIMELINE().after(COMBAT_ENEMY_MSG_MS, [] {
+              gameState = GAME_DUNGEON;
+              newState = true;
+              einkNeedsRefresh = true;
+              EINK().forceSlowFullUpdate(true);
+            });
           } else {
-            combatTurnPhase = 0;
-            playerDefending = false;
-            einkNeedsRefresh = true;
+            snprintf(combatMsg, sizeof(combatMsg), "Can't escape!");
+            queueEnemyTurn();
           }
         }
       }
@@ -1936,34 +2803,9 @@ void processKB_APP() {
         Spell spell;
         if (loadSpellById(spellIdx, spell) && spell.unlockLevel <= player.level) {
           if (player.mp >= spell.mpCost) {
-            player.mp -= spell.mpCost;
-            if (spell.type == STYPE_DAMAGE) {
-              int dmg = calcMagicDamage(spell.power);
-              currentEnemy.hp = max(0, currentEnemy.hp - dmg);
-              snprintf(combatMsg, sizeof(combatMsg), "%s! %d dmg!", spell.name, dmg);
-            }
-            else if (spell.type == STYPE_HEAL) {
-              int heal = spell.power + player.mag / 2;
-              player.hp = min((int)player.maxHp, player.hp + heal);
-              snprintf(combatMsg, sizeof(combatMsg), "%s! +%d HP!", spell.name, heal);
-            }
-            else if (spell.type == STYPE_BUFF) {
-              // Temporary defense buff
-              player.def += spell.power;
-              snprintf(combatMsg, sizeof(combatMsg), "%s! DEF+%d!", spell.name, spell.power);
-            }
-            else if (spell.type == STYPE_DEBUFF) {
-              // Reduce enemy defense
-              int reduction = min((int)spell.power, (int)currentEnemy.def);
-              currentEnemy.def -= reduction;
-              snprintf(combatMsg, sizeof(combatMsg), "%s! DEF-%d!", spell.name, reduction);
-            }
-            setOledMsg(combatMsg);
-            playerDefending = false;
-            combatTurnPhase = 2;
+            castSpell(spell);
             gameState = GAME_COMBAT;
-            einkNeedsRefresh = true;
-            delay(600);
+            queueEnemyTurn();
           } else {
             setOledMsg("Not enough MP!");
           }
@@ -1986,16 +2828,9 @@ void processKB_APP() {
         if (idx < player.invCount) {
           Item item;
           if (loadItemById(player.invId[idx], item) && item.type == ITYPE_CONSUMABLE) {
-            if (item.stat1 > 0) player.hp = min((int)player.maxHp, player.hp + item.stat1);
-            if (item.stat2 > 0) player.mp = min((int)player.maxMp, player.mp + item.stat2);
-            removeItem(item.id, 1);
-            snprintf(combatMsg, sizeof(combatMsg), "Used %s!", item.name);
-            setOledMsg(combatMsg);
-            playerDefending = false;
-            combatTurnPhase = 2;
+            useCombatItem(item);
             gameState = GAME_COMBAT;
-            einkNeedsRefresh = true;
-            delay(600);
+            queueEnemyTurn();
           } else {
             setOledMsg("Can't use that!");
           }
@@ -2067,7 +2902,7 @@ void processKB_APP() {
 // ===================== E-INK HANDLER =====================
 
 void einkHandler_APP() {
-  if (!newState && !einkNeedsRefresh) return;
+  if (travelling || (!newState && !einkNeedsRefresh)) return;
 
   switch (gameState) {
 
@@ -2090,6 +2925,9 @@ void einkHandler_APP() {
         drawCentered("A Pocket Mage RPG", 195, &FreeMono9pt8b);
         drawCentered("ENTER:Start  BKSP:Exit", 215, &FreeMono9pt8b);
 
+        // Read slot summaries now so the load screen opens without SD access
+        loadSlotIndex();
+
         EINK().drawStatusBar("ENTER:Start <:Exit M:Mute");
         EINK().refresh();
       }
@@ -2105,18 +2943,34 @@ void einkHandler_APP() {
         drawCentered("SELECT GAME", 35, &FreeMonoBold12pt8b);
         display.drawLine(30, 48, 290, 48, GxEPD_BLACK);
 
-        display.setFont(&FreeMono9pt8b);
+        GLYPHS().setFont(&FreeMono9pt8b);
         display.setCursor(40, 80);
-        display.print("N) New Game");
+        GLYPHS().print("N) New Game");
 
-        for (int i = 1; i <= 3; i++) {
+        for (int i = 1; i <= SAVE_SLOTS; i++) {
+          GLYPHS().setFont(&FreeMono9pt8b);
           display.setCursor(40, 80 + i * 30);
-          display.print(String(i) + ") ");
-          if (saveExists(i)) {
-            display.print("Continue - Slot " + String(i));
+          GLYPHS().print(String(i) + ") ");
+          if (!saveExists(i)) {
+            GLYPHS().print("Empty Slot " + String(i));
+            continue;
+          }
+
+          const SaveSummary& s = slotSummaries[i - 1];
+          GLYPHS().print(String(s.name) + " Lv" + String(s.level) + " " + String(s.gold) + "G");
+
+          char detail[48];
+          uint32_t mins = s.playSeconds / 60;
+          if (s.floorNum) {
+            snprintf(detail, sizeof(detail), "%s F%u  %luh%02lum", s.location, s.floorNum,
+                     (unsigned long)(mins / 60), (unsigned long)(mins % 60));
           } else {
-            display.print("Empty Slot " + String(i));
+            snprintf(detail, sizeof(detail), "%s  %luh%02lum", s.location,
+                     (unsigned long)(mins / 60), (unsigned long)(mins % 60));
           }
+          GLYPHS().setFont(nullptr);
+          display.setCursor(64, 80 + i * 30 + 6);
+          GLYPHS().print(detail);
         }
 
         EINK().drawStatusBar("N:New  1-3:Load  <:Back");
@@ -2141,25 +2995,25 @@ void einkHandler_APP() {
         display.drawLine(40, 42, 280, 42, GxEPD_BLACK);
 
         clearArea(20, 48, 280, 96);
-        display.setFont(&FreeMono9pt8b);
-        display.setCursor(30, 63);  display.print("1) General");
-        display.setCursor(170, 63); display.print("5) Dungeon");
-        display.setCursor(30, 79);  display.print("2) Magic");
-        display.setCursor(170, 79); display.print("6) Inventory");
-        display.setCursor(30, 95);  display.print("3) Armory");
-        display.setCursor(170, 95); display.print("7) Save");
-        display.setCursor(30, 111); display.print("4) Inn");
-        display.setCursor(170, 111);display.print("8) Quests");
+        GLYPHS().setFont(&FreeMono9pt8b);
+        display.setCursor(30, 63);  GLYPHS().print("1) General");
+        display.setCursor(170, 63); GLYPHS().print("5) Dungeon");
+        display.setCursor(30, 79);  GLYPHS().print("2) Magic");
+        display.setCursor(170, 79); GLYPHS().print("6) Inventory");
+        display.setCursor(30, 95);  GLYPHS().print("3) Armory");
+        display.setCursor(170, 95); GLYPHS().print("7) Save");
+        display.setCursor(30, 111); GLYPHS().print("4) Inn");
+        display.setCursor(170, 111);GLYPHS().print("8) Quests");
 
         display.drawLine(30, 122, 290, 122, GxEPD_BLACK);
 
         clearArea(20, 126, 280, 60);
         display.setCursor(30, 140);
-        display.print("Lv:" + String(player.level) + " HP:" + String(player.hp) + "/" + String(player.maxHp));
+        GLYPHS().print("Lv:" + String(player.level) + " HP:" + String(player.hp) + "/" + String(player.maxHp));
         display.setCursor(30, 158);
-        display.print("MP:" + String(player.mp) + "/" + String(player.maxMp) + " Gold:" + String(player.gold));
+        GLYPHS().print("MP:" + String(player.mp) + "/" + String(player.maxMp) + " Gold:" + String(player.gold));
         display.setCursor(30, 176);
-        display.print("XP:" + String(player.xp) + "/" + String(player.xpNext));
+        GLYPHS().print("XP:" + String(player.xp) + "/" + String(player.xpNext));
 
         EINK().drawStatusBar("1-8:Select S:Stats <:Exit");
         EINK().refresh();
@@ -2176,17 +3030,17 @@ void einkHandler_APP() {
         drawCentered(shopBuyMode ? "SHOP - BUY" : "SHOP - SELL", 28, &FreeMonoBold12pt8b);
         display.drawLine(20, 40, 300, 40, GxEPD_BLACK);
 
-        display.setFont(&FreeMono9pt8b);
+        GLYPHS().setFont(&FreeMono9pt8b);
         display.setCursor(20, 56);
-        display.print("Gold: " + String(player.gold));
+        GLYPHS().print("Gold: " + String(player.gold));
 
         if (shopBuyMode) {
           int startIdx = shopPage * 6;
           for (int i = 0; i < 6 && startIdx + i < shopItemCount; i++) {
             display.setCursor(20, 78 + i * 20);
-            display.print(String(i + 1) + "." + String(shopItems[startIdx + i].name));
+            GLYPHS().print(String(i + 1) + "." + String(shopItems[startIdx + i].name));
             display.setCursor(240, 78 + i * 20);
-            display.print(String(shopItems[startIdx + i].price) + "g");
+            GLYPHS().print(String(shopItems[startIdx + i].price) + "g");
           }
         } else {
           int startIdx = invPage * 6;
@@ -2194,9 +3048,9 @@ void einkHandler_APP() {
             Item item;
             if (loadItemById(player.invId[startIdx + i], item)) {
               display.setCursor(20, 78 + i * 20);
-              display.print(String(i + 1) + "." + String(item.name) + " x" + String(player.invQty[startIdx + i]));
+              GLYPHS().print(String(i + 1) + "." + String(item.name) + " x" + String(player.invQty[startIdx + i]));
               display.setCursor(240, 78 + i * 20);
-              display.print(String(item.value / 2) + "g");
+              GLYPHS().print(String(item.value / 2) + "g");
             }
           }
         }
@@ -2225,16 +3079,16 @@ void einkHandler_APP() {
         display.drawLine(40, 48, 280, 48, GxEPD_BLACK);
 
         clearArea(30, 55, 260, 110);
-        display.setFont(&FreeMono9pt8b);
+        GLYPHS().setFont(&FreeMono9pt8b);
         display.setCursor(40, 80);
-        display.print("Rest and recover?");
+        GLYPHS().print("Rest and recover?");
         display.setCursor(40, 105);
         int cost = player.level * 5;
-        display.print("Cost: " + String(cost) + " gold");
+        GLYPHS().print("Cost: " + String(cost) + " gold");
         display.setCursor(40, 130);
-        display.print("HP: " + String(player.hp) + "/" + String(player.maxHp));
+        GLYPHS().print("HP: " + String(player.hp) + "/" + String(player.maxHp));
         display.setCursor(40, 150);
-        display.print("MP: " + String(player.mp) + "/" + String(player.maxMp));
+        GLYPHS().print("MP: " + String(player.mp) + "/" + String(player.maxMp));
 
         EINK().drawStatusBar("1/ENTER:Rest  <:Back");
         EINK().refresh();
@@ -2251,32 +3105,28 @@ void einkHandler_APP() {
         drawCentered("QUEST BOARD", 28, &FreeMonoBold12pt8b);
         display.drawLine(20, 40, 300, 40, GxEPD_BLACK);
 
-        display.setFont(&FreeMono9pt8b);
+        GLYPHS().setFont(&FreeMono9pt8b);
         int yPos = 60;
         int startQ = questPage * 6 + 1;
-        int endQ = startQ + 5;
-        for (int i = startQ; i <= endQ; i++) {
-          Quest q;
-          if (loadQuestById(i, q)) {
-            display.setCursor(20, yPos);
-            int dispNum = i - questPage * 6;
-            // Check if active
-            bool active = false;
-            uint8_t prog = 0;
-            for (int j = 0; j < player.questCount; j++) {
-              if (player.activeQuests[j] == q.id) {
-                active = true;
-                prog = player.questProgress[j];
-                break;
-              }
-            }
-            if (active) {
-              display.print(String(dispNum) + "." + String(q.name) + " [" + String(prog) + "/" + String(q.targetCount) + "]");
-            } else {
-              display.print(String(dispNum) + "." + String(q.name));
-            }
-            yPos += 22;
+        Quest page[6];
+        int shown = loadQuestRange(startQ, startQ + 5, page, 6);
+        for (int i = 0; i < shown; i++) {
+          const Quest& q = page[i];
+          display.setCursor(20, yPos);
+          int dispNum = q.id - questPage * 6;
+          // Check if active
+          int slot = -1;
+          for (int j = 0; j < player.questCount; j++) {
+            if (player.activeQuests[j] == q.id) { slot = j; break; }
+          }
+          if (slot >= 0 && questReady[slot]) {
+            GLYPHS().print(String(dispNum) + "." + String(q.name) + " [Ready!]");
+          } else if (slot >= 0) {
+            GLYPHS().print(String(dispNum) + "." + String(q.name) + " [" + String(player.questProgress[slot]) + "/" + String(q.targetCount) + "]");
+          } else {
+            GLYPHS().print(String(dispNum) + "." + String(q.name));
           }
+          yPos += 22;
         }
 
         EINK().drawStatusBar("1-6:Accept </>:Pg <:Back");
@@ -2294,25 +3144,25 @@ void einkHandler_APP() {
         drawCentered("INVENTORY", 28, &FreeMonoBold12pt8b);
         display.drawLine(20, 40, 300, 40, GxEPD_BLACK);
 
-        display.setFont(&FreeMono9pt8b);
+        GLYPHS().setFont(&FreeMono9pt8b);
         // Equipment
         display.setCursor(20, 58);
         if (player.equipWeapon > 0) {
           Item w; loadItemById(player.equipWeapon, w);
-          display.print("W:" + String(w.name));
-        } else display.print("W: (none)");
+          GLYPHS().print("W:" + String(w.name));
+        } else GLYPHS().print("W: (none)");
 
         display.setCursor(170, 58);
         if (player.equipArmor > 0) {
           Item a; loadItemById(player.equipArmor, a);
-          display.print("A:" + String(a.name));
-        } else display.print("A: (none)");
+          GLYPHS().print("A:" + String(a.name));
+        } else GLYPHS().print("A: (none)");
 
         display.setCursor(20, 74);
         if (player.equipAccessory > 0) {
           Item ac; loadItemById(player.equipAccessory, ac);
-          display.print("R:" + String(ac.name));
-        } else display.print("R: (none)");
+          GLYPHS().print("R:" + String(ac.name));
+        } else GLYPHS().print("R: (none)");
 
         display.drawLine(20, 82, 300, 82, GxEPD_BLACK);
 
@@ -2326,13 +3176,13 @@ void einkHandler_APP() {
             if (item.type == ITYPE_WEAPON) typeCh = 'W';
             else if (item.type == ITYPE_ARMOR) typeCh = 'A';
             else if (item.type == ITYPE_ACCESSORY) typeCh = 'R';
-            display.print(String(i + 1) + ".[" + typeCh + "] " + String(item.name) + " x" + String(player.invQty[startIdx + i]));
+            GLYPHS().print(String(i + 1) + ".[" + typeCh + "] " + String(item.name) + " x" + String(player.invQty[startIdx + i]));
           }
         }
 
         if (player.invCount == 0) {
           display.setCursor(80, 130);
-          display.print("(empty)");
+          GLYPHS().print("(empty)");
         }
 
         EINK().drawStatusBar("1-9:Use/Equip </>:Pg <:Back");
@@ -2350,16 +3200,16 @@ void einkHandler_APP() {
         drawCentered(player.name, 30, &FreeMonoBold12pt8b);
         display.drawLine(30, 42, 290, 42, GxEPD_BLACK);
 
-        display.setFont(&FreeMono9pt8b);
+        GLYPHS().setFont(&FreeMono9pt8b);
         int y = 62;
-        display.setCursor(30, y);  display.print("Level: " + String(player.level)); y += 20;
-        display.setCursor(30, y);  display.print("HP: " + String(player.hp) + "/" + String(player.maxHp)); y += 20;
-        display.setCursor(30, y);  display.print("MP: " + String(player.mp) + "/" + String(player.maxMp)); y += 20;
-        display.setCursor(30, y);  display.print("ATK:" + String(player.atk) + " DEF:" + String(player.def));
-        display.setCursor(190, y); display.print("MAG:" + String(player.mag)); y += 20;
-        display.setCursor(30, y);  display.print("SPD:" + String(player.spd));
-        display.setCursor(190, y); display.print("Gold:" + String(player.gold)); y += 20;
-        display.setCursor(30, y);  display.print("XP: " + String(player.xp) + "/" + String(player.xpNext));
+        display.setCursor(30, y);  GLYPHS().print("Level: " + String(player.level)); y += 20;
+        display.setCursor(30, y);  GLYPHS().print("HP: " + String(player.hp) + "/" + String(player.maxHp)); y += 20;
+        display.setCursor(30, y);  GLYPHS().print("MP: " + String(player.mp) + "/" + String(player.maxMp)); y += 20;
+        display.setCursor(30, y);  GLYPHS().print("ATK:" + String(player.atk) + " DEF:" + String(player.def));
+        display.setCursor(190, y); GLYPHS().print("MAG:" + String(player.mag)); y += 20;
+        display.setCursor(30, y);  GLYPHS().print("SPD:" + String(player.spd));
+        display.setCursor(190, y); GLYPHS().print("Gold:" + String(player.gold)); y += 20;
+        display.setCursor(30, y);  GLYPHS().print("XP: " + String(player.xp) + "/" + String(player.xpNext));
 
         EINK().drawStatusBar("ENTER/<:Back");
         EINK().refresh();
@@ -2376,20 +3226,20 @@ void einkHandler_APP() {
         drawCentered("SELECT DUNGEON", 30, &FreeMonoBold12pt8b);
         display.drawLine(30, 42, 290, 42, GxEPD_BLACK);
 
-        display.setFont(&FreeMono9pt8b);
+        GLYPHS().setFont(&FreeMono9pt8b);
         for (int i = 0; i < dungeonCount; i++) {
           display.setCursor(30, 68 + i * 25);
-          display.print(String(i + 1) + ") " + String(dungeonList[i].name) +
+          GLYPHS().print(String(i + 1) + ") " + String(dungeonList[i].name) +
             " (Lv" + String(dungeonList[i].minLevel) + "+)");
         }
 
         if (dungeonCount == 0) {
           display.setCursor(60, 100);
-          display.print("No dungeons found!");
+          GLYPHS().print("No dungeons found!");
           display.setCursor(30, 130);
-          display.print("Add dungeon files to");
+          GLYPHS().print("Add dungeon files to");
           display.setCursor(30, 150);
-          display.print("/rpg/dungeons/ on SD");
+          GLYPHS().print("/rpg/dungeons/ on SD");
         }
 
         EINK().drawStatusBar("1-9:Enter  <:Back");
@@ -2400,35 +3250,48 @@ void einkHandler_APP() {
     // =================== DUNGEON ===================
     case GAME_DUNGEON:
       if (newState || einkNeedsRefresh) {
+        // A plain step redraws the changed tiles over the last frame. Tiles
+        // revealed after the take stay queued for the next refresh.
+        static uint16_t drawTiles[FOV_MAX_TILES];
+        int drawCount = 0;
+        bool overflow = takeRevealed(drawTiles, drawCount);
+        bool scrolled = dungeonMap.follow(player.posX, player.posY);
+        bool full = newState || scrolled || overflow || drawnFloor != player.floorNum;
         newState = false;
         einkNeedsRefresh = false;
-        EINK().resetDisplay();
+        int sx = 264;
+
+        if (full) {
+          EINK().resetDisplay();
 
-        // Header
-        display.setFont(&FreeMono9pt8b);
-        display.setCursor(4, 14);
-        display.print(String(currentDungeon.name) + " F" + String(player.floorNum));
+          // Header
+          GLYPHS().setFont(&FreeMono9pt8b);
+          display.setCursor(4, 14);
+          GLYPHS().print(String(currentDungeon.name) + " F" + String(player.floorNum));
 
-        // Draw map
-        drawDungeonMap();
+          // Draw map
+          drawDungeonMap();
+        } else {
+          drawMapChanges(drawTiles, drawCount);
+          clearArea(sx, 20, 320 - sx, 104);
+        }
 
         // Sidebar stats
-        int sx = 264;
-        display.setFont(&FreeMono9pt8b);
+        GLYPHS().setFont(&FreeMono9pt8b);
         display.setCursor(sx, 34);
-        display.print("Lv" + String(player.level));
+        GLYPHS().print("Lv" + String(player.level));
         display.setCursor(sx, 52);
-        display.print("HP");
+        GLYPHS().print("HP");
         drawHpBar(sx, 54, 50, 8, player.hp, player.maxHp);
         display.setCursor(sx, 76);
-        display.print("MP");
+        GLYPHS().print("MP");
         drawHpBar(sx, 78, 50, 8, player.mp, player.maxMp);
         display.setCursor(sx, 102);
-        display.print(String(player.hp) + "/" + String(player.maxHp));
+        GLYPHS().print(String(player.hp) + "/" + String(player.maxHp));
         display.setCursor(sx, 118);
-        display.print(String(player.mp) + "/" + String(player.maxMp));
+        GLYPHS().print(String(player.mp) + "/" + String(player.maxMp));
 
-        EINK().drawStatusBar("WASD:Move I:Inv <:Leave");
+        EINK().drawStatusBar("WASD:Move G/C/E:Go I:Inv <:Leave");
         EINK().refresh();
       }
       break;
@@ -2457,37 +3320,37 @@ void einkHandler_APP() {
         drawCentered(currentEnemy.name, 25, &FreeMonoBold12pt8b);
 
         // Enemy HP bar
-        display.setFont(&FreeMono9pt8b);
+        GLYPHS().setFont(&FreeMono9pt8b);
         display.setCursor(40, 45);
-        display.print("HP:" + String(currentEnemy.hp) + "/" + String(currentEnemy.maxHp));
+        GLYPHS().print("HP:" + String(currentEnemy.hp) + "/" + String(currentEnemy.maxHp));
         drawHpBar(40, 50, 240, 12, currentEnemy.hp, currentEnemy.maxHp);
 
         display.drawLine(20, 72, 300, 72, GxEPD_BLACK);
 
         // Player info
         display.setCursor(20, 90);
-        display.print(String(player.name) + " Lv" + String(player.level));
+        GLYPHS().print(String(player.name) + " Lv" + String(player.level));
         display.setCursor(20, 108);
-        display.print("HP:" + String(player.hp) + "/" + String(player.maxHp) +
+        GLYPHS().print("HP:" + String(player.hp) + "/" + String(player.maxHp) +
                        "  MP:" + String(player.mp) + "/" + String(player.maxMp));
 
         display.drawLine(20, 118, 300, 118, GxEPD_BLACK);
 
         // Combat menu
         display.setCursor(30, 138);
-        display.print("1) Attack    4) Item");
+        GLYPHS().print("1) Attack    4) Item");
         display.setCursor(30, 158);
-        display.print("2) Defend  F) Flee");
+        GLYPHS().print("2) Defend  F) Flee");
         display.setCursor(30, 178);
-        display.print("3) Magic");
+        GLYPHS().print("3) Magic   A) Auto");
 
         // Last combat message
         if (combatMsg[0] != 0) {
           display.setCursor(30, 200);
-          display.print(combatMsg);
+          GLYPHS().print(combatMsg);
         }
 
-        EINK().drawStatusBar("1-4:Action F:Flee");
+        EINK().drawStatusBar("1-4:Action A:Auto F:Flee");
         EINK().refresh();
       }
       break;
@@ -2502,9 +3365,9 @@ void einkHandler_APP() {
         drawCentered("SPELLS", 28, &FreeMonoBold12pt8b);
         display.drawLine(20, 40, 300, 40, GxEPD_BLACK);
 
-        display.setFont(&FreeMono9pt8b);
+        GLYPHS().setFont(&FreeMono9pt8b);
         display.setCursor(20, 58);
-        display.print("MP: " + String(player.mp) + "/" + String(player.maxMp));
+        GLYPHS().print("MP: " + String(player.mp) + "/" + String(player.maxMp));
 
         int yPos = 80;
         int startSpell = spellPage * 8 + 1;
@@ -2516,7 +3379,7 @@ void einkHandler_APP() {
             String typeStr = (spell.type == STYPE_DAMAGE) ? "DMG" :
                              (spell.type == STYPE_HEAL) ? "HEAL" :
                              (spell.type == STYPE_BUFF) ? "BUFF" : "DBF";
-            display.print(String(i - spellPage * 8) + "." + String(spell.name) + " " + String(spell.mpCost) + "MP " + typeStr);
+            GLYPHS().print(String(i - spellPage * 8) + "." + String(spell.name) + " " + String(spell.mpCost) + "MP " + typeStr);
             yPos += 18;
           }
         }
@@ -2536,7 +3399,7 @@ void einkHandler_APP() {
         drawCentered("USE ITEM", 28, &FreeMonoBold12pt8b);
         display.drawLine(20, 40, 300, 40, GxEPD_BLACK);
 
-        display.setFont(&FreeMono9pt8b);
+        GLYPHS().setFont(&FreeMono9pt8b);
         int startIdx = invPage * 6;
         int yPos = 62;
         for (int i = 0; i < 6 && startIdx + i < player.invCount; i++) {
@@ -2544,9 +3407,9 @@ void einkHandler_APP() {
           if (loadItemById(player.invId[startIdx + i], item)) {
             display.setCursor(20, yPos);
             if (item.type == ITYPE_CONSUMABLE) {
-              display.print(String(i + 1) + "." + String(item.name) + " x" + String(player.invQty[startIdx + i]));
+              GLYPHS().print(String(i + 1) + "." + String(item.name) + " x" + String(player.invQty[startIdx + i]));
             } else {
-              display.print(String(i + 1) + "." + String(item.name) + " (equip)");
+              GLYPHS().print(String(i + 1) + "." + String(item.name) + " (equip)");
             }
             yPos += 20;
           }
@@ -2567,24 +3430,24 @@ void einkHandler_APP() {
         drawCentered("VICTORY!", 40, &FreeMonoBold18pt8b);
         display.drawLine(40, 55, 280, 55, GxEPD_BLACK);
 
-        display.setFont(&FreeMono9pt8b);
+        GLYPHS().setFont(&FreeMono9pt8b);
         display.setCursor(50, 80);
-        display.print("Defeated: " + String(currentEnemy.name));
+        GLYPHS().print("Defeated: " + String(currentEnemy.name));
         display.setCursor(50, 105);
-        display.print("XP: +" + String(combatXpGain));
+        GLYPHS().print("XP: +" + String(combatXpGain));
         display.setCursor(50, 125);
-        display.print("Gold: +" + String(combatGoldGain));
+        GLYPHS().print("Gold: +" + String(combatGoldGain));
 
         if (combatDropId > 0) {
           Item drop;
           if (loadItemById(combatDropId, drop)) {
             display.setCursor(50, 145);
-            display.print("Found: " + String(drop.name));
+            GLYPHS().print("Found: " + String(drop.name));
           }
         }
 
         display.setCursor(50, 175);
-        display.print("XP: " + String(player.xp) + "/" + String(player.xpNext));
+        GLYPHS().print("XP: " + String(player.xp) + "/" + String(player.xpNext));
 
         EINK().drawStatusBar("Any key:Continue");
         EINK().refresh();
@@ -2605,22 +3468,22 @@ void einkHandler_APP() {
         display.drawLine(40, 55, 280, 55, GxEPD_BLACK);
 
         clearArea(40, 60, 240, 145);
-        display.setFont(&FreeMono9pt8b);
+        GLYPHS().setFont(&FreeMono9pt8b);
         display.setCursor(60, 80);
-        display.print("Level " + String(player.level) + "!");
+        GLYPHS().print("Level " + String(player.level) + "!");
         display.setCursor(60, 105);
-        display.print("HP  +" + String(lvGainHp) + "  -> " + String(player.maxHp));
+        GLYPHS().print("HP  +" + String(lvGainHp) + "  -> " + String(player.maxHp));
         display.setCursor(60, 123);
-        display.print("MP  +" + String(lvGainMp) + "  -> " + String(player.maxMp));
+        GLYPHS().print("MP  +" + String(lvGainMp) + "  -> " + String(player.maxMp));
         display.setCursor(60, 141);
-        display.print("ATK +" + String(lvGainAtk) + "  -> " + String(player.atk));
+        GLYPHS().print("ATK +" + String(lvGainAtk) + "  -> " + String(player.atk));
         display.setCursor(60, 159);
-        display.print("DEF +" + String(lvGainDef) + "  -> " + String(player.def));
+        GLYPHS().print("DEF +" + String(lvGainDef) + "  -> " + String(player.def));
         display.setCursor(60, 177);
-        display.print("MAG +" + String(lvGainMag) + "  -> " + String(player.mag));
+        GLYPHS().print("MAG +" + String(lvGainMag) + "  -> " + String(player.mag));
         if (lvGainSpd > 0) {
           display.setCursor(60, 195);
-          display.print("SPD +" + String(lvGainSpd) + "  -> " + String(player.spd));
+          GLYPHS().print("SPD +" + String(lvGainSpd) + "  -> " + String(player.spd));
         }
 
         EINK().drawStatusBar("Any key:Continue");
@@ -2641,18 +3504,18 @@ void einkHandler_APP() {
         drawCentered("TREASURE!", 50, &FreeMonoBold18pt8b);
         display.drawLine(60, 65, 260, 65, GxEPD_BLACK);
 
-        display.setFont(&FreeMono9pt8b);
+        GLYPHS().setFont(&FreeMono9pt8b);
         if (treasureItemId > 0) {
           Item item;
           if (loadItemById(treasureItemId, item)) {
             display.setCursor(80, 110);
-            display.print("Found: " + String(item.name));
+            GLYPHS().print("Found: " + String(item.name));
             display.setCursor(80, 135);
-            display.print("x" + String(treasureQty));
+            GLYPHS().print("x" + String(treasureQty));
           }
         } else {
           display.setCursor(80, 110);
-          display.print("Found some gold!");
+          GLYPHS().print("Found some gold!");
         }
 
         EINK().drawStatusBar("Any key:Continue");
@@ -2674,11 +3537,11 @@ void einkHandler_APP() {
         clearArea(30, 55, 260, 45);
         drawCentered("GAME OVER", 80, &FreeMonoBold24pt8b);
         clearArea(30, 110, 260, 60);
-        display.setFont(&FreeMono9pt8b);
+        GLYPHS().setFont(&FreeMono9pt8b);
         display.setCursor(80, 130);
-        display.print("Your journey ends...");
+        GLYPHS().print("Your journey ends...");
         display.setCursor(80, 160);
-        display.print("Level " + String(player.level) + " | " + String(player.xp) + " XP");
+        GLYPHS().print("Level " + String(player.level) + " | " + String(player.xp) + " XP");
 
         EINK().drawStatusBar("Any key:Title Screen");
         EINK().refresh();
@@ -3,6 +3,8 @@
 #include <ESP32-targz.h>
 #include <Update.h>
 #include "esp_ota_ops.h"
+#include "io_session.h"
+#include "record_store.h"
 
 
 #define APP_DIRECTORY   "/apps"
@@ -172,7 +174,7 @@ bool loadAppInfo(int otaIndex, AppInfo &info) {
 }
 
 void loadAndDrawAppIcon(int x, int y, int otaIndex, bool showName, int maxNameChars) {
-  pocketmage::setCpuSpeed(240);
+  IoSession io; // closed on every return below
 
 	AppInfo app;
 	if (!loadAppInfo(otaIndex, app)) return;
@@ -209,8 +211,6 @@ void loadAndDrawAppIcon(int x, int y, int otaIndex, bool showName, int maxNameCh
     display.setCursor(tx, ty);
     display.print(appNameStr);
 	}
-
-  if (SAVE_POWER) pocketmage::setCpuSpeed(POWER_SAVE_FREQ);
 }
 
 void cleanupAppsTemp(String binPath) {
@@ -263,7 +263,7 @@ struct InstallTaskParams {
 };
 
 static void installTask(void *param) {
-	pocketmage::setCpuSpeed(240);
+	IOSESSION().begin();
 
 	InstallTaskParams *p = (InstallTaskParams *)param;
 	g_installProgress = 0;
@@ -276,7 +276,7 @@ static void installTask(void *param) {
 	// --- Check TAR exists ---
 	if (!SD_MMC.exists(tarPath.c_str())) {
 		Serial.printf("Tar not found: %s\n", tarPath.c_str());
-    if (SAVE_POWER) pocketmage::setCpuSpeed(POWER_SAVE_FREQ);
+    IOSESSION().end();
 		g_installFailed = true;
 		g_installDone = true;
 		delete p;
@@ -288,7 +288,7 @@ static void installTask(void *param) {
 		//!rmRF(SD_MMC, TEMP_DIR) ||
 		!ensureDir(SD_MMC, TEMP_DIR)) {
 		Serial.println("Failed to prepare TEMP_DIR");
-    if (SAVE_POWER) pocketmage::setCpuSpeed(POWER_SAVE_FREQ);
+    IOSESSION().end();
 		g_installFailed = true;
 		g_installDone = true;
 		delete p;
@@ -305,7 +305,7 @@ static void installTask(void *param) {
 	if (!unpacker.tarExpander(SD_MMC, tarPath.c_str(), SD_MMC, TEMP_DIR)) {
 		Serial.printf("Extraction failed (err=%d)\n", unpacker.tarGzGetError());
 
-    if (SAVE_POWER) pocketmage::setCpuSpeed(POWER_SAVE_FREQ);
+    IOSESSION().end();
 
 		g_installFailed = true;
 		g_installDone = true;
@@ -357,6 +357,7 @@ if (tempRoot && tempRoot.isDirectory()) {
 
 if (binPath.length() == 0 || base.length() == 0) {
     Serial.printf("Bin not found after extraction in %s\n", TEMP_DIR);
+    IOSESSION().end();
     g_installFailed = true;
     g_installDone = true;
     delete p;
@@ -404,7 +405,7 @@ if (tempRoot && tempRoot.isDirectory()) {
 if (binPath.length() == 0 || !SD_MMC.exists(binPath.c_str())) {
     Serial.printf("Bin not found after extraction: %s\n", binPath.c_str());
     cleanupAppsTempRecursive(SD_MMC, TEMP_DIR);
-    if (SAVE_POWER) pocketmage::setCpuSpeed(POWER_SAVE_FREQ);
+    IOSESSION().end();
     g_installFailed = true;
     g_installDone = true;
     delete p;
@@ -425,7 +426,7 @@ if (SD_MMC.exists(assetsSrc.c_str())) {
         g_installFailed = true;
         g_installDone = true;
         cleanupAppsTempRecursive(SD_MMC, TEMP_DIR);
-            if (SAVE_POWER) pocketmage::setCpuSpeed(POWER_SAVE_FREQ);
+            IOSESSION().end();
         delete p;
         vTaskDelete(NULL);
     }
@@ -442,7 +443,7 @@ if (SD_MMC.exists(assetsSrc.c_str())) {
 		Serial.printf("OTA_%d partition not found\n", p->otaIndex);
 
     cleanupAppsTempRecursive(SD_MMC, TEMP_DIR);
-    if (SAVE_POWER) pocketmage::setCpuSpeed(POWER_SAVE_FREQ);
+    IOSESSION().end();
 
 		g_installFailed = true;
 		g_installDone = true;
@@ -455,7 +456,7 @@ if (SD_MMC.exists(assetsSrc.c_str())) {
 		Serial.printf("Failed to open: %s\n", binPath.c_str());
 
     cleanupAppsTempRecursive(SD_MMC, TEMP_DIR);
-    if (SAVE_POWER) pocketmage::setCpuSpeed(POWER_SAVE_FREQ);
+    IOSESSION().end();
 
 		g_installFailed = true;
 		g_installDone = true;
@@ -474,7 +475,7 @@ if (SD_MMC.exists(assetsSrc.c_str())) {
 		f.close();
     
     cleanupAppsTempRecursive(SD_MMC, TEMP_DIR);
-    if (SAVE_POWER) pocketmage::setCpuSpeed(POWER_SAVE_FREQ);
+    IOSESSION().end();
 
 		g_installFailed = true;
 		g_installDone = true;
@@ -493,7 +494,7 @@ if (SD_MMC.exists(assetsSrc.c_str())) {
 			f.close();
 
       cleanupAppsTempRecursive(SD_MMC, TEMP_DIR);
-        if (SAVE_POWER) pocketmage::setCpuSpeed(POWER_SAVE_FREQ);
+        IOSESSION().end();
 
 			g_installFailed = true;
 			g_installDone = true;
@@ -533,7 +534,7 @@ if (iconPath.length() == 0) {
 	}
 
   cleanupAppsTempRecursive(SD_MMC, TEMP_DIR);
-  if (SAVE_POWER) pocketmage::setCpuSpeed(POWER_SAVE_FREQ);
+  IOSESSION().end();
 
 	g_installProgress = 100;
 	g_installDone = true;
@@ -585,6 +586,7 @@ void rebootToAppSlot(int otaIndex) {
     return;
   }
   Serial.printf("Rebooting to OTA_%d...\n", otaIndex);
+  flushRecordStores(true);
   delay(100); // allow Serial to flush
   esp_restart(); // immediate reboot
 }
@@ -1,5 +1,7 @@
 
 #include <globals.h>
+#include "glyph_cache.h"
+#include "sys_tables.h"
 #if !OTA_APP // POCKETMAGE_OS
 static constexpr const char* TAG = "CALENDAR"; // Tag for all calls to ESP_LOG
 
@@ -27,6 +29,7 @@ String newEventNote = "";
 
 std::vector<std::vector<String>> dayEvents;
 std::vector<std::vector<String>> calendarEvents;
+std::vector<uint16_t> calendarEventIds;   // EVENTSTORE() id for each calendarEvents row
 
 void CALENDAR_INIT() {
   currentLine = "";
@@ -39,53 +42,30 @@ void CALENDAR_INIT() {
 }
 
 // Event Data Management
-// 
-#pragma message "TODO: Migrate to a better/global file management system"
+// Events live in EVENTSTORE(); calendarEvents is a date-sorted string view of it
+// that is only rebuilt when the table changes, so month rendering (which asks
+// for every day) never touches the SD card.
 void updateEventArray() {
-  SDActive = true;
-  pocketmage::setCpuSpeed(240);
-  delay(50);
+  static uint32_t viewRev = 0;
+  static bool viewValid = false;
 
-  File file = SD_MMC.open("/sys/events.txt", "r"); // Open the text file in read mode
-  if (!file) {
-    ESP_LOGE(TAG, "Failed to open file for reading: %s", file.path());
-    return;
+  if (!EVENTSTORE().load()) {
+    ESP_LOGE(TAG, "Failed to load event store");
   }
-
-  calendarEvents.clear(); // Clear the existing vector before loading the new data
-
-  // Loop through the file, line by line
-  while (file.available()) {
-    String line = file.readStringUntil('\n');  // Read a line from the file
-    line.trim();  // Remove any extra spaces or newlines
-    
-    // Skip empty lines
-    if (line.length() == 0) {
-      continue;
-    }
-
-    // Split the line into individual parts using the delimiter '|'
-    uint8_t delimiterPos1 = line.indexOf('|');
-    uint8_t delimiterPos2 = line.indexOf('|', delimiterPos1 + 1);
-    uint8_t delimiterPos3 = line.indexOf('|', delimiterPos2 + 1);
-    uint8_t delimiterPos4 = line.indexOf('|', delimiterPos3 + 1);
-    uint8_t delimiterPos5 = line.indexOf('|', delimiterPos4 + 1);
-
-    String eventName  = line.substring(0, delimiterPos1);
-    String startDate   = line.substring(delimiterPos1 + 1, delimiterPos2);
-    String startTime  = line.substring(delimiterPos2 + 1, delimiterPos3);
-    String duration = line.substring(delimiterPos3 + 1, delimiterPos4);
-    String repeat = line.substring(delimiterPos4 + 1, delimiterPos5);
-    String note = line.substring(delimiterPos5 + 1);
-
-    // Add the event to the vector
-    calendarEvents.push_back({eventName, startDate, startTime, duration, repeat, note});
+  if (viewValid && viewRev == EVENTSTORE().revision()) return;
+  viewRev = EVENTSTORE().revision();
+  viewValid = true;
+
+  calendarEvents.clear();
+  calendarEventIds.clear();
+  calendarEvents.reserve(EVENTSTORE().size());
+  calendarEventIds.reserve(EVENTSTORE().size());
+  for (size_t i = 0; i < EVENTSTORE().size(); i++) {
+    const EventRecord& rec = EVENTSTORE().at(i);
+    calendarEvents.push_back({String(rec.name), String(rec.date), String(rec.time),
+                              String(rec.duration), String(rec.repeat), String(rec.note)});
+    calendarEventIds.push_back(rec.id);
   }
-
-  file.close();  // Close the file
-
-  if (SAVE_POWER) pocketmage::setCpuSpeed(POWER_SAVE_FREQ);
-  SDActive = false;
 }
 
 void sortEventsByDate(std::vector<std::vector<String>> &calendarEvents) {
@@ -94,37 +74,41 @@ void sortEventsByDate(std::vector<std::vector<String>> &calendarEvents) {
   });
 }
 
+// Commit pending event edits now instead of waiting for the idle flush
 void updateEventsFile() {
-  SDActive = true;
-  pocketmage::setCpuSpeed(240);
-  delay(50);
-  // Clear the existing calendarEvents file first
-  SD().delFile("/sys/events.txt");
+  EVENTSTORE().flush();
+}
+
+static void fillEventRecord(EventRecord& rec, const std::vector<String>& event) {
+  setField(rec.name,     event[0]);
+  setField(rec.date,     event[1]);
+  setField(rec.time,     event[2]);
+  setField(rec.duration, event[3]);
+  setField(rec.repeat,   event[4]);
+  setField(rec.note,     event[5]);
+}
 
-  // Iterate through the calendarEvents vector and append each task to the file
+// Store id of the first calendarEvents row equal to event, 0 if none
+static uint16_t findEventId(const std::vector<String>& event) {
+  updateEventArray();
   for (size_t i = 0; i < calendarEvents.size(); i++) {
-    // Create a string from the task's attributes with "|" delimiter
-    String eventInfo = calendarEvents[i][0] + "|" + calendarEvents[i][1] + "|" + calendarEvents[i][2] + "|" + calendarEvents[i][3]+ "|" + calendarEvents[i][4]+ "|" + calendarEvents[i][5];
-    
-    // Append the task info to the file
-    SD().appendToFile("/sys/events.txt", eventInfo);
+    if (calendarEvents[i] == event) return calendarEventIds[i];
   }
-
-  if (SAVE_POWER) pocketmage::setCpuSpeed(POWER_SAVE_FREQ);
-  SDActive = false;
+  return 0;
 }
 
 void addEvent(String eventName, String startDate, String startTime , String duration, String repeat, String note) {
-  String eventInfo = eventName+"|"+startDate+"|"+startTime +"|"+duration+"|"+repeat+"|"+note;
+  EventRecord rec = {};
+  fillEventRecord(rec, {eventName, startDate, startTime, duration, repeat, note});
+  EVENTSTORE().add(rec);
   updateEventArray();
-  calendarEvents.push_back({eventName, startDate, startTime , duration, repeat, note});
-  sortEventsByDate(calendarEvents);
-  updateEventsFile();
 }
 
 void deleteEvent(int index) {
+  updateEventArray();
   if (index >= 0 && index < calendarEvents.size()) {
-    calendarEvents.erase(calendarEvents.begin() + index);
+    EVENTSTORE().remove(calendarEventIds[index]);
+    updateEventArray();
   }
 }
 
@@ -135,12 +119,11 @@ void deleteEventByIndex(int indexToDelete) {
     // Remove from dayEvents
     dayEvents.erase(dayEvents.begin() + indexToDelete);
 
-    // Remove matching event from calendarEvents
-    for (int i = 0; i < calendarEvents.size(); i++) {
-      if (calendarEvents[i] == targetEvent) {
-        calendarEvents.erase(calendarEvents.begin() + i);
-        break;  // Only remove the first match
-      }
+    // Remove the first matching event from the store
+    uint16_t id = findEventId(targetEvent);
+    if (id) {
+      EVENTSTORE().remove(id);
+      updateEventArray();
     }
   }
 }
@@ -162,12 +145,14 @@ void updateEventByIndex(int indexToUpdate) {
     // Update dayEvents
     dayEvents[indexToUpdate] = updatedEvent;
 
-    // Find and update matching event in calendarEvents
-    for (int i = 0; i < calendarEvents.size(); i++) {
-      if (calendarEvents[i] == oldEvent) {
-        calendarEvents[i] = updatedEvent;
-        break;  // Stop after first match
-      }
+    // Update the first matching event in the store
+    uint16_t id = findEventId(oldEvent);
+    if (id) {
+      EventRecord rec = {};
+      rec.id = id;
+      fillEventRecord(rec, updatedEvent);
+      EVENTSTORE().update(rec);
+      updateEventArray();
     }
   }
 }
@@ -762,13 +747,13 @@ void drawCalendarMonth(int monthOffset) {
 
     // Current day
     if (dayNum == now.day() && monthOffset == 0) {
-      display.setFont(&FreeSerifBold9pt7b);
+      GLYPHS().setFont(&FreeSerifBold9pt7b);
     }
-    else display.setFont(&FreeSerif9pt7b);
+    else GLYPHS().setFont(&FreeSerif9pt7b);
     
     display.setTextColor(GxEPD_BLACK);
     display.setCursor(x + 6, y + 15); 
-    display.print(dayNum);
+    GLYPHS().print(dayNum);
 
     // Draw icon if there are events on day
 
@@ -784,9 +769,9 @@ void drawCalendarMonth(int monthOffset) {
 
     // Events found
     if (numEvents > 2) {
-      display.setFont(&Font5x7Fixed);
+      GLYPHS().setFont(&Font5x7Fixed);
       display.setCursor(x + 32, y + 16);
-      display.print(String(numEvents));
+      GLYPHS().print(String(numEvents));
     }
     else if (numEvents > 1) {
       // More than 1 event
@@ -847,11 +832,11 @@ void drawCalendarWeek(int weekOffset) {
                       (d < 10 ? "0" : "") + String(d);*/
 
     // Draw date
-    display.setFont(&FreeSerif9pt7b);
+    GLYPHS().setFont(&FreeSerif9pt7b);
     display.setTextColor(GxEPD_BLACK);
     display.setCursor(9 + (i * 44), 62);
     String dateStr = String(m) + "/" + String(d);
-    display.print(dateStr);
+    GLYPHS().print(dateStr);
 
     // Load and draw events
     int eventCount = checkEvents(YYYYMMDD, false);
@@ -867,15 +852,15 @@ void drawCalendarWeek(int weekOffset) {
       String eventName = dayEvents[j][0].substring(0, 6);
 
       // Print Start Time
-      display.setFont(&Font3x7FixedNum);
+      GLYPHS().setFont(&Font3x7FixedNum);
       display.setTextColor(GxEPD_BLACK);
       display.setCursor(12 + (i * 44), 80 + (j * 23));
-      display.print(startTime);
+      GLYPHS().print(startTime);
 
       // Print Event Name
-      display.setFont(&Font5x7Fixed);
+      GLYPHS().setFont(&Font5x7Fixed);
       display.setCursor(12 + (i * 44), 89 + (j * 23));
-      display.print(eventName);
+      GLYPHS().print(eventName);
     }
   }
 }
@@ -1610,25 +1595,25 @@ void einkHandler_CALENDAR() {
 
         display.drawBitmap(0, 0, calendar_allArray[2], 320, 218, GxEPD_BLACK);
 
-        display.setFont(&FreeSerif9pt7b);
+        GLYPHS().setFont(&FreeSerif9pt7b);
 
         display.setCursor(106, 68);
-        display.print(newEventName);
+        GLYPHS().print(newEventName);
 
         display.setCursor(106, 90);
-        display.print(newEventStartDate);
+        GLYPHS().print(newEventStartDate);
 
         display.setCursor(106, 112);
-        display.print(newEventStartTime);
+        GLYPHS().print(newEventStartTime);
 
         display.setCursor(106, 134);
-        display.print(newEventDuration);
+        GLYPHS().print(newEventDuration);
         
         display.setCursor(106, 156);
-        display.print(newEventRepeat);
+        GLYPHS().print(newEventRepeat);
 
         display.setCursor(106, 178);
-        display.print(newEventNote);
+        GLYPHS().print(newEventNote);
 
         EINK().forceSlowFullUpdate(true);
         EINK().refresh();
@@ -1649,25 +1634,25 @@ void einkHandler_CALENDAR() {
         }
         display.drawBitmap(0, 0, calendar_allArray[3], 320, 218, GxEPD_BLACK);
 
-        display.setFont(&FreeSerif9pt7b);
+        GLYPHS().setFont(&FreeSerif9pt7b);
 
         display.setCursor(106, 68);
-        display.print(newEventName);
+        GLYPHS().print(newEventName);
 
         display.setCursor(106, 90);
-        display.print(newEventStartDate);
+        GLYPHS().print(newEventStartDate);
 
         display.setCursor(106, 112);
-        display.print(newEventStartTime);
+        GLYPHS().print(newEventStartTime);
 
         display.setCursor(106, 134);
-        display.print(newEventDuration);
+        GLYPHS().print(newEventDuration);
         
         display.setCursor(106, 156);
-        display.print(newEventRepeat);
+        GLYPHS().print(newEventRepeat);
 
         display.setCursor(106, 178);
-        display.print(newEventNote);
+        GLYPHS().print(newEventNote);
 
         EINK().forceSlowFullUpdate(true);
         EINK().refresh();
@@ -1692,11 +1677,11 @@ void einkHandler_CALENDAR() {
         display.drawBitmap(0, 0, calendar_allArray[CurrentCalendarState], 320, 218, GxEPD_BLACK);
 
         // Draw Date
-        display.setFont(&FreeSerif9pt7b);
+        GLYPHS().setFont(&FreeSerif9pt7b);
         display.setTextColor(GxEPD_BLACK);
         // Set cursor based on the day of the week
         display.setCursor(9 + (44*(CurrentCalendarState - 4)), 59);
-        display.print(String(currentMonth) + "/" + String(currentDate));
+        GLYPHS().print(String(currentMonth) + "/" + String(currentDate));
 
         // Load events
         String YYYYMMDD = intToYYYYMMDD(currentYear, currentMonth, currentDate);
@@ -1715,14 +1700,14 @@ void einkHandler_CALENDAR() {
           String bottomInfo = "Starts: " + startTime + ", Dur: " + duration + ", Rep: " + repeatCode;
 
           // Print event name
-          display.setFont(&Font5x7Fixed);
+          GLYPHS().setFont(&Font5x7Fixed);
           display.setCursor(48, 74 + (j * 19));
-          display.print(name);
+          GLYPHS().print(name);
 
           // Print bottom info
-          display.setFont(&Font5x7Fixed);
+          GLYPHS().setFont(&Font5x7Fixed);
           display.setCursor(48, 82 + (j * 19));
-          display.print(bottomInfo);
+          GLYPHS().print(bottomInfo);
         }
 
         EINK().forceSlowFullUpdate(true);
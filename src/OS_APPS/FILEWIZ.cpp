@@ -7,6 +7,10 @@
 //  o888o        o888o o888ooooood8 o888ooooood8       `8'      `8'       o888o .8888888888P   //
 
 #include <globals.h>
+#include "io_session.h"
+#include "dir_cache.h"
+#include "file_index.h"
+#include "edit_journal.h"
 #if !OTA_APP // POCKETMAGE_OS
 
 enum FileWizState { WIZ0_, WIZ1_, WIZ1_YN, WIZ2_R, WIZ2_C, WIZ3_ };
@@ -32,120 +36,30 @@ void FILEWIZ_INIT() {
 }
 
 // OLED file display
-struct FileObject {
-  String address;    // Full path, e.g. "/files/test.txt"
-  String name;       // Base name without extension, e.g. "test"
-  String extension;  // Extension including dot, e.g. ".txt"
-  char type;         // 'T' = txt, 'F' = folder, 'G' = other, 'A' = app (.tar)
-
-  void init(const String &path, bool isDirectory) {
-    address = path;
-
-    if (isDirectory) {
-      type = 'F';
-      name = path.substring(path.lastIndexOf('/') + 1);
-      extension = "";
-      return;
-    }
-
-    // Extract filename
-    String filename = path.substring(path.lastIndexOf('/') + 1);
-
-    // Split into name + extension
-    int dot = filename.lastIndexOf('.');
-    if (dot > 0) {
-      name = filename.substring(0, dot);
-      extension = filename.substring(dot); // includes the dot
-    } else {
-      name = filename;
-      extension = "";
-    }
-
-    // Determine type
-    if (extension.equalsIgnoreCase(".txt")) {
-      type = 'T';
-    } else if (extension.equalsIgnoreCase(".tar")) {
-      type = 'A';
-    } else {
-      type = 'G';
-    }
-  }
-};
-
 String renderWizMini(String folder, int8_t scrollDelta) {
   static long scroll = 0;
   static String prevFolder = "";
-  static std::vector<FileObject> cachedFiles;
-
-  // Reload directory if folder changed
-  if (folder != prevFolder) {
-    SDActive = true;
-    pocketmage::setCpuSpeed(240);
-
-    scroll = 0;
-    scrollDelta = 0;
-    cachedFiles.clear();
-
-    File dir = SD_MMC.open(folder);
-    if (dir && dir.isDirectory()) {
-      File entry;
-      while ((entry = dir.openNextFile())) {
-        // Normalize full path
-        String fullPath = folder;
-        if (!fullPath.endsWith("/")) fullPath += "/";
-        fullPath += entry.name();
-
-        // Skip folder itself if in excludedPaths
-        bool skip = false;
-        for (auto &ex : excludedPaths) {
-          if (fullPath.equalsIgnoreCase(ex)) {
-            skip = true;
-            break;
-          }
-        }
-        if (skip) {
-          entry.close();
-          continue;
-        }
+  static size_t fileCount = 0;
 
-        FileObject f;
-        f.init(fullPath, entry.isDirectory());
-        cachedFiles.push_back(f);
-        entry.close();
-      }
+  // Reload directory if folder changed or a file was changed. The cache only
+  // rescans when the folder is not cached or its listing is out of date.
+  if (refreshFiles) {
+    DIRCACHE().invalidateAll();
+  }
+  if (folder != prevFolder || refreshFiles) {
+    if (folder != prevFolder) {
+      scroll = 0;
+      scrollDelta = 0;
     }
-    dir.close();
-
-    // Sort: folders first (alphabetical), then files (alphabetical)
-    std::sort(cachedFiles.begin(), cachedFiles.end(), [](const FileObject &a, const FileObject &b) {
-      if (a.type == 'F' && b.type != 'F') return true;
-      if (a.type != 'F' && b.type == 'F') return false;
-      return a.name.compareTo(b.name) < 0;
-    });
+    fileCount = DIRCACHE().open(folder);
+    if (scroll >= (long)fileCount) scroll = fileCount ? fileCount - 1 : 0;
 
     prevFolder = folder;
-
-    if (SAVE_POWER)
-    pocketmage::setCpuSpeed(POWER_SAVE_FREQ);
-    SDActive = false;
+    refreshFiles = false;
   }
 
-  #pragma message "TODO: Need to refresh directory here."
-  // Reload directory if file changed
-  /*if (refreshFiles) {
-    SDActive = true;
-    pocketmage::setCpuSpeed(240);
-    delay(50);
-
-    // reload here
-
-    if (SAVE_POWER)
-    pocketmage::setCpuSpeed(POWER_SAVE_FREQ);
-    SDActive = false;
-  }*/
-
   // Empty folder
-  if (cachedFiles.empty()) {
+  if (fileCount == 0) {
     String msg = folder + " is empty!";
     OLED().oledWord(msg);
     return "";
@@ -153,31 +67,31 @@ String renderWizMini(String folder, int8_t scrollDelta) {
 
   // Clamp scroll
   if ((scroll + scrollDelta) < 0) scroll = 0;
-  else if ((scroll + scrollDelta) >= (long)cachedFiles.size()) scroll = cachedFiles.size() - 1;
+  else if ((scroll + scrollDelta) >= (long)fileCount) scroll = fileCount - 1;
   else scroll += scrollDelta;
 
   // Display Icons
   u8g2.clearBuffer();
   const int maxDisplay = 14;
-  for (size_t i = scroll; i < cachedFiles.size() && i < scroll + maxDisplay; i++) {
-    FileObject &f = cachedFiles[i];
+  for (size_t i = scroll; i < fileCount && i < scroll + maxDisplay; i++) {
+    char type = DIRCACHE().type(i);
 
     // Big icon for first visible
     if (i == scroll) {
-      switch (f.type) {
+      switch (type) {
         case 'T': u8g2.drawXBMP(1, 1, 30, 30, _LFileIcons[0]); break;
         case 'F': u8g2.drawXBMP(1, 1, 30, 30, _LFileIcons[1]); break;
         case 'A': u8g2.drawXBMP(1, 1, 30, 30, _LFileIcons[2]); break;
         default:  u8g2.drawXBMP(1, 1, 30, 30, _LFileIcons[3]); break;
       }
-      String dispName = f.name + f.extension;
+      String dispName = DIRCACHE().name(i) + DIRCACHE().extension(i);
       //u8g2.setFont(u8g2_font_helvB14_tf);
       u8g2.setFont(u8g2_font_7x13B_tf);
       u8g2.drawStr(34,29,dispName.c_str());
     }
     else {
       int x = 34 + 18 * (i - scroll - 1);
-      switch (f.type) {
+      switch (type) {
         case 'T': u8g2.drawXBMP(x, 1, 15, 15, _SFileIcons[0]); break;
         case 'F': u8g2.drawXBMP(x, 1, 15, 15, _SFileIcons[1]); break;
         case 'A': u8g2.drawXBMP(x, 1, 15, 15, _SFileIcons[2]); break;
@@ -211,7 +125,7 @@ String renderWizMini(String folder, int8_t scrollDelta) {
 
   u8g2.sendBuffer();
 
-  return cachedFiles[scroll].address;
+  return DIRCACHE().path(scroll);
 }
 
 String fileWizardMini(bool allowRecentSelect, String rootDir) {
@@ -420,6 +334,8 @@ void processKB_FILEWIZ() {
         else if (inchar == 'y' || inchar == 'Y') {
           // DELETE FILE
           SD().delFile(SD().getWorkingFile());
+          fileDeleted(SD().getWorkingFile());
+          EDITJOURNAL().remove(SD().getWorkingFile());
           
           // RETURN TO FILE WIZ HOME
           refreshFiles = true;
@@ -498,7 +414,10 @@ void processKB_FILEWIZ() {
         else if (inchar == 13) {      
           // RENAME FILE                    
           String newName = "/" + currentWord + ".txt";
-          SD().renFile(SD().getWorkingFile(), newName);
+          String oldName = SD().getWorkingFile();
+          SD().renFile(oldName, newName);
+          fileDeleted(oldName);
+          fileWritten(newName);
 
           // RETURN TO WIZ0
           refreshFiles = true;
@@ -581,6 +500,7 @@ void processKB_FILEWIZ() {
           // Copy FILE                    
           String newName = "/" + currentWord + ".txt";
           SD().copyFile(SD().getWorkingFile(), newName);
+          fileWritten(newName);
 
           // RETURN TO WIZ0
           refreshFiles = true;
@@ -8,6 +8,9 @@
 
 #include <globals.h>
 #include "esp_log.h"
+#include "record_store.h"
+#include "file_index.h"
+#include "text_index.h"
 
 #define IDLE_TIME 20000 // time to wait for idle (ms)
 #if !OTA_APP // POCKETMAGE_OS
@@ -17,6 +20,11 @@ static int prevTime = 0;
 long lastInput = 0;
 static int cursor_pos = 0;
 
+// Results of the last "search" command, shown instead of the app grid
+static std::vector<SearchHit> searchHits;
+static String searchQuery = "";
+static bool showSearch = false;
+
 void HOME_INIT() {
   CurrentAppState = HOME;
   currentLine     = "";
@@ -27,47 +35,165 @@ void HOME_INIT() {
   //frames.push_back(&testTextScreen);
 }
 
+// Quick-open commands: "-name" opens in the file wizard, "/name" in the editor
+static bool isQuickOpen(const String& line) {
+  return line.startsWith("-") || line.startsWith("/");
+}
+
+static String quickOpenQuery(String line) {
+  line = removeChar(line, ' ');
+  return line.substring(1);
+}
+
+// Exact name (or name.txt) first, otherwise the first name with that prefix
+static String quickOpenPath(const String& line) {
+  String query = quickOpenQuery(line);
+  if (query.length() == 0) return "";
+
+  String path = FILEINDEX().find(query);
+  if (path == "") FILEINDEX().complete(query, &path, 1);
+  return path;
+}
+
+// Typed command on top, best match and further completions below
+static void drawQuickOpen() {
+  const size_t maxHits = 4;
+  String hits[maxHits];
+  String query = quickOpenQuery(currentLine);
+  size_t n = query.length() ? FILEINDEX().complete(query, hits, maxHits) : 0;
+
+  u8g2.clearBuffer();
+  u8g2.setFont(u8g2_font_7x13B_tf);
+  u8g2.drawStr(0, 12, currentLine.c_str());
+  int cursorX = u8g2.getStrWidth(currentLine.substring(0, cursor_pos).c_str());
+  u8g2.drawVLine(cursorX, 1, 12);
+
+  u8g2.setFont(u8g2_font_5x7_tf);
+  if (n == 0) {
+    const char* status = FILEINDEX().walking() ? "Indexing files..." : "No match";
+    if (query.length()) u8g2.drawStr(0, 22, status);
+  }
+  else {
+    String best = "> " + hits[0];
+    u8g2.drawStr(0, 22, best.c_str());
+
+    String more = "";
+    for (size_t i = 1; i < n; i++) {
+      if (i > 1) more += "  ";
+      more += hits[i].substring(hits[i].lastIndexOf('/') + 1);
+    }
+    u8g2.drawStr(0, 31, more.c_str());
+  }
+  u8g2.sendBuffer();
+}
+
+// "search words", "find words" or "?words"
+static bool isSearch(const String& command, String& query) {
+  String lower = command;
+  lower.toLowerCase();
+  if (lower.startsWith("?"))            query = command.substring(1);
+  else if (lower.startsWith("search ")) query = command.substring(7);
+  else if (lower.startsWith("find "))   query = command.substring(5);
+  else return false;
+  query.trim();
+  return true;
+}
+
+static void runSearch(const String& query) {
+  if (query.length() == 0) return;
+  OLED().oledWord("Searching...");
+
+  unsigned long start = millis();
+  TEXTINDEX().search(query, searchHits);
+  ESP_LOGI("HOME", "Search \"%s\": %u hits in %lu ms", query.c_str(), (unsigned)searchHits.size(), millis() - start);
+
+  if (searchHits.empty()) {
+    OLED().oledWord(TEXTINDEX().busy() ? "No results yet, still indexing" : "No results");
+    delay(1500);
+    return;
+  }
+  searchQuery = query;
+  showSearch = true;
+  newState = true;
+}
+
+void drawSearchResults() {
+  EINK().resetDisplay();
+
+  display.setFont(&FreeMonoBold9pt7b);
+  display.setCursor(6, 16);
+  display.print(("Search: " + searchQuery).c_str());
+
+  for (size_t i = 0; i < searchHits.size(); i++) {
+    int y = 40 + (24 * i);
+    String name = searchHits[i].path.substring(searchHits[i].path.lastIndexOf('/') + 1);
+    if (name.endsWith(".txt")) name.remove(name.length() - 4);
+
+    // NUMBER AND FILE NAME
+    display.setFont(&FreeMonoBold9pt7b);
+    display.setCursor(6, y);
+    display.print((String(i + 1) + " " + name).c_str());
+
+    // MATCHING LINE, cut to the remaining width
+    int x = display.getCursorX() + 8;
+    String snippet = searchHits[i].snippet;
+    int16_t x1, y1;
+    uint16_t w, h;
+    display.setFont(&FreeSerif9pt7b);
+    display.getTextBounds(snippet.c_str(), 0, 0, &x1, &y1, &w, &h);
+    while (snippet.length() > 0 && x + w > display.width() - 6) {
+      snippet.remove(snippet.length() - 1);
+      display.getTextBounds(snippet.c_str(), 0, 0, &x1, &y1, &w, &h);
+    }
+    display.setCursor(x, y);
+    display.print(snippet.c_str());
+  }
+
+  EINK().drawStatusBar("Type # to open a result:");
+}
+
 void commandSelect(String command) {
-  command.toLowerCase();
+  // OPEN SEARCH RESULT; any other command leaves the results
+  if (showSearch) {
+    showSearch = false;
+    newState = true;
+    int n = command.toInt();
+    if (n >= 1 && n <= (int)searchHits.size() && String(n) == command) {
+      SD().setEditingFile(searchHits[n - 1].path);
+      TXT_INIT();
+      return;
+    }
+  }
+
+  // FULL-TEXT SEARCH
+  String query;
+  if (isSearch(command, query)) {
+    runSearch(query);
+    return;
+  }
 
   // OPEN IN FILE WIZARD
   if (command.startsWith("-")) {
-    command = removeChar(command, ' ');
-    command = removeChar(command, '-');
-    keypad.disableInterrupts();
-    SD().listDir(SD_MMC, "/");
-    keypad.enableInterrupts();
-
-    for (uint8_t i = 0; i < MAX_FILES; i++) {
-      String lowerFileName = SD().getFilesListIndex(i);
-      lowerFileName.toLowerCase();
-      if (command == lowerFileName || (command+".txt") == lowerFileName || ("/"+command+".txt") == lowerFileName) {
-        SD().setWorkingFile(SD().getFilesListIndex(i));
-        FILEWIZ_INIT();
-        return;
-      }
+    String path = quickOpenPath(command);
+    if (path != "") {
+      SD().setWorkingFile(path);
+      FILEWIZ_INIT();
+      return;
     }
   }
 
   // OPEN IN TXT EDITOR
   if (command.startsWith("/")) {
-    command = removeChar(command, ' ');
-    command = removeChar(command, '/');
-    keypad.disableInterrupts();
-    SD().listDir(SD_MMC, "/");
-    keypad.enableInterrupts();
-
-    for (uint8_t i = 0; i < MAX_FILES; i++) {
-      String lowerFileName = SD().getFilesListIndex(i);
-      lowerFileName.toLowerCase();
-      if (command == lowerFileName || (command+".txt") == lowerFileName || ("/"+command+".txt") == lowerFileName) {
-        SD().setEditingFile(SD().getFilesListIndex(i));
-        TXT_INIT();
-        return;
-      }
+    String path = quickOpenPath(command);
+    if (path != "") {
+      SD().setEditingFile(path);
+      TXT_INIT();
+      return;
     }
   }
 
+  command.toLowerCase();
+
   // Dice Roll
   if (command.startsWith("roll d")) {
     String numStr = command.substring(6);
@@ -98,6 +224,7 @@ void commandSelect(String command) {
   
   /////////////////////////////
   else if (command == "reset") {
+    flushRecordStores(true);
     esp_restart();
   } 
   /////////////////////////////
@@ -433,6 +560,7 @@ void processKB_HOME() {
         else if (inchar == 12 ) {
           CurrentAppState = HOME;
           currentLine     = "";
+          showSearch      = false;
           newState        = true;
           KB().setKeyboardState(NORMAL);
         }
@@ -458,6 +586,17 @@ void processKB_HOME() {
         else if (inchar == 25) {
           KB().setKeyboardState(NORMAL);
         }
+        // TAB: complete a quick-open name
+        else if (inchar == 9 && isQuickOpen(currentLine)) {
+          String path = quickOpenPath(currentLine);
+          if (path != "") {
+            String name = path.substring(path.lastIndexOf('/') + 1);
+            if (name.endsWith(".txt")) name.remove(name.length() - 4);
+            currentLine = currentLine.substring(0, 1) + name;
+            cursor_pos = currentLine.length();
+          }
+          KB().setKeyboardState(NORMAL);
+        }
         // TAB, SHIFT+TAB / FN+TAB, FN+SHIFT+TAB
         else if (inchar == 9 || inchar == 14) {
           KB().setKeyboardState(NORMAL);
@@ -490,7 +629,8 @@ void processKB_HOME() {
           }
           else {
             resetIdle();
-            OLED().oledLine(currentLine, cursor_pos, false);
+            if (isQuickOpen(currentLine)) drawQuickOpen();
+            else OLED().oledLine(currentLine, cursor_pos, false);
           }
         }
       }
@@ -512,7 +652,8 @@ void einkHandler_HOME() {
     case HOME_HOME:
       if (newState) {
         newState = false;
-        drawHome();
+        if (showSearch) drawSearchResults();
+        else drawHome();
         //EINK().refresh();
         //einkFramesDynamic(frames,false);
         EINK().multiPassRefresh(1);
@@ -1,5 +1,7 @@
 
 #include <globals.h>
+#include "io_session.h"
+#include "file_index.h"
 #if !OTA_APP // POCKETMAGE_OS
 enum JournalState {J_MENU, J_TXT};
 JournalState CurrentJournalState = J_MENU;
@@ -38,9 +40,7 @@ bool isLeapYear(int year) {
 }
 
 void drawJMENU() {
-  SDActive = true;
-  pocketmage::setCpuSpeed(240);
-  delay(50);
+  IOSESSION().begin();
 
   // Display background
   EINK().drawStatusBar("Type:YYYYMMDD or (T)oday");
@@ -138,14 +138,11 @@ void drawJMENU() {
     if (SD_MMC.exists(fileCode)) display.fillRect(91 + (7 * (i - 1)), 149, 4, 4, GxEPD_BLACK);
   }
 
-  if (SAVE_POWER) pocketmage::setCpuSpeed(POWER_SAVE_FREQ);
-  SDActive = false;
+  IOSESSION().end();
 }
 
 void JMENUCommand(String command) {
-  SDActive = true;
-  pocketmage::setCpuSpeed(240);
-  delay(50);
+  IOSESSION().begin();
 
   command.toLowerCase();
 
@@ -166,12 +163,12 @@ void JMENUCommand(String command) {
     if (!SD_MMC.exists(fileName)) {
       File f = SD_MMC.open(fileName, FILE_WRITE);
       if (f) f.close();
+      fileWritten(fileName);
     }
 
     currentJournal = fileName;
 
-    if (SAVE_POWER) setCpuFrequencyMhz(POWER_SAVE_FREQ);
-    SDActive = false;
+    IOSESSION().end();
     // Load file
     TXT_INIT_JournalMode();
     
@@ -185,12 +182,12 @@ void JMENUCommand(String command) {
     if (!SD_MMC.exists(fileName)) {
       File f = SD_MMC.open(fileName, FILE_WRITE);
       if (f) f.close();
+      fileWritten(fileName);
     }
 
     currentJournal = fileName;
 
-    if (SAVE_POWER) setCpuFrequencyMhz(POWER_SAVE_FREQ);
-    SDActive = false;
+    IOSESSION().end();
     // Load file
     TXT_INIT_JournalMode();
     
@@ -206,15 +203,13 @@ void JMENUCommand(String command) {
       int day = dayStr.toInt();
 
       if (day < 1 || day > 31) {
-        if (SAVE_POWER) pocketmage::setCpuSpeed(POWER_SAVE_FREQ);
-        SDActive = false;
+        IOSESSION().end();
         return;  // invalid day
       }
       String monthMap = "janfebmaraprmayjunjulaugsepoctnovdec";
       int monthIndex = monthMap.indexOf(monthStr);
       if (monthIndex == -1) {
-        if (SAVE_POWER) pocketmage::setCpuSpeed(POWER_SAVE_FREQ);
-        SDActive = false;
+        IOSESSION().end();
         return;  // invalid month
       }
       int month = (monthIndex / 3) + 1;
@@ -227,12 +222,12 @@ void JMENUCommand(String command) {
       if (!SD_MMC.exists(fileName)) {
         File f = SD_MMC.open(fileName, FILE_WRITE);
         if (f) f.close();
+        fileWritten(fileName);
       }
 
       currentJournal = fileName;
 
-      if (SAVE_POWER) setCpuFrequencyMhz(POWER_SAVE_FREQ);
-      SDActive = false;
+      IOSESSION().end();
       // Load file
       TXT_INIT_JournalMode();
       
@@ -240,8 +235,7 @@ void JMENUCommand(String command) {
     }
   }
 
-  if (SAVE_POWER) pocketmage::setCpuSpeed(POWER_SAVE_FREQ);
-  SDActive = false;
+  IOSESSION().end();
 }
 
 // Loops
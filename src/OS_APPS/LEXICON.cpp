@@ -1,5 +1,6 @@
 
 #include <globals.h>
+#include "io_session.h"
 #if !OTA_APP  // POCKETMAGE_OS
 enum LexState { MENU, DEF };
 LexState CurrentLexState = MENU;
@@ -77,21 +78,19 @@ void LEXICON_INIT() {
   definitionIndex = 0;
 
   // Verify that dict is installed
-  pocketmage::setCpuSpeed(240);
-  delay(50);
-  if (!SD_MMC.exists("/dict/A.txt")) {
+  IOSESSION().begin();
+  bool dictInstalled = SD_MMC.exists("/dict/A.txt");
+  IOSESSION().end();
+  if (!dictInstalled) {
     OLED().oledWord("Please install dict from GitHub!");
     delay(5000);
-    pocketmage::setCpuSpeed(POWER_SAVE_FREQ);
     HOME_INIT();
   }
 }
 
 void loadDefinitions(String input) {
   OLED().oledWord("Loading Definitions");
-  SDActive = true;
-  pocketmage::setCpuSpeed(240);
-  delay(50);
+  IOSESSION().begin();
 
   defList.clear();  // Clear previous results
 
@@ -100,17 +99,13 @@ void loadDefinitions(String input) {
   String word = query.word;
 
   if (word.length() == 0 || SD().getNoSD()) {
-    SDActive = false;
-    if (SAVE_POWER)
-      pocketmage::setCpuSpeed(POWER_SAVE_FREQ);
+    IOSESSION().end();
     return;
   }
 
   char firstChar = tolower(word[0]);
   if (firstChar < 'a' || firstChar > 'z') {
-    SDActive = false;
-    if (SAVE_POWER)
-      pocketmage::setCpuSpeed(POWER_SAVE_FREQ);
+    IOSESSION().end();
     return;
   }
 
@@ -120,9 +115,7 @@ void loadDefinitions(String input) {
   if (!file) {
     OLED().oledWord("Missing Dictionary!");
     delay(2000);
-    SDActive = false;
-    if (SAVE_POWER)
-      pocketmage::setCpuSpeed(POWER_SAVE_FREQ);
+    IOSESSION().end();
     return;
   }
 
@@ -173,9 +166,7 @@ void loadDefinitions(String input) {
     newState = true;
   }
 
-  if (SAVE_POWER)
-    pocketmage::setCpuSpeed(POWER_SAVE_FREQ);
-  SDActive = false;
+  IOSESSION().end();
 }
 
 void processKB_LEXICON() {
@@ -9,6 +9,7 @@
 #include <globals.h>
 #include "esp32-hal-log.h"
 #include "esp_log.h"
+#include "sys_tables.h"
 #if !OTA_APP // POCKETMAGE_OS
 
 // ===================== POMODORO STATE DEFINITIONS =====================
@@ -60,42 +61,29 @@ const Jingle LongBreakComplete = {longBreakCompleteNotes, sizeof(longBreakComple
 
 // ===================== HELPER FUNCTIONS =====================
 
-// Load pomodoro count from SD card
+// Load pomodoro count from the record store (read from SD on first use only)
 void loadPomodoroCount() {
-  SDActive = true;
-  pocketmage::setCpuSpeed(240);
-  delay(50);
-
-  File file = SD_MMC.open("/sys/pomodoro.txt", "r");
-  if (!file) {
+  if (POMODOROSTORE().load() && POMODOROSTORE().size() > 0) {
+    pomodorosCompleted = POMODOROSTORE().at(0).completed;
+    ESP_LOGI(TAG, "Loaded pomodoro count: %d", pomodorosCompleted);
+  } else {
     ESP_LOGW(TAG, "No saved pomodoro count found, starting at 0");
     pomodorosCompleted = 0;
-    if (SAVE_POWER) pocketmage::setCpuSpeed(POWER_SAVE_FREQ);
-    SDActive = false;
-    return;
   }
-
-  String countStr = file.readStringUntil('\n');
-  pomodorosCompleted = countStr.toInt();
-  ESP_LOGI(TAG, "Loaded pomodoro count: %d", pomodorosCompleted);
-
-  file.close();
-  if (SAVE_POWER) pocketmage::setCpuSpeed(POWER_SAVE_FREQ);
-  SDActive = false;
 }
 
-// Save pomodoro count to SD card
+// Save pomodoro count; the store writes it back on idle or before sleep
 void savePomodoroCount() {
-  SDActive = true;
-  pocketmage::setCpuSpeed(240);
-  delay(50);
-
-  SD().delFile("/sys/pomodoro.txt");
-  SD().appendToFile("/sys/pomodoro.txt", String(pomodorosCompleted));
+  POMODOROSTORE().load();
+  PomodoroRecord rec = {};
+  rec.completed = pomodorosCompleted;
+  if (POMODOROSTORE().size() > 0) {
+    rec.id = POMODOROSTORE().at(0).id;
+    POMODOROSTORE().update(rec);
+  } else {
+    POMODOROSTORE().add(rec);
+  }
   ESP_LOGI(TAG, "Saved pomodoro count: %d", pomodorosCompleted);
-
-  if (SAVE_POWER) pocketmage::setCpuSpeed(POWER_SAVE_FREQ);
-  SDActive = false;
 }
 
 // Start a timer with specified duration
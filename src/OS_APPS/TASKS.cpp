@@ -9,6 +9,7 @@
 #include <globals.h>
 #include "esp32-hal-log.h"
 #include "esp_log.h"
+#include "sys_tables.h"
 #if !OTA_APP // POCKETMAGE_OS
 enum TasksState { TASKS0, TASKS0_NEWTASK, TASKS1, TASKS1_EDITTASK };
 TasksState CurrentTasksState = TASKS0;
@@ -36,81 +37,47 @@ void sortTasksByDueDate(std::vector<std::vector<String>> &tasks) {
   });
 }
 
+// Commit pending task edits now instead of waiting for the idle flush
 void updateTasksFile() {
-  SDActive = true;
-  pocketmage::setCpuSpeed(240);
-  delay(50);
-  // Clear the existing tasks file first
-  SD().delFile("/sys/tasks.txt");
-
-  // Iterate through the tasks vector and append each task to the file
-  for (size_t i = 0; i < tasks.size(); i++) {
-    // Create a string from the task's attributes with "|" delimiter
-    String taskInfo = tasks[i][0] + "|" + tasks[i][1] + "|" + tasks[i][2] + "|" + tasks[i][3];
-    
-    // Append the task info to the file
-    SD().appendToFile("/sys/tasks.txt", taskInfo);
-  }
-
-  if (SAVE_POWER) pocketmage::setCpuSpeed(POWER_SAVE_FREQ);
-  SDActive = false;
+  TASKSTORE().flush();
 }
 
 void addTask(String taskName, String dueDate, String priority, String completed) {
-  String taskInfo = taskName+"|"+dueDate+"|"+priority+"|"+completed;
+  TaskRecord rec = {};
+  setField(rec.name, taskName);
+  rec.due       = dueDate.toInt();
+  rec.priority  = priority.toInt();
+  rec.completed = completed.toInt();
+  TASKSTORE().add(rec);
   updateTaskArray();
-  tasks.push_back({taskName, dueDate, priority, completed});
-  sortTasksByDueDate(tasks);
-  updateTasksFile();
 }
 
+// Refresh the tasks view from the store's due-date index. SD is only read on
+// first use and the view is only rebuilt when the table has changed.
 void updateTaskArray() {
-  SDActive = true;
-  pocketmage::setCpuSpeed(240);
-  delay(50);
-  File file = SD_MMC.open("/sys/tasks.txt", "r"); // Open the text file in read mode
-  if (!file) {
-    ESP_LOGE(TAG, "Failed to open file to read: %s", file.path());
-    return;
-  }
-
-  tasks.clear(); // Clear the existing vector before loading the new data
+  static uint32_t viewRev = 0;
+  static bool viewValid = false;
 
-  // Loop through the file, line by line
-  while (file.available()) {
-    String line = file.readStringUntil('\n');  // Read a line from the file
-    line.trim();  // Remove any extra spaces or newlines
-    
-    // Skip empty lines
-    if (line.length() == 0) {
-      continue;
-    }
-
-    // Split the line into individual parts using the delimiter '|'
-    uint8_t delimiterPos1 = line.indexOf('|');
-    uint8_t delimiterPos2 = line.indexOf('|', delimiterPos1 + 1);
-    uint8_t delimiterPos3 = line.indexOf('|', delimiterPos2 + 1);
-
-    // Extract task name, due date, priority, and completed status
-    String taskName  = line.substring(0, delimiterPos1);
-    String dueDate   = line.substring(delimiterPos1 + 1, delimiterPos2);
-    String priority  = line.substring(delimiterPos2 + 1, delimiterPos3);
-    String completed = line.substring(delimiterPos3 + 1);
-
-    // Add the task to the vector
-    tasks.push_back({taskName, dueDate, priority, completed});
+  if (!TASKSTORE().load()) {
+    ESP_LOGE(TAG, "Failed to load task store");
+  }
+  if (viewValid && viewRev == TASKSTORE().revision()) return;
+  viewRev = TASKSTORE().revision();
+  viewValid = true;
+
+  tasks.clear();
+  tasks.reserve(TASKSTORE().size());
+  for (size_t i = 0; i < TASKSTORE().size(); i++) {
+    const TaskRecord& rec = TASKSTORE().at(i);
+    tasks.push_back({String(rec.name), String(rec.due), String(rec.priority), String(rec.completed)});
   }
-
-  file.close();  // Close the file
-
-  if (SAVE_POWER) pocketmage::setCpuSpeed(POWER_SAVE_FREQ);
-  SDActive = false;
 }
 
 
 void deleteTask(int index) {
-  if (index >= 0 && index < tasks.size()) {
-    tasks.erase(tasks.begin() + index);
+  if (index >= 0 && index < TASKSTORE().size()) {
+    TASKSTORE().remove(TASKSTORE().at(index).id);
+    updateTaskArray();
   }
 }
 
@@ -299,7 +266,6 @@ void processKB_TASKS() {
           }
           else if (inchar == '3') { // DELETE TASK
             deleteTask(selectedTask);
-            updateTasksFile();
             
             CurrentTasksState = TASKS0;
             EINK().forceSlowFullUpdate(true);
@@ -336,7 +302,6 @@ void einkHandler_TASKS() {
 
         // DRAW FILE LIST
         updateTaskArray();
-        sortTasksByDueDate(tasks);
 
         if (!tasks.empty()) {
           ESP_LOGV(TAG, "Printing Tasks");
@@ -371,7 +336,6 @@ void einkHandler_TASKS() {
 
           // DRAW FILE LIST
           updateTaskArray();
-          sortTasksByDueDate(tasks);
 
           if (!tasks.empty()) {
             ESP_LOGV(TAG, "Printing Tasks");
@@ -7,6 +7,14 @@
 //      o888o     o888o  o88888o     o888o      //
 
 #include <globals.h>
+#include "io_session.h"
+#include "file_index.h"
+#include "spell_check.h"
+#include "doc_writer.h"
+#include "edit_journal.h"
+#include "line_index.h"
+#include "text_search.h"
+#include "undo_ring.h"
 #if !OTA_APP // POCKETMAGE_OS
 static constexpr const char* TAG = "TXT_NEWz";
 
@@ -51,10 +59,11 @@ static constexpr const char* TAG = "TXT_NEWz";
 #include "esp_log.h"
 
 // ------------------ General ------------------
-enum TXTState_NEW { TXT_, FONT, SAVE_AS, LOAD_FILE, JOURNAL_MODE, NEW_FILE };
+enum TXTState_NEW { TXT_, FONT, SAVE_AS, LOAD_FILE, JOURNAL_MODE, NEW_FILE, FIND };
 TXTState_NEW CurrentTXTState_NEW = TXT_;
 
 #define TYPE_INTERFACE_TIMEOUT 5000  // ms
+#define SAVE_NOTICE_MS 1000          // ms the save result stays on the OLED
 #define SCROLL_LINE_OFFSET 3         // lines
 
 // ------------------ Fonts ------------------
@@ -192,6 +201,7 @@ struct wordObject {
   String text;
   bool bold;
   bool italic;
+  uint8_t spell;  // 0 = not checked yet, 1 = known, 2 = misspelled
 };
 
 struct LineObject {
@@ -206,6 +216,8 @@ struct DocLine {
   std::vector<wordObject> words;  // Parsed words with formatting
   std::vector<LineObject> lines;  // split into line objects
   ulong orderedListNumber;
+  bool edited;                    // words changed since line was last compiled
+  bool journal;                   // edited since the last journal flush
 
   // Parse the line into wordObjects
   void parseWords() {
@@ -324,20 +336,10 @@ struct DocLine {
     line = compiled;
   }
 
-  int displayLine(int startX, int startY) {
-    ulong offsetLineScroll = 0;
-    if (lineScroll <= SCROLL_LINE_OFFSET) {
-      offsetLineScroll = 0;
-    } else
-      offsetLineScroll = lineScroll - SCROLL_LINE_OFFSET;
-
+  // firstLine: wrapped lines above it are scrolled off the top
+  int displayLine(int startX, int startY, size_t firstLine = 0) {
     int cursorY = startY;
 
-    // Entire block is offscreen, do not render.
-    if (!lines.empty() && lines.back().index < offsetLineScroll) {
-      return 0;
-    }
-
     // ---------- Non-Text Rendered Items ---------- //
 
     // Horizontal Rules just print a line
@@ -366,10 +368,8 @@ struct DocLine {
     
     // ---------- Render Text ---------- //
 
-    for (auto& ln : lines) {
-      if (ln.index < offsetLineScroll)
-        continue;  // skip lines above scroll
-
+    for (size_t l = firstLine; l < lines.size(); l++) {
+      auto& ln = lines[l];
       int cursorX = startX;
 
       // 1. Find max height for this line
@@ -462,7 +462,7 @@ struct DocLine {
     return cursorY - startY;
   }
 
-  int displayLinePreview(int startX, int startY) {
+  int displayLinePreview(int startX, int startY, size_t firstLine = 0) {
     // 74px on OLED horizontally
     u8g2.setDrawColor(1);
 
@@ -470,11 +470,6 @@ struct DocLine {
 
     int cursorY = startY;
 
-    // Entire block is offscreen, do not render.
-    if (!lines.empty() && lines.back().index < lineScroll) {
-      return 0;
-    }
-
     // Horizontal Rules just print a line
     if (style == 'H' && cursorY > 0) {
       u8g2.drawHLine(startX, cursorY, 80);
@@ -491,10 +486,8 @@ struct DocLine {
     else if (style == 'C')
       startX += (specialPadding / 2);
 
-    for (auto& ln : lines) {
-      if (ln.index < lineScroll)
-        continue;  // skip lines above scroll
-
+    for (size_t l = firstLine; l < lines.size(); l++) {
+      auto& ln = lines[l];
       int cursorX = startX;
 
       // 1. Find height for this line
@@ -604,25 +597,122 @@ struct DocLine {
 
 ulong editingLine_index = 0;
 std::vector<DocLine> docLines;
+static LineIndex displayLines;  // wrapped lines per DocLine, see refreshAllLineIndexes()
+
+// Save state: docPath holds the contents of docLines unless docDirty
+static bool docDirty = false;
+static String docPath = "";
+static ulong noticeUntil = 0;
+static bool journalPending = false;
+static ulong journalSince = 0;
+static size_t journalParas = 0;  // paragraph count the journal accounts for
+
+void markEdited(DocLine& dl) {
+  dl.edited = true;
+  dl.journal = true;
+  docDirty = true;
+  if (!journalPending) {
+    journalPending = true;
+    journalSince = millis();
+  }
+}
+
+bool editingFileDirty() {
+  return docDirty;
+}
+
+// Paragraph inserts and removals are journaled as they happen, ahead of the
+// SETs of the next flush, so SET indexes always refer to the current layout
+static void journalInsert(uint32_t index) {
+  EDITJOURNAL().insertLine(index);
+  journalParas++;
+}
+
+static void journalDelete(uint32_t index) {
+  EDITJOURNAL().deleteLine(index);
+  journalParas--;
+}
+
+bool flushEditJournal() {
+  if (!EDITJOURNAL().active()) return false;
+  // A paragraph added or removed without an INS/DEL would make every later
+  // SET land on the wrong index; the caller has to save the whole note
+  if (journalParas != docLines.size()) {
+    ESP_LOGW(TAG, "Journal out of step (%u vs %u paragraphs)", (unsigned)journalParas, (unsigned)docLines.size());
+    journalPending = false;
+    return false;
+  }
+
+  for (size_t i = 0; i < docLines.size(); i++) {
+    DocLine& dl = docLines[i];
+    if (!dl.journal) continue;
+    if (dl.edited) {
+      dl.compileToText();
+      dl.edited = false;
+    }
+    EDITJOURNAL().setLine(i, dl.style, dl.line);
+    dl.journal = false;
+  }
+  journalPending = false;
+  return EDITJOURNAL().flush();
+}
+
+// Journal replay targets
+static void journalInsertLine(uint32_t index) {
+  if (index > docLines.size()) index = docLines.size();
+  docLines.insert(docLines.begin() + index, DocLine{'T', "", {}});
+}
+
+static void journalDeleteLine(uint32_t index) {
+  if (index < docLines.size() && docLines.size() > 1)
+    docLines.erase(docLines.begin() + index);
+}
+
+static void journalSetLine(uint32_t index, char style, const String& text) {
+  if (index >= docLines.size()) return;
+  docLines[index].style = style;
+  docLines[index].line = text;
+}
+
+// OLED message that holds until SAVE_NOTICE_MS passes or a key is typed
+void showNotice(const String& msg) {
+  OLED().oledWord(msg);
+  noticeUntil = millis() + SAVE_NOTICE_MS;
+}
 
 // ------------------ Rendering ------------------
 
 // Count number of display lines
 int getTotalDisplayLines() {
-  int total = 0;
-  for (const auto& doc : docLines) {
-    total += doc.lines.size();
+  return displayLines.total();
+}
+
+// First DocLine to draw for a scroll position, and how many of its wrapped
+// lines are above the screen
+void firstVisible(ulong scroll, size_t& docIndex, uint32_t& firstLine) {
+  docIndex = 0;
+  firstLine = 0;
+  if (scroll == 0) return;  // leading blank lines stay visible at the top
+  if (!displayLines.find(scroll, docIndex, firstLine)) {
+    docIndex = docLines.size();
   }
-  return total;
 }
 
 // Display the entire document
 int displayDocument(int startX = 0, int startY = 0) {
   int cursorY = startY;
 
-  for (auto& doc : docLines) {
+  ulong offsetLineScroll = 0;
+  if (lineScroll > SCROLL_LINE_OFFSET)
+    offsetLineScroll = lineScroll - SCROLL_LINE_OFFSET;
+
+  size_t first;
+  uint32_t firstLine;
+  firstVisible(offsetLineScroll, first, firstLine);
+
+  for (size_t i = first; i < docLines.size(); i++) {
     // Display this DocLine, offset by current cursorY
-    int heightUsed = doc.displayLine(startX, cursorY);
+    int heightUsed = docLines[i].displayLine(startX, cursorY, i == first ? firstLine : 0);
 
     // If the line is off the bottom of the screen, stop drawing
     if (cursorY > display.height())
@@ -638,9 +728,13 @@ int displayDocument(int startX = 0, int startY = 0) {
 int displayDocumentPreview(int startX = 0, int startY = 0) {
   int cursorY = startY;
 
-  for (auto& doc : docLines) {
+  size_t first;
+  uint32_t firstLine;
+  firstVisible(lineScroll, first, firstLine);
+
+  for (size_t i = first; i < docLines.size(); i++) {
     // Display this DocLine, offset by current cursorY
-    int heightUsed = doc.displayLinePreview(startX, cursorY);
+    int heightUsed = docLines[i].displayLinePreview(startX, cursorY, i == first ? firstLine : 0);
 
     // If the line is off the bottom of the screen, stop drawing
     if (cursorY > u8g2.getDisplayHeight())
@@ -768,26 +862,33 @@ void setFontOLED(bool bold, bool italic) {
   return;
 }
 
-LineObject* getLineObjectByIndex(ulong targetIndex) {
-  for (auto& doc : docLines) {
-    for (auto& line : doc.lines) {
-      if (line.index == targetIndex) {
-        return &line;
-      }
-    }
+// Check a finished word once; the result is kept on the word
+void checkSpelling(wordObject& w) {
+  if (w.spell == 0 && w.text.length() > 0) w.spell = SPELL().known(w.text) ? 1 : 2;
+}
+
+// Dotted underline below a misspelled word on the OLED
+void markMisspelled(const wordObject& w, int x, int wpx) {
+  if (w.spell != 2) return;
+  for (int px = x; px < x + wpx; px += 2) {
+    if (px >= 0) u8g2.drawPixel(px, 23);
   }
-  return nullptr;  // not found
+}
+
+LineObject* getLineObjectByIndex(ulong targetIndex) {
+  size_t docIndex;
+  uint32_t sub;
+  if (!displayLines.find(targetIndex, docIndex, sub) || sub >= docLines[docIndex].lines.size())
+    return nullptr;  // not found
+  return &docLines[docIndex].lines[sub];
 }
 
 char getStyleFromScrollLine(ulong scrollLineIndex) {
-  for (auto& doc : docLines) {
-    for (auto& line : doc.lines) {
-      if (line.index == scrollLineIndex) {
-        return doc.style;  // <-- Return the DocLine style
-      }
-    }
-  }
-  return 'T';  // fallback if not found
+  size_t docIndex;
+  uint32_t sub;
+  if (!displayLines.find(scrollLineIndex, docIndex, sub))
+    return 'T';  // fallback if not found
+  return docLines[docIndex].style;
 }
 
 // Returns the pixel width of a LineObject on the OLED (vector of wordObjects)
@@ -920,6 +1021,7 @@ void oledEditorDisplay(LineObject& lineObj, wordObject& currentWord, int pixelsU
       u8g2.drawStr(xpos, 20, w.text.c_str());
 
       uint16_t wpx = u8g2.getStrWidth(w.text.c_str());
+      markMisspelled(w, xpos, wpx);
 
       // Only add space if not the last word
       if (i < lineObj.words.size() - 1) {
@@ -953,6 +1055,7 @@ void oledEditorDisplay(LineObject& lineObj, wordObject& currentWord, int pixelsU
       // Draw word if it's on the screen
       if ((xpos + wpx) > 0) {
         u8g2.drawStr(xpos, 20, w.text.c_str());
+        markMisspelled(w, xpos, wpx);
       }
     }
 
@@ -1044,18 +1147,325 @@ void refreshOrderedListIndexes() {
 void refreshAllLineIndexes() {
   // Refresh line indexes
   indexCounter = 0;                     // reset counter if you want indexes to start from 0
-  for (auto& docLine : docLines) {      // iterate through all DocLines
-    for (auto& line : docLine.lines) {  // iterate through each LineObject
+  displayLines.reset(docLines.size());
+  for (size_t i = 0; i < docLines.size(); i++) {  // iterate through all DocLines
+    for (auto& line : docLines[i].lines) {        // iterate through each LineObject
       line.index = indexCounter++;
     }
+    displayLines.count(i, docLines[i].lines.size());
   }
+  displayLines.build();
 
   // Update list indexes
   refreshOrderedListIndexes();
 }
 
+// ------------------ Undo ------------------
+// Typing in one paragraph is collected into a single undo step, closed by a
+// space, Enter, a pause of UNDO_COALESCE_MS or an edit elsewhere
+static bool undoOpen = false;
+static size_t undoPara = 0;
+static String undoBefore;
+static char undoStyleBefore = 'T';
+static ulong undoLastMillis = 0;
+
+// Raw text of a DocLine, compiled from its words if they changed
+const String& paragraphText(DocLine& dl) {
+  if (dl.edited) {
+    dl.compileToText();
+    dl.edited = false;
+  }
+  return dl.line;
+}
+
+// Store the change from before to after as the differing middle range only
+bool pushTextUndo(size_t para, const String& before, const String& after, char oldStyle,
+                  char newStyle, bool joined) {
+  size_t shorter = min(before.length(), after.length());
+  size_t prefix = 0;
+  while (prefix < shorter && before[prefix] == after[prefix])
+    prefix++;
+  size_t suffix = 0;
+  while (suffix < shorter - prefix &&
+         before[before.length() - 1 - suffix] == after[after.length() - 1 - suffix])
+    suffix++;
+
+  if (before.length() == after.length() && prefix == before.length() && oldStyle == newStyle)
+    return false;  // nothing changed
+
+  EditDelta d;
+  d.kind = UNDO_TEXT;
+  d.joined = joined;
+  d.para = para;
+  d.offset = prefix;
+  d.oldStyle = oldStyle;
+  d.newStyle = newStyle;
+  d.removed = before.substring(prefix, before.length() - suffix);
+  d.inserted = after.substring(prefix, after.length() - suffix);
+  UNDO().push(d);
+  return true;
+}
+
+// End the current typing step; true if it changed anything
+bool undoClose(bool joined = false) {
+  if (!undoOpen)
+    return false;
+  undoOpen = false;
+  if (undoPara >= docLines.size())
+    return false;
+  DocLine& dl = docLines[undoPara];
+  return pushTextUndo(undoPara, undoBefore, paragraphText(dl), undoStyleBefore, dl.style, joined);
+}
+
+// Call before editing paragraph para
+void undoTouch(size_t para) {
+  ulong now = millis();
+  if (undoOpen && (undoPara != para || now - undoLastMillis > UNDO_COALESCE_MS))
+    undoClose();
+  if (!undoOpen && para < docLines.size()) {
+    undoBefore = paragraphText(docLines[para]);
+    undoStyleBefore = docLines[para].style;
+    undoPara = para;
+    undoOpen = true;
+  }
+  undoLastMillis = now;
+}
+
+void resetUndo() {
+  undoOpen = false;
+  UNDO().clear();
+}
+
+// Revert (undo) or re-apply a delta; only the paragraph it names is re-parsed
+void applyDelta(const EditDelta& d, bool undo) {
+  if (d.kind == UNDO_INSERT_PARA) {
+    if (undo) {
+      if (d.para >= docLines.size() || docLines.size() < 2)
+        return;
+      docLines.erase(docLines.begin() + d.para);
+      journalDelete(d.para);
+      editingLine_index = d.para > 0 ? d.para - 1 : 0;
+    } else {
+      if (d.para > docLines.size())
+        return;
+      docLines.insert(docLines.begin() + d.para, DocLine{d.newStyle, "", {}});
+      journalInsert(d.para);
+      markEdited(docLines[d.para]);
+      editingLine_index = d.para;
+    }
+    docDirty = true;
+    refreshAllLineIndexes();
+    return;
+  }
+
+  if (d.para >= docLines.size())
+    return;
+  DocLine& dl = docLines[d.para];
+  const String& cur = paragraphText(dl);
+  const String& from = undo ? d.inserted : d.removed;
+  const String& to = undo ? d.removed : d.inserted;
+
+  String text = cur.substring(0, d.offset);
+  text += to;
+  text += cur.substring(d.offset + from.length());
+  dl.line = text;
+
+  char style = undo ? d.oldStyle : d.newStyle;
+  bool restyled = dl.style != style;
+  dl.style = style;
+
+  dl.parseWords();
+  dl.splitToLines();
+  markEdited(dl);
+  dl.edited = false;  // the words were just parsed from line
+
+  displayLines.set(d.para, dl.lines.size());
+  if (restyled)
+    refreshOrderedListIndexes();
+  editingLine_index = d.para;
+}
+
+// Typing resumes after a space, as it would have before the undone word
+void openNextWord() {
+  DocLine& dl = docLines[editingLine_index];
+  if (!dl.lines.empty() && !dl.lines.back().words.empty() &&
+      dl.lines.back().words.back().text.length() > 0)
+    dl.lines.back().words.push_back({"", false, false});
+}
+
+bool undoEdit() {
+  undoClose();
+  EditDelta d;
+  bool any = false;
+  while (UNDO().undo(d)) {
+    applyDelta(d, true);
+    any = true;
+    if (!d.joined)
+      break;
+  }
+  if (any)
+    openNextWord();
+  return any;
+}
+
+bool redoEdit() {
+  undoClose();
+  EditDelta d;
+  if (!UNDO().redo(d))
+    return false;
+  applyDelta(d, false);
+  while (UNDO().redoJoined() && UNDO().redo(d))
+    applyDelta(d, false);
+  openNextWord();
+  return true;
+}
+
+// ------------------ Find / Replace ------------------
+static TextFinder finder;
+static bool findActive = false;
+static size_t findDoc = 0;        // DocLine of the current match
+static int findPos = -1;          // offset of the match in its raw text
+static uint32_t findNumber = 0;
+static TXTState_NEW findReturnState = TXT_;
+
+// Bring the raw text of every edited DocLine up to date with its words
+void compileEditedLines() {
+  for (auto& dl : docLines)
+    paragraphText(dl);
+}
+
+bool searchable(const DocLine& dl) {
+  return dl.style != 'H' && dl.style != 'B';
+}
+
+uint32_t countMatches() {
+  uint32_t count = 0;
+  for (auto& dl : docLines) {
+    if (!searchable(dl)) continue;
+    for (int pos = finder.find(dl.line); pos >= 0; pos = finder.find(dl.line, pos + finder.length()))
+      count++;
+  }
+  return count;
+}
+
+// Wrapped line of dl that shows character offset pos of its raw text
+uint32_t lineOfOffset(const DocLine& dl, int pos) {
+  // Words are the space separated runs of the raw text
+  uint32_t word = 0;
+  for (int i = 1; i <= pos && i < dl.line.length(); i++) {
+    if (dl.line[i] != ' ' && dl.line[i - 1] == ' ')
+      word++;
+  }
+  for (uint32_t sub = 0; sub < dl.lines.size(); sub++) {
+    if (word < dl.lines[sub].words.size())
+      return sub;
+    word -= dl.lines[sub].words.size();
+  }
+  return dl.lines.empty() ? 0 : dl.lines.size() - 1;
+}
+
+// Move the viewport to the next match, wrapping around the end
+void findNext() {
+  if (!findActive || docLines.empty())
+    return;
+  compileEditedLines();
+
+  size_t n = docLines.size();
+  size_t start = findDoc < n ? findDoc : 0;
+  for (size_t k = 0; k <= n; k++) {
+    size_t d = (start + k) % n;
+    if (!searchable(docLines[d]))
+      continue;
+    int from = (k == 0 && findPos >= 0) ? findPos + 1 : 0;
+    int pos = finder.find(docLines[d].line, from);
+    if (pos < 0)
+      continue;
+
+    bool wrapped = d < start || (d == start && pos <= findPos);
+    findNumber = (findPos < 0 || wrapped) ? 1 : findNumber + 1;
+    findDoc = d;
+    findPos = pos;
+
+    lineScroll = displayLines.start(d) + lineOfOffset(docLines[d], pos);
+    updateScreen = true;
+    showNotice("Match " + String(findNumber) + " of " + String(countMatches()));
+    return;
+  }
+
+  findActive = false;
+  showNotice("Not found");
+}
+
+// Replace every match in one pass, then re-index once
+void replaceAll(const String& with) {
+  undoClose();
+  compileEditedLines();
+
+  uint32_t replaced = 0;
+  bool joined = false;
+  for (size_t i = 0; i < docLines.size(); i++) {
+    DocLine& dl = docLines[i];
+    if (!searchable(dl))
+      continue;
+    int pos = finder.find(dl.line);
+    if (pos < 0)
+      continue;
+
+    String out;
+    out.reserve(dl.line.length() + with.length());
+    int last = 0;
+    while (pos >= 0) {
+      out += dl.line.substring(last, pos);
+      out += with;
+      last = pos + finder.length();
+      replaced++;
+      pos = finder.find(dl.line, last);
+    }
+    out += dl.line.substring(last);
+
+    // One undo step for the whole batch
+    joined |= pushTextUndo(i, dl.line, out, dl.style, dl.style, joined);
+    dl.line = out;
+    dl.parseWords();
+    dl.splitToLines();
+    markEdited(dl);
+    dl.edited = false;  // the words were just parsed from line
+  }
+
+  if (replaced > 0) {
+    refreshAllLineIndexes();
+    updateScreen = true;
+  }
+  showNotice("Replaced " + String(replaced));
+}
+
+// Enter in the find prompt: "text" finds, "text>replacement" replaces all
+void runFind(const String& input) {
+  int sep = input.indexOf('>');
+  String what = sep >= 0 ? input.substring(0, sep) : input;
+  if (!finder.set(what)) {
+    findActive = false;
+    if (what.length() > TEXT_SEARCH_MAX_PATTERN) showNotice("Pattern too long");
+    return;
+  }
+  if (sep >= 0) {
+    findActive = false;
+    replaceAll(input.substring(sep + 1));
+  } else {
+    findActive = true;
+    findDoc = 0;
+    findPos = -1;
+    findNext();
+  }
+}
+
 // Load File
 void loadMarkdownFile(const String& path) {
+  // Edits to the previous note stay in its journal
+  flushEditJournal();
+  EDITJOURNAL().end();
+  journalPending = false;
+
   // Invalid file
   if (path == "" || path == " " || path == "-") {
     OLED().oledWord("No file saved! Creating blank file.");
@@ -1068,10 +1478,8 @@ void loadMarkdownFile(const String& path) {
     // Populate and update as usual so UI doesn’t crash
     populateLines(docLines);
     refreshAllLineIndexes();
-
-    if (SAVE_POWER)
-      pocketmage::setCpuSpeed(80);
-    SDActive = false;
+    docDirty = false;
+    docPath = "";
     return;
   }
 
@@ -1081,11 +1489,13 @@ void loadMarkdownFile(const String& path) {
     return;
   }
 
-  SDActive = true;
-  pocketmage::setCpuSpeed(240);
-  delay(50);
+  IOSESSION().begin();
 
+  recoverDocument(path);
+  resetUndo();
   docLines.clear();
+  docDirty = false;
+  docPath = "";
   File file = SD_MMC.open(path.c_str(), FILE_READ);
   if (!file) {
     ESP_LOGE("SD", "File does not exist: %s", path.c_str());  // FIXME: - Come up with better error handling
@@ -1101,9 +1511,7 @@ void loadMarkdownFile(const String& path) {
     populateLines(docLines);
     refreshAllLineIndexes();
 
-    if (SAVE_POWER)
-      pocketmage::setCpuSpeed(80);
-    SDActive = false;
+    IOSESSION().end();
     return;
   }
 
@@ -1156,22 +1564,26 @@ void loadMarkdownFile(const String& path) {
 
   if (docLines.empty()) {
     docLines.push_back({'T', "", {}});
-    editingLine_index = 0;
-  } else {
-    editingLine_index = docLines.size() - 1;
   }
 
+  // Unsaved edits from before a power loss or sleep
+  bool restored = EDITJOURNAL().replay(path, journalInsertLine, journalDeleteLine, journalSetLine);
+  EDITJOURNAL().begin(path);
+  journalParas = docLines.size();
+  editingLine_index = docLines.size() - 1;
+
   // Populate all the lines
   populateLines(docLines);
 
   // Update indexes
   refreshAllLineIndexes();
 
-  if (SAVE_POWER)
-    pocketmage::setCpuSpeed(80);
-  SDActive = false;
+  IOSESSION().end();
 
-  OLED().oledWord("FILE LOADED");
+  docPath = path;
+  docDirty = restored;
+
+  OLED().oledWord(restored ? "FILE LOADED - EDITS RESTORED" : "FILE LOADED");
   delay(500);
   fileLoaded = true;
 }
@@ -1182,10 +1594,6 @@ void saveMarkdownFile(const String& path) {
     delay(3000);
     return;
   }
-  ESP_LOGE(TAG, "In save markdown file, setting cpu speed");
-  SDActive = true;
-  pocketmage::setCpuSpeed(240);
-  delay(50);
 
   // Determine save path
   String savePath = path;
@@ -1194,49 +1602,72 @@ void saveMarkdownFile(const String& path) {
   if (!savePath.startsWith("/"))
     savePath = "/" + savePath;
 
-  File file = SD_MMC.open(savePath.c_str(), FILE_WRITE);
-  if (!file) {
+  // Nothing changed since the last load or save
+  if (!docDirty && savePath == docPath) {
+    showNotice("No changes");
+    return;
+  }
+
+  IOSESSION().begin();
+
+  DocWriter out(savePath);
+  if (!out.ok()) {
     OLED().oledWord("SAVE FAILED - OPEN ERR");
     delay(2000);
-    ESP_LOGE("SD", "Failed to open file for writing: %s", savePath.c_str());
-    SDActive = false;
+    IOSESSION().end();
     return;
   }
 
-  // Write each DocLine as Markdown
+  // Write each DocLine as Markdown, recompiling only paragraphs that were edited
   for (auto &dl : docLines) {
-    dl.compileToText();
-
-    String out;
+    if (dl.edited) {
+      dl.compileToText();
+      dl.edited = false;
+    }
+    dl.journal = false;
 
     switch (dl.style) {
-      case '1': out = "# " + dl.line; break;
-      case '2': out = "## " + dl.line; break;
-      case '3': out = "### " + dl.line; break;
-      case '>': out = "> " + dl.line; break;
-      case '-': out = "- " + dl.line; break;
-      case 'L': out = "1. " + dl.line; break; //String(dl.orderedListNumber) + ". " + dl.line; break;
-      case 'H': out = "---"; break;
-      case 'C': out = "```" + dl.line + "```"; break;
-      case 'B': out = ""; break;
-      default:  out = dl.line; break;
+      case '1': out.write("# "); break;
+      case '2': out.write("## "); break;
+      case '3': out.write("### "); break;
+      case '>': out.write("> "); break;
+      case '-': out.write("- "); break;
+      case 'L': out.write("1. "); break; //String(dl.orderedListNumber) + ". "
+      case 'C': out.write("```"); break;
+      default: break;
     }
-
-    file.println(out);
+    if (dl.style == 'H')
+      out.write("---");
+    else if (dl.style != 'B')
+      out.write(dl.line);
+    if (dl.style == 'C')
+      out.write("```");
+    out.write("\r\n");
   }
 
-  file.close();
+  if (!out.commit()) {
+    OLED().oledWord("SAVE FAILED - WRITE ERR");
+    delay(2000);
+    IOSESSION().end();
+    return;
+  }
+  fileWritten(savePath);
 
   // Save metadata
   SD().writeMetadata(savePath);
   SD().setEditingFile(savePath);
+  docDirty = false;
+  docPath = savePath;
 
-  OLED().oledWord("Saved: " + savePath);
-  delay(1000);
+  // The note now holds every edit; start a fresh journal against it
+  EDITJOURNAL().clear();
+  EDITJOURNAL().begin(savePath);
+  journalPending = false;
+  journalParas = docLines.size();
+
+  showNotice("Saved: " + savePath);
 
-  if (SAVE_POWER)
-    pocketmage::setCpuSpeed(POWER_SAVE_FREQ);
-  SDActive = false;
+  IOSESSION().end();
 }
 
 void newMarkdownFile(const String& path) {
@@ -1246,9 +1677,7 @@ void newMarkdownFile(const String& path) {
     return;
   }
 
-  SDActive = true;
-  setCpuFrequencyMhz(240);
-  delay(50);
+  IOSESSION().begin();
 
   // Determine save path
   String savePath = path;
@@ -1257,18 +1686,22 @@ void newMarkdownFile(const String& path) {
   if (!savePath.startsWith("/"))
     savePath = "/" + savePath;
 
+  // A journal left from an earlier note with this name must not be replayed
+  EDITJOURNAL().remove(savePath);
+
   File file = SD_MMC.open(savePath.c_str(), FILE_WRITE);
   if (!file) {
     OLED().oledWord("SAVE FAILED - OPEN ERR");
     delay(2000);
     ESP_LOGE("SD", "Failed to open file for writing: %s", savePath.c_str());
-    SDActive = false;
+    IOSESSION().end();
     return;
   }
 
   // Write nothing
 
   file.close();
+  fileWritten(savePath);
 
   // Save metadata
   SD().writeMetadata(savePath);
@@ -1280,9 +1713,7 @@ void newMarkdownFile(const String& path) {
   loadMarkdownFile(savePath);
   updateScreen = true;
 
-  if (SAVE_POWER)
-    setCpuFrequencyMhz(POWER_SAVE_FREQ);
-  SDActive = false;
+  IOSESSION().end();
 }
 
 
@@ -1309,6 +1740,14 @@ int getLineWidth(const LineObject& lineObj, char style) {
   return lineWidth;
 }
 
+// Scroll to the last line of the DocLine being edited
+void scrollToEditingLine() {
+  const DocLine& dl = docLines[editingLine_index];
+  lineScroll = displayLines.start(editingLine_index);
+  if (!dl.lines.empty())
+    lineScroll += dl.lines.size() - 1;
+}
+
 void editAppend(char inchar) {
   static ulong lastTypeMillis = 0;
   ulong currentMillis = millis();
@@ -1319,6 +1758,7 @@ void editAppend(char inchar) {
 
   // Direct access to DocLine, LineObject, and wordObject
   DocLine& editingDocLine = docLines[editingLine_index];
+  const ulong startLine_index = editingLine_index;
   LineObject* lastLine;
   wordObject* lastWord;
 
@@ -1339,6 +1779,7 @@ void editAppend(char inchar) {
   if (inchar != 0) {
     // Increase clock speed here for faster processing?
     pocketmage::setCpuSpeed(240);
+    noticeUntil = currentMillis;
   }
 
   // HANDLE INPUTS
@@ -1353,12 +1794,13 @@ void editAppend(char inchar) {
   else if (inchar == 12 && CurrentTXTState_NEW == JOURNAL_MODE) {
     JOURNAL_INIT();
   }
-  // TAB Recieved
+  // TAB Recieved (Find / Replace)
   else if (inchar == 9) {
-    // If scrolling, edit inline
-    if (TOUCH().getLastTouch() != -1) {
-    }
-
+    findReturnState = CurrentTXTState_NEW;
+    CurrentTXTState_NEW = FIND;
+    currentLine = "";
+    KB().setKeyboardState(NORMAL);
+    return;
   }
   // SHIFT Recieved
   else if (inchar == 17) {
@@ -1382,6 +1824,10 @@ void editAppend(char inchar) {
   }
   // Space Recieved
   else if (inchar == 32) {
+    checkSpelling(*lastWord);
+    undoTouch(editingLine_index);
+    markEdited(editingDocLine);
+
     if (getLineWidth(*lastLine, editingDocLine.style) > display.width() - DISPLAY_WIDTH_BUFFER) {
       // Word does not fit -> wrap to new line
       // Remove the word from the old line
@@ -1410,11 +1856,19 @@ void editAppend(char inchar) {
     newWord.text = "";
     newWord.bold = false;
     newWord.italic = false;
+    newWord.spell = 0;
     lastLine->words.push_back(std::move(newWord));
     lastWord = &lastLine->words.back();
+
+    // Each finished word is its own undo step
+    undoClose();
   }
   // ENTER Received
   else if (inchar == 13) {
+    checkSpelling(*lastWord);
+    undoTouch(editingLine_index);
+    markEdited(editingDocLine);
+
     // Check if false blank line
     bool hasAnyText = false;
     for (auto& ln : editingDocLine.lines) {
@@ -1469,8 +1923,10 @@ void editAppend(char inchar) {
     }
 
     // Finish current DocLine and create a new one
+    bool changed = undoClose();
     DocLine newDocLine;
     newDocLine.style = nextLineStyle;
+    markEdited(newDocLine);
 
     // Add one line and one empty word
     LineObject newLine;
@@ -1481,6 +1937,15 @@ void editAppend(char inchar) {
     // Insert new DocLine immediately after the current one
     editingLine_index++;
     docLines.insert(docLines.begin() + editingLine_index, std::move(newDocLine));
+    journalInsert(editingLine_index);
+
+    EditDelta split;
+    split.kind = UNDO_INSERT_PARA;
+    split.joined = changed;
+    split.para = editingLine_index;
+    split.offset = 0;
+    split.oldStyle = split.newStyle = nextLineStyle;
+    UNDO().push(split);
 
     // Update lastLine/lastWord to point to new line
     lastLine = &docLines[editingLine_index].lines.back();
@@ -1499,8 +1964,29 @@ void editAppend(char inchar) {
   // LEFT
   else if (inchar == 19) {
   }
-  // RIGHT
+  // RIGHT (Next match)
   else if (inchar == 21) {
+    findNext();
+  }
+  // FN+SHIFT+LEFT (Undo)
+  else if (inchar == 24) {
+    if (undoEdit()) {
+      scrollToEditingLine();
+      updateScreen = true;
+    } else {
+      showNotice("Nothing to undo");
+    }
+    return;
+  }
+  // FN+SHIFT+RIGHT (Redo)
+  else if (inchar == 26) {
+    if (redoEdit()) {
+      scrollToEditingLine();
+      updateScreen = true;
+    } else {
+      showNotice("Nothing to redo");
+    }
+    return;
   }
   // SHFT + LEFT (Text type select)
   else if (inchar == 28) {
@@ -1518,11 +2004,14 @@ void editAppend(char inchar) {
     }
 
     // Move to next style in cycle
+    undoTouch(editingLine_index);
     currentIndex = (currentIndex + 1) % numStyles;
     editingDocLine.style = styleCycle[currentIndex];
+    markEdited(editingDocLine);
   }
   // SHFT + RIGHT (Word type select)
   else if (inchar == 30) {
+    undoTouch(editingLine_index);
     if (lastWord->bold == false && lastWord->italic == false) {
       // If regular text switch to bold
       lastWord->bold = true;
@@ -1540,12 +2029,16 @@ void editAppend(char inchar) {
       lastWord->bold = false;
       lastWord->italic = false;
     }
+    markEdited(editingDocLine);
   }
   // BKSP Received
   else if (inchar == 8) {
+    undoTouch(editingLine_index);
+    markEdited(editingDocLine);
     if (lastWord->text.length() > 0) {
       // Remove the last character of the current word
       lastWord->text.remove(lastWord->text.length() - 1);
+      lastWord->spell = 0;
     } else {
       // Current word is empty, move to previous word or line
       LineObject* linePtr = lastLine;
@@ -1625,7 +2118,10 @@ void editAppend(char inchar) {
     updateScreen = true;
   } else {
     // Add char to current word
+    undoTouch(editingLine_index);
     lastWord->text += inchar;
+    lastWord->spell = 0;
+    markEdited(editingDocLine);
 
     if (inchar >= 48 && inchar <= 57) {
     }  // Only leave FN on if typing numbers
@@ -1639,9 +2135,15 @@ void editAppend(char inchar) {
     lastTypeMillis = millis();
   }
 
+  // Journal the latest keystrokes every few seconds
+  if (journalPending && millis() - journalSince >= EDIT_JOURNAL_FLUSH_MS) {
+    flushEditJournal();
+  }
+
   currentMillis = millis();
   // Make sure oled only updates at 60fps
-  if (currentMillis - OLEDFPSMillis >= (1000 / 60)) {
+  // A save notice stays up until it expires or typing resumes
+  if ((long)(currentMillis - noticeUntil) >= 0 && currentMillis - OLEDFPSMillis >= (1000 / 60)) {
     OLEDFPSMillis = currentMillis;
     // Show line on OLED when not actively scrolling
     if (TOUCH().getLastTouch() == -1) {
@@ -1660,16 +2162,18 @@ void editAppend(char inchar) {
     }
   }
 
+  // Wrapping and backspace change the number of lines in the edited DocLine
+  if (inchar != 0 && displayLines.paragraphs() == docLines.size() && startLine_index < docLines.size()) {
+    displayLines.set(startLine_index, docLines[startLine_index].lines.size());
+  }
+
   // Center scroll on typed line if a line update has been registered
   if (moveView) {
-    // Update scroll to currently edited line
-    if (editingDocLine.lines.empty())
-      lineScroll = 0;
-    else
-      lineScroll = editingDocLine.lines.back().index;
+    scrollToEditingLine();
   }
 
-  if (SAVE_POWER) setCpuFrequencyMhz(POWER_SAVE_FREQ);
+  // Leave the clock alone while the e-ink task is inside an SD session
+  if (SAVE_POWER && IOSESSION().depth() == 0) setCpuFrequencyMhz(POWER_SAVE_FREQ);
 }
 
 // INIT
@@ -1785,6 +2289,7 @@ void initFonts() {
 
 void TXT_INIT() {
   initFonts();
+  SPELL().begin();
 
   loadMarkdownFile(SD().getEditingFile());
 
@@ -1798,6 +2303,7 @@ void TXT_INIT() {
 
 void TXT_INIT_JournalMode() {
   initFonts();
+  SPELL().begin();
 
   String outPath = getCurrentJournal();
   if (!outPath.startsWith("/")) outPath = "/" + outPath;
@@ -2003,6 +2509,71 @@ void processKB_TXT_NEW() {
         }
       }
       break;
+    case FIND:
+      inchar = KB().updateKeypress();
+      if (currentMillis - KBBounceMillis >= KB_COOLDOWN) {
+        // HANDLE INPUTS
+        //No char recieved
+        if (inchar == 0);
+        //CR Recieved
+        else if (inchar == 13) {
+          CurrentTXTState_NEW = findReturnState;
+          runFind(currentLine);
+          currentLine = "";
+          break;
+        }
+        // SHIFT Recieved
+        else if (inchar == 17) {
+          if (KB().getKeyboardState() == SHIFT || KB().getKeyboardState() == FN_SHIFT) {
+            KB().setKeyboardState(NORMAL);
+          } else if (KB().getKeyboardState() == FUNC) {
+            KB().setKeyboardState(FN_SHIFT);
+          } else {
+            KB().setKeyboardState(SHIFT);
+          }
+        }
+        // FN Recieved
+        else if (inchar == 18) {
+          if (KB().getKeyboardState() == FUNC || KB().getKeyboardState() == FN_SHIFT) {
+            KB().setKeyboardState(NORMAL);
+          } else if (KB().getKeyboardState() == SHIFT) {
+            KB().setKeyboardState(FN_SHIFT);
+          } else {
+            KB().setKeyboardState(FUNC);
+          }
+        }
+        //ESC / CLEAR Recieved
+        else if (inchar == 20) {
+          currentLine = "";
+        }
+        //BKSP Recieved
+        else if (inchar == 8) {
+          if (currentLine.length() > 0) {
+            currentLine.remove(currentLine.length() - 1);
+          }
+        }
+        // Home recieved
+        else if (inchar == 12) {
+          CurrentTXTState_NEW = findReturnState;
+          currentLine = "";
+          break;
+        }
+        else {
+          currentLine += inchar;
+          if (inchar >= 48 && inchar <= 57) {}  //Only leave FN on if typing numbers
+          else if (KB().getKeyboardState() != NORMAL) {
+            KB().setKeyboardState(NORMAL);
+          }
+        }
+
+        currentMillis = millis();
+        //Make sure oled only updates at OLED_MAX_FPS
+        if (currentMillis - OLEDFPSMillis >= (1000/OLED_MAX_FPS)) {
+          OLEDFPSMillis = currentMillis;
+          OLED().oledLine(currentLine, currentLine.length(), false, "Find (text>new replaces all)");
+        }
+      }
+      break;
     case LOAD_FILE:
       outPath = fileWizardMini(false, "/notes");
       if (outPath == "_EXIT_") {
@@ -1,21 +1,101 @@
 
 #include <globals.h>
+#include "record_store.h"
+#include "file_index.h"
+#include "dir_cache.h"
+#include "text_index.h"
 
 #include <USB.h>
 #include <USBMSC.h>
 #include <sdmmc_cmd.h>
 #include <driver/sdmmc_host.h>
 #include <driver/sdmmc_defs.h>
+#include "esp_heap_caps.h"
 #if !OTA_APP // POCKETMAGE_OS
 static String currentLine = "";
 static constexpr const char* TAG = "USB";
 static USBMSC msc;
 static sdmmc_card_t* card = nullptr;     // SD card pointer
 
+// ===================== SECTOR BRIDGE =====================
+// The host sends MSC requests a few KB at a time. Every request becomes at
+// most one multi-block SDMMC command. Sequential reads are served from a
+// read-ahead window. Consecutive writes are gathered into one buffer that
+// goes out as a single command when it fills, when the host reads the same
+// range, on eject, or after USB_WRITE_FLUSH_MS without writes.
+
+#define USB_CACHE_SECTORS   32     // 16 KB each for read-ahead and write coalescing
+#define USB_WRITE_FLUSH_MS  250
+
+struct UsbStats {
+  uint64_t bytesRead, bytesWritten;
+  uint32_t sdReads, sdWrites;      // SDMMC commands issued
+  uint32_t cacheHits;              // read requests served without touching the card
+};
+
+static UsbStats usbStats = {};
+static SemaphoreHandle_t bridgeLock = nullptr;
+
+static uint8_t* readBuf = nullptr;       // DMA-capable, USB_CACHE_SECTORS sectors
+static uint32_t readLba = 0, readCount = 0;
+static uint32_t nextSeqLba = UINT32_MAX; // where the last read ended
+
+static uint8_t* writeBuf = nullptr;
+static uint32_t writeLba = 0, writeCount = 0;
+static unsigned long lastWriteMillis = 0;
+
+static bool bridgeBegin() {
+  if (!bridgeLock) bridgeLock = xSemaphoreCreateMutex();
+  if (!readBuf)  readBuf  = (uint8_t*)heap_caps_malloc(USB_CACHE_SECTORS * 512, MALLOC_CAP_DMA);
+  if (!writeBuf) writeBuf = (uint8_t*)heap_caps_malloc(USB_CACHE_SECTORS * 512, MALLOC_CAP_DMA);
+  readCount = writeCount = 0;
+  nextSeqLba = UINT32_MAX;
+  usbStats = {};
+  // Without buffers the callbacks still do one multi-block command per request
+  if (!readBuf || !writeBuf) ESP_LOGW(TAG, "No DMA memory for USB caches");
+  return bridgeLock != nullptr;
+}
+
+static void bridgeEnd() {
+  heap_caps_free(readBuf);
+  heap_caps_free(writeBuf);
+  readBuf = writeBuf = nullptr;
+  readCount = writeCount = 0;
+}
+
+static bool overlaps(uint32_t aLba, uint32_t aCount, uint32_t bLba, uint32_t bCount) {
+  return aCount && bCount && aLba < bLba + bCount && bLba < aLba + aCount;
+}
+
+// Caller holds bridgeLock. The host was already told these sectors are
+// written, so on failure they stay buffered for the next flush or eject.
+static bool flushWritesLocked() {
+  if (!writeCount) return true;
+  // Read-ahead data for these sectors predates the write
+  if (overlaps(readLba, readCount, writeLba, writeCount)) readCount = 0;
+  esp_err_t err = sdmmc_write_sectors(card, writeBuf, writeLba, writeCount);
+  usbStats.sdWrites++;
+  if (err != ESP_OK) {
+    ESP_LOGE(TAG, "Write of %u sectors at %u failed: %s", (unsigned)writeCount, (unsigned)writeLba, esp_err_to_name(err));
+    return false;
+  }
+  writeCount = 0;
+  return true;
+}
+
+static bool flushWrites() {
+  if (!bridgeLock) return true;
+  xSemaphoreTake(bridgeLock, portMAX_DELAY);
+  bool ok = flushWritesLocked();
+  xSemaphoreGive(bridgeLock);
+  return ok;
+}
+
 void USBAppShutdown() {
   if (!mscEnabled) return;
 
   ESP_LOGI(TAG, "Shutting down USB MSC...");
+  flushWrites();
 
   // Notify host media removal
   msc.mediaPresent(false);
@@ -30,6 +110,8 @@ void USBAppShutdown() {
     card = nullptr;
   }
 
+  bridgeEnd();
+
   // Deinitialize SDMMC host to clean hardware state
   sdmmc_host_deinit();
 
@@ -62,6 +144,8 @@ void USBAppShutdown() {
 
   if (!SD_MMC.exists("/sys"))     SD_MMC.mkdir("/sys");
   if (!SD_MMC.exists("/journal")) SD_MMC.mkdir("/journal");
+  // FAT leaves a folder's mtime alone when the host adds or deletes files in it
+  DIRCACHE().invalidateAll();
   if (SAVE_POWER) pocketmage::setCpuSpeed(POWER_SAVE_FREQ);
   disableTimeout = false;
 
@@ -70,34 +154,95 @@ void USBAppShutdown() {
 }
 
 static int32_t onWrite(uint32_t lba, uint32_t offset, uint8_t* buffer, uint32_t bufsize) {
-  SDActive = true;
   if (!card || card->csd.sector_size == 0) return -1;
   uint32_t secSize = card->csd.sector_size;
-  for (uint32_t i = 0; i < bufsize / secSize; ++i) {
-    esp_err_t err = sdmmc_write_sectors(card, buffer + i * secSize, lba + i, 1);
-    if (err != ESP_OK) return -1;
+  uint32_t count = bufsize / secSize;
+  if (count == 0) return bufsize;
+
+  SDActive = true;
+  xSemaphoreTake(bridgeLock, portMAX_DELAY);
+  bool ok = true;
+
+  // Read-ahead data for these sectors is stale now
+  if (overlaps(readLba, readCount, lba, count)) readCount = 0;
+
+  bool appends = writeCount && lba == writeLba + writeCount;
+  if (writeCount && (!appends || writeCount + count > USB_CACHE_SECTORS)) ok = flushWritesLocked();
+
+  if (ok && writeBuf && secSize == 512 && count <= USB_CACHE_SECTORS) {
+    if (writeCount == 0) writeLba = lba;
+    memcpy(writeBuf + writeCount * secSize, buffer, bufsize);
+    writeCount += count;
+    if (writeCount == USB_CACHE_SECTORS) ok = flushWritesLocked();
+  } else if (ok) {
+    ok = sdmmc_write_sectors(card, buffer, lba, count) == ESP_OK;
+    usbStats.sdWrites++;
   }
+
+  usbStats.bytesWritten += bufsize;
+  lastWriteMillis = millis();
+  xSemaphoreGive(bridgeLock);
   SDActive = false;
-  return bufsize;
+  return ok ? bufsize : -1;
 }
 
 static int32_t onRead(uint32_t lba, uint32_t offset, void* buffer, uint32_t bufsize) {
-  SDActive = true;
   if (!card || card->csd.sector_size == 0) return -1;
   uint32_t secSize = card->csd.sector_size;
-  for (uint32_t i = 0; i < bufsize / secSize; ++i) {
-    esp_err_t err = sdmmc_read_sectors(card, (uint8_t*)buffer + i * secSize, lba + i, 1);
-    if (err != ESP_OK) return -1;
+  uint32_t count = bufsize / secSize;
+  if (count == 0) return bufsize;
+
+  SDActive = true;
+  xSemaphoreTake(bridgeLock, portMAX_DELAY);
+  bool ok = true;
+
+  bool hit = count <= readCount && lba >= readLba && lba + count <= readLba + readCount;
+  // Sequential stream: fetch this request plus the following sectors
+  bool readAhead = !hit && readBuf && secSize == 512 && lba == nextSeqLba &&
+                   count <= USB_CACHE_SECTORS && lba + USB_CACHE_SECTORS <= (uint32_t)card->csd.capacity;
+  uint32_t fetch = readAhead ? USB_CACHE_SECTORS : count;
+
+  // The card must hold anything the host wrote before it is read back,
+  // including sectors that only land in the read-ahead window
+  if (overlaps(writeLba, writeCount, lba, fetch)) {
+    ok = flushWritesLocked();
+    hit = false;
+  }
+
+  if (ok && hit) {
+    memcpy(buffer, readBuf + (lba - readLba) * secSize, bufsize);
+    usbStats.cacheHits++;
+  } else if (ok && readAhead) {
+    ok = sdmmc_read_sectors(card, readBuf, lba, fetch) == ESP_OK;
+    usbStats.sdReads++;
+    if (ok) {
+      readLba = lba;
+      readCount = fetch;
+      memcpy(buffer, readBuf, bufsize);
+    } else {
+      readCount = 0;
+    }
+  } else if (ok) {
+    ok = sdmmc_read_sectors(card, buffer, lba, count) == ESP_OK;
+    usbStats.sdReads++;
   }
+
+  nextSeqLba = lba + count;
+  usbStats.bytesRead += bufsize;
+  xSemaphoreGive(bridgeLock);
   SDActive = false;
-  return bufsize;
+  return ok ? bufsize : -1;
 }
 
 static bool onStartStop(uint8_t power_condition, bool start, bool eject) {
-  SDActive = true;
   ESP_LOGI(TAG, "MSC Start/Stop: power=%u, start=%d, eject=%d\n", power_condition, start, eject);
 
-  SDActive = false;
+  // Host is done with the medium; nothing may stay in RAM
+  if (!start || eject) {
+    SDActive = true;
+    flushWrites();
+    SDActive = false;
+  }
   return true;
 }
 
@@ -130,6 +275,9 @@ void USB_INIT() {
 
   ESP_LOGI(TAG, "Unmounting SD_MMC for USB MSC...");
 
+  flushRecordStores(true); // The host owns the card until reboot
+  FILEINDEX().rebuild();   // Drop the open walk handle; rescan once remounted
+  TEXTINDEX().closeFiles();
   SD_MMC.end();  // unmount FS before raw access
 
   // Configure SDMMC host and slot manually
@@ -171,6 +319,13 @@ void USB_INIT() {
     return;
   }
 
+  if (!bridgeBegin()) {
+    ESP_LOGE(TAG, "Failed to create USB bridge lock");
+    free(card);
+    card = nullptr;
+    return;
+  }
+
   // Setup USB MSC
   ESP_LOGI(TAG, "Initializing USB MSC...");
 
@@ -196,8 +351,42 @@ void USB_INIT() {
   newState = true;
 }
 
+// Throughput over the last second and totals since connect, e.g.
+// "R 812K/s W 640K/s" / "12.4M read 3.1M written"
+static void updateUsbStatsLine() {
+  static unsigned long lastMillis = 0;
+  static uint64_t lastRead = 0, lastWritten = 0;
+
+  unsigned long now = millis();
+  if (now - lastMillis < 1000) return;
+  unsigned long dt = now - lastMillis;
+  lastMillis = now;
+
+  UsbStats s = usbStats;
+  uint32_t rKBs = (uint32_t)((s.bytesRead - lastRead) * 1000 / dt / 1024);
+  uint32_t wKBs = (uint32_t)((s.bytesWritten - lastWritten) * 1000 / dt / 1024);
+  lastRead = s.bytesRead;
+  lastWritten = s.bytesWritten;
+
+  char line[64];
+  snprintf(line, sizeof(line), "R %luK/s W %luK/s  %.1fM/%.1fM",
+           (unsigned long)rKBs, (unsigned long)wKBs,
+           s.bytesRead / 1048576.0f, s.bytesWritten / 1048576.0f);
+  currentLine = line;
+  ESP_LOGD(TAG, "%s (%lu SD reads, %lu cache hits, %lu SD writes)", line,
+           (unsigned long)s.sdReads, (unsigned long)s.cacheHits, (unsigned long)s.sdWrites);
+}
+
 void processKB_USB() {
   int currentMillis = millis();
+
+  // Push out coalesced writes once the host pauses; a failed flush is
+  // retried after another pause
+  if (writeCount && millis() - lastWriteMillis >= USB_WRITE_FLUSH_MS && !flushWrites()) {
+    lastWriteMillis = millis();
+  }
+  updateUsbStatsLine();
+
   //Make sure oled only updates at 10FPS
   if (currentMillis - OLEDFPSMillis >= (1000/10 /*OLED_MAX_FPS*/)) {
     OLEDFPSMillis = currentMillis;
@@ -2,6 +2,10 @@
 // @Ashtf 2025
 
 #include <globals.h>
+#include "io_session.h"
+#include "record_store.h"
+#include "file_index.h"
+#include "text_index.h"
 
 static constexpr const char* TAG = "MAIN"; // TODO: Come up with a better tag
 
@@ -142,11 +146,21 @@ void loop() {
     if (DEBUG_VERBOSE) printDebug();
 
     if (DEBUG_VERBOSE) PowerSystem.printDiagnostics();
+
+    // Write back table edits once the user has paused
+    flushRecordStores();
+
+    // Keep the quick-open and search indexes current (in short slices)
+    FILEINDEX().poll();
+    TEXTINDEX().poll();
   #endif
 
   updateBattState();
   processKB();
 
+  // Drop the CPU clock once SD sessions have been idle for a while
+  IOSESSION().poll();
+
   // Yield to watchdog
   vTaskDelay(50 / portTICK_PERIOD_MS);
   yield();
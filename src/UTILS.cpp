@@ -1,4 +1,8 @@
 #include<globals.h>
+#include "io_session.h"
+#include "record_store.h"
+#include "doc_writer.h"
+#include "edit_journal.h"
 static constexpr const char* TAG = "UTILS";
 
 static uint8_t prevSec = 0;  
@@ -18,6 +22,9 @@ void printDebug() {
     // Display system time
     ESP_LOGD(TAG, "SYSTEM_CLOCK: %d/%d/%d (%s) %d:%d:%d", now.month(), now.day(), now.year(),
         daysOfTheWeek[now.dayOfTheWeek()], now.hour(), now.minute(), now.second());
+
+    // Time spent at each CPU frequency, once a minute
+    if (now.second() == 0) IOSESSION().logStats();
     }
 }
 
@@ -114,10 +121,9 @@ void checkTimeout() {
 
         CurrentAppState = HOME;
         CurrentHOMEState = NOWLATER;
-        //OTA_APP: remove updateTaskArray and sortTasksByDueDate
+        //OTA_APP: remove updateTaskArray
         #if !OTA_APP
         updateTaskArray();
-        sortTasksByDueDate(tasks);
         #endif
         OLED().setPowerSave(true);
         disableTimeout = true;
@@ -375,13 +381,19 @@ void saveEditingFile() {
 
     if (!OTA_APP){
         OLED().oledWord("Saving Work");
+        // Every sleep path comes through here; commit pending table edits
+        flushRecordStores(true);
         //pocketmage::file::saveFile();
         String savePath = SD().getEditingFile();
-        if (savePath != "" && savePath != "-" && savePath != "/temp.txt" && fileLoaded) {
+        if (savePath != "" && savePath != "-" && savePath != "/temp.txt" && fileLoaded && editingFileDirty()) {
             if (!savePath.startsWith("/")) savePath = "/" + savePath;
-            ESP_LOGE(TAG, "Saving MarkdownFile");
-            saveMarkdownFile(SD().getEditingFile());
-            ESP_LOGE(TAG, "Done saving MarkdownFile");
+            // Appending the last few seconds of edits to the journal is enough;
+            // they are replayed when the note is loaded again
+            if (!flushEditJournal()) {
+                ESP_LOGE(TAG, "Saving MarkdownFile");
+                saveMarkdownFile(SD().getEditingFile());
+                ESP_LOGE(TAG, "Done saving MarkdownFile");
+            }
         }
     } 
 }
@@ -0,0 +1,210 @@
+#include <globals.h>
+#include "dir_cache.h"
+#include "io_session.h"
+#if !OTA_APP // POCKETMAGE_OS
+
+static constexpr const char* TAG = "DIRCACHE";
+
+// Defined in FILEWIZ.cpp
+extern std::vector<String> excludedPaths;
+
+DirCache& DIRCACHE() {
+  static DirCache instance;
+  return instance;
+}
+
+static String normalizeFolder(const String& folder) {
+  if (folder.length() > 1 && folder.endsWith("/")) return folder.substring(0, folder.length() - 1);
+  return folder;
+}
+
+static char typeFor(const char* name, uint16_t len, uint16_t dot, bool isDir) {
+  if (isDir) return 'F';
+  if (dot >= len) return 'G';
+  const char* ext = name + dot;
+  if (strcasecmp(ext, ".txt") == 0) return 'T';
+  if (strcasecmp(ext, ".tar") == 0) return 'A';
+  return 'G';
+}
+
+// Folders sort before files; within each group by the first three characters
+// ignoring case. Only entries with equal keys need a full name comparison.
+static uint32_t sortKey(const char* name, bool isDir) {
+  uint32_t key = isDir ? 0 : 0x80000000u;
+  for (int i = 0; i < 3; i++) {
+    uint8_t c = name[0] ? (uint8_t)tolower(*name++) : 0;
+    key |= (uint32_t)c << (16 - 8 * i);
+  }
+  return key;
+}
+
+// ===================== SCAN =====================
+
+DirCache::Dir* DirCache::slotFor(const String& folder) {
+  Dir* lru = &dirs[0];
+  for (int i = 0; i < DIR_CACHE_SLOTS; i++) {
+    if (dirs[i].path == folder) return &dirs[i];
+    if (dirs[i].lastUse < lru->lastUse) lru = &dirs[i];
+  }
+  *lru = Dir();
+  lru->path = folder;
+  return lru;
+}
+
+void DirCache::scan(Dir& d, File& dir) {
+  d.entries.clear();
+  d.arena.clear();
+
+  // Names inside this folder that excludedPaths hides
+  std::vector<String> hidden;
+  String prefix = d.path == "/" ? String("/") : d.path + "/";
+  for (auto& ex : excludedPaths) {
+    if (ex.length() > prefix.length() && ex.substring(0, prefix.length()).equalsIgnoreCase(prefix) &&
+        ex.indexOf('/', prefix.length()) < 0) {
+      hidden.push_back(ex.substring(prefix.length()));
+    }
+  }
+
+  bool isDir = false;
+  for (String full = dir.getNextFileName(&isDir); full.length(); full = dir.getNextFileName(&isDir)) {
+    const char* base = full.c_str() + full.lastIndexOf('/') + 1;
+    uint16_t len = strlen(base);
+    if (len == 0) continue;
+
+    bool skip = false;
+    for (auto& h : hidden) {
+      if (h.equalsIgnoreCase(base)) { skip = true; break; }
+    }
+    if (skip) continue;
+
+    const char* dotPtr = isDir ? nullptr : strrchr(base, '.');
+    uint16_t dot = (dotPtr && dotPtr != base) ? dotPtr - base : len;
+
+    Entry e;
+    e.key = sortKey(base, isDir);
+    e.nameOff = d.arena.size();
+    e.nameLen = len;
+    e.dot = dot > 255 ? 255 : dot;
+    e.type = typeFor(base, len, dot, isDir);
+    d.arena.insert(d.arena.end(), base, base + len + 1);
+    d.entries.push_back(e);
+  }
+
+  d.entries.shrink_to_fit();
+  d.arena.shrink_to_fit();
+  d.pageSorted.assign((d.entries.size() + DIR_CACHE_PAGE - 1) / DIR_CACHE_PAGE, 0);
+  d.valid = true;
+  ESP_LOGI(TAG, "Scanned %s: %u entries, %u name bytes", d.path.c_str(),
+           (unsigned)d.entries.size(), (unsigned)d.arena.size());
+}
+
+size_t DirCache::open(const String& folder) {
+  String path = normalizeFolder(folder);
+  Dir* d = slotFor(path);
+  d->lastUse = ++useCounter;
+  cur = d;
+
+  IoSession io;
+  File dir = SD_MMC.open(path);
+  if (!dir || !dir.isDirectory()) {
+    if (dir) dir.close();
+    d->entries.clear();
+    d->arena.clear();
+    d->pageSorted.clear();
+    d->valid = false;
+    return 0;
+  }
+
+  // Cheap signature check before paying for a rescan
+  time_t mtime = dir.getLastWrite();
+  if (!d->valid || mtime != d->mtime) {
+    scan(*d, dir);
+    d->mtime = mtime;
+  }
+  dir.close();
+  return d->entries.size();
+}
+
+void DirCache::invalidate(const String& folder) {
+  String path = normalizeFolder(folder);
+  for (int i = 0; i < DIR_CACHE_SLOTS; i++) {
+    if (dirs[i].path == path) dirs[i].valid = false;
+  }
+}
+
+void DirCache::fileChanged(const String& path) {
+  int slash = path.lastIndexOf('/');
+  invalidate(slash <= 0 ? String("/") : path.substring(0, slash));
+}
+
+void DirCache::invalidateAll() {
+  for (int i = 0; i < DIR_CACHE_SLOTS; i++) dirs[i].valid = false;
+}
+
+// ===================== LAZY PAGE SORT =====================
+
+void DirCache::sortPage(Dir& d, size_t page) {
+  const char* arena = d.arena.data();
+  auto less = [arena](const Entry& a, const Entry& b) {
+    if (a.key != b.key) return a.key < b.key;
+    int c = strcasecmp(arena + a.nameOff, arena + b.nameOff);
+    if (c != 0) return c < 0;
+    return strcmp(arena + a.nameOff, arena + b.nameOff) < 0;
+  };
+
+  // Sorted pages already hold exactly their final entries, so only the gap
+  // between the nearest sorted neighbours has to be partitioned
+  size_t pages = d.pageSorted.size();
+  size_t lo = page, hi = page + 1;
+  while (lo > 0 && !d.pageSorted[lo - 1]) lo--;
+  while (hi < pages && !d.pageSorted[hi]) hi++;
+
+  auto base  = d.entries.begin();
+  auto left  = base + lo * DIR_CACHE_PAGE;
+  auto right = base + std::min(hi * DIR_CACHE_PAGE, d.entries.size());
+  auto first = base + page * DIR_CACHE_PAGE;
+  auto last  = base + std::min((page + 1) * DIR_CACHE_PAGE, d.entries.size());
+
+  if (first != left)  std::nth_element(left, first, right, less);
+  if (last != right)  std::nth_element(first, last, right, less);
+  std::sort(first, last, less);
+  d.pageSorted[page] = 1;
+}
+
+const DirCache::Entry& DirCache::at(size_t idx) {
+  size_t page = idx / DIR_CACHE_PAGE;
+  if (!cur->pageSorted[page]) sortPage(*cur, page);
+  return cur->entries[idx];
+}
+
+// ===================== ACCESSORS =====================
+
+String DirCache::name(size_t idx) {
+  const Entry& e = at(idx);
+  const char* n = cur->arena.data() + e.nameOff;
+  if (e.dot >= e.nameLen) return String(n);
+  String s;
+  s.reserve(e.dot);
+  for (uint16_t i = 0; i < e.dot; i++) s += n[i];
+  return s;
+}
+
+String DirCache::extension(size_t idx) {
+  const Entry& e = at(idx);
+  if (e.dot >= e.nameLen) return "";
+  return String(cur->arena.data() + e.nameOff + e.dot);
+}
+
+String DirCache::path(size_t idx) {
+  const Entry& e = at(idx);
+  String p = cur->path;
+  if (!p.endsWith("/")) p += "/";
+  p += cur->arena.data() + e.nameOff;
+  return p;
+}
+
+char DirCache::type(size_t idx) {
+  return at(idx).type;
+}
+
+#endif
@@ -0,0 +1,70 @@
+#pragma once
+#include <Arduino.h>
+#include <vector>
+
+// ===================== DIRECTORY CACHE =====================
+// Listing cache for the file wizard. A scan reads only names (no File object
+// per entry) into one character arena; each entry is a fixed 12-byte record
+// with a 32-bit sort key (folder flag + first three case-folded characters).
+//
+// Sorting is lazy and paged: the first time an entry is requested, only its
+// page of DIR_CACHE_PAGE entries is put into final order (nth_element between
+// the nearest already-sorted pages, then a sort of the page itself). Opening a
+// folder of thousands of journal days costs one name scan and one page sort.
+//
+// Recently used folders stay cached. A folder is rescanned when its mtime
+// signature changes or when a writer calls fileChanged()/invalidate(). FAT
+// does not update a folder's mtime when entries come and go, so every change
+// made on the device goes through those calls, and USB mass storage drops
+// the whole cache with invalidateAll() when the card comes back.
+
+#define DIR_CACHE_SLOTS 4
+#define DIR_CACHE_PAGE  32
+
+class DirCache {
+public:
+  // Make folder current, rescanning only when needed. Returns the entry count.
+  size_t open(const String& folder);
+  size_t size() const { return cur ? cur->entries.size() : 0; }
+
+  // Entries in display order: folders first, then files, by name
+  String name(size_t idx);        // base name without extension
+  String extension(size_t idx);   // including the dot, "" if none
+  String path(size_t idx);        // full path, e.g. "/journal/20250101.txt"
+  char   type(size_t idx);        // 'T' txt, 'F' folder, 'A' app (.tar), 'G' other
+
+  // Drop the cached listing of a folder / of the folder containing path
+  void invalidate(const String& folder);
+  void fileChanged(const String& path);
+  void invalidateAll();
+
+private:
+  struct Entry {
+    uint32_t key;       // bit 31 = file, then 3 case-folded chars
+    uint32_t nameOff;   // into arena, NUL-terminated
+    uint16_t nameLen;
+    uint8_t  dot;       // index of the extension dot, nameLen if none (capped at 255)
+    char     type;
+  };
+
+  struct Dir {
+    String   path;
+    time_t   mtime = 0;
+    uint32_t lastUse = 0;
+    bool     valid = false;
+    std::vector<Entry>   entries;
+    std::vector<char>    arena;
+    std::vector<uint8_t> pageSorted;
+  };
+
+  Dir      dirs[DIR_CACHE_SLOTS];
+  Dir*     cur = nullptr;
+  uint32_t useCounter = 0;
+
+  Dir* slotFor(const String& folder);
+  void scan(Dir& d, File& dir);
+  const Entry& at(size_t idx);
+  void sortPage(Dir& d, size_t page);
+};
+
+DirCache& DIRCACHE();
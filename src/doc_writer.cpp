@@ -0,0 +1,141 @@
+#include <globals.h>
+#include "esp_heap_caps.h"
+#include "doc_writer.h"
+#include <esp_rom_crc.h>
+#if !OTA_APP // POCKETMAGE_OS
+
+static constexpr const char* TAG = "DOCWRITE";
+
+#define DOC_DONE_MAGIC 0x454E4F44  // "DONE"
+
+struct DocDoneMarker {
+  uint32_t magic;
+  uint32_t length;
+  uint32_t crc;
+};
+
+DocWriter::DocWriter(const String& path) : target(path), tmp(path + DOC_TMP_SUFFIX) {
+  if (psramFound()) buf = (uint8_t*)heap_caps_malloc(DOC_WRITE_BUFFER, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+  if (!buf) buf = (uint8_t*)malloc(DOC_WRITE_BUFFER);
+
+  file = SD_MMC.open(tmp.c_str(), FILE_WRITE);
+  good = (bool)file;
+  if (!good) ESP_LOGE(TAG, "Failed to open %s", tmp.c_str());
+}
+
+DocWriter::~DocWriter() {
+  if (!done) {
+    if (file) file.close();
+    SD_MMC.remove(tmp.c_str());
+  }
+  if (buf) heap_caps_free(buf);
+}
+
+bool DocWriter::flush() {
+  if (used == 0) return good;
+  if (good && file.write(buf, used) != used) {
+    ESP_LOGE(TAG, "Short write to %s", tmp.c_str());
+    good = false;
+  }
+  used = 0;
+  return good;
+}
+
+void DocWriter::write(const char* s, size_t len) {
+  if (!good) return;
+  length += len;
+  crc = esp_rom_crc32_le(crc, (const uint8_t*)s, len);
+  if (!buf) {
+    // No buffer memory, write straight through
+    if (file.write((const uint8_t*)s, len) != len) good = false;
+    return;
+  }
+  while (len > 0) {
+    if (used == DOC_WRITE_BUFFER && !flush()) return;
+    size_t n = min(len, (size_t)(DOC_WRITE_BUFFER - used));
+    memcpy(buf + used, s, n);
+    used += n;
+    s += n;
+    len -= n;
+  }
+}
+
+bool DocWriter::commit() {
+  flush();
+  if (file) file.close();
+  if (!good) return false;
+
+  // Vouch for the temp file before the original goes away
+  String marker = target + DOC_DONE_SUFFIX;
+  DocDoneMarker m = { DOC_DONE_MAGIC, length, crc };
+  File mf = SD_MMC.open(marker.c_str(), FILE_WRITE);
+  bool marked = mf && mf.write((const uint8_t*)&m, sizeof(m)) == sizeof(m);
+  if (mf) mf.close();
+  if (!marked) {
+    ESP_LOGE(TAG, "Failed to write %s", marker.c_str());
+    SD_MMC.remove(marker.c_str());
+    return false;
+  }
+
+  done = true;
+  SD_MMC.remove(target.c_str());
+  if (!SD_MMC.rename(tmp.c_str(), target.c_str())) {
+    // recoverDocument() will finish the swap on the next load
+    ESP_LOGE(TAG, "Rename %s failed", tmp.c_str());
+    return false;
+  }
+  SD_MMC.remove(marker.c_str());
+  return true;
+}
+
+// True if the marker matches the temp file's length and contents
+static bool tmpComplete(const String& tmp, const String& marker) {
+  DocDoneMarker m = {};
+  File mf = SD_MMC.open(marker.c_str(), FILE_READ);
+  if (!mf) return false;
+  bool ok = mf.read((uint8_t*)&m, sizeof(m)) == sizeof(m) && m.magic == DOC_DONE_MAGIC;
+  mf.close();
+  if (!ok) return false;
+
+  File f = SD_MMC.open(tmp.c_str(), FILE_READ);
+  if (!f) return false;
+  ok = f.size() == m.length;
+  uint32_t crc = 0;
+  uint8_t chunk[512];
+  while (ok) {
+    int n = f.read(chunk, sizeof(chunk));
+    if (n <= 0) break;
+    crc = esp_rom_crc32_le(crc, chunk, n);
+  }
+  f.close();
+  return ok && crc == m.crc;
+}
+
+void recoverDocument(const String& path) {
+  String tmp = path + DOC_TMP_SUFFIX;
+  String marker = path + DOC_DONE_SUFFIX;
+  if (!SD_MMC.exists(tmp.c_str())) {
+    if (SD_MMC.exists(marker.c_str())) SD_MMC.remove(marker.c_str());
+    return;
+  }
+
+  if (SD_MMC.exists(path.c_str())) {
+    // The save never finished; the original is intact
+    ESP_LOGW(TAG, "Discarding unfinished save %s", tmp.c_str());
+    SD_MMC.remove(tmp.c_str());
+  } else if (tmpComplete(tmp, marker)) {
+    // Lost power between remove and rename
+    ESP_LOGW(TAG, "Recovering %s", path.c_str());
+    SD_MMC.rename(tmp.c_str(), path.c_str());
+  } else {
+    // Cut short (e.g. the first save of a new note); keep it aside for the
+    // user rather than passing it off as the document
+    String lost = path + DOC_LOST_SUFFIX;
+    ESP_LOGW(TAG, "Incomplete save kept as %s", lost.c_str());
+    SD_MMC.remove(lost.c_str());
+    SD_MMC.rename(tmp.c_str(), lost.c_str());
+  }
+  SD_MMC.remove(marker.c_str());
+}
+
+#endif
@@ -0,0 +1,56 @@
+#pragma once
+#include <Arduino.h>
+#include <FS.h>
+
+// ===================== DOCUMENT WRITER =====================
+// Crash-safe saves for user documents. The new contents are written to
+// "<path>.tmp" through a large RAM buffer (a handful of big SD writes instead
+// of one per paragraph); only a complete write replaces the original:
+//
+//   DocWriter out(path);
+//   out.write("# "); out.write(title); out.write("\r\n");
+//   if (!out.commit()) ...   // original left untouched
+//
+// Call recoverDocument() before opening a document, to finish or discard a
+// save that was interrupted by a crash or power loss. A complete temp file is
+// vouched for by "<path>.tmp.done" (its length and CRC), written before the
+// original is removed; a temp file without one is never promoted.
+
+#define DOC_WRITE_BUFFER  16384   // bytes collected before each SD write
+#define DOC_TMP_SUFFIX    ".tmp"
+#define DOC_DONE_SUFFIX   ".tmp.done"
+#define DOC_LOST_SUFFIX   ".recovered"
+
+class DocWriter {
+public:
+  explicit DocWriter(const String& path);
+  // Discards the temp file if commit() was never reached
+  ~DocWriter();
+
+  bool ok() const { return good; }
+
+  void write(const char* s, size_t len);
+  void write(const char* s) { write(s, strlen(s)); }
+  void write(const String& s) { write(s.c_str(), s.length()); }
+
+  // Flush, close, and swap the temp file into place
+  bool commit();
+
+private:
+  String   target;
+  String   tmp;
+  File     file;
+  uint8_t* buf = nullptr;
+  size_t   used = 0;
+  uint32_t length = 0;    // bytes accepted so far
+  uint32_t crc = 0;       // of those bytes
+  bool     good = false;
+  bool     done = false;
+
+  bool flush();
+};
+
+void recoverDocument(const String& path);
+
+// True when the TXT editor has edits that are not on SD yet (OS_APPS/TXT_NEW.cpp)
+bool editingFileDirty();
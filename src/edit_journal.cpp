@@ -0,0 +1,235 @@
+#include <globals.h>
+#include "esp_rom_crc.h"
+#include "io_session.h"
+#include "edit_journal.h"
+#if !OTA_APP // POCKETMAGE_OS
+
+static constexpr const char* TAG = "EDITJRNL";
+
+#define EDIT_JOURNAL_MAGIC     0x4A454D50  // "PMEJ"
+#define EDIT_JOURNAL_VERSION   1
+#define EDIT_JOURNAL_BLOCK_TAG 0xED17
+#define EDIT_JOURNAL_MAX_BLOCK (256UL * 1024)  // larger lengths are corrupt
+#define EDIT_JOURNAL_COPY_BUF  512
+
+enum JournalOp : uint8_t { JOURNAL_OP_INS = 1, JOURNAL_OP_SET = 2, JOURNAL_OP_DEL = 3 };
+
+struct JournalHeader {
+  uint32_t magic;
+  uint16_t version;
+  uint16_t reserved;
+  uint32_t baseSize;      // note the journal applies to
+  uint32_t baseMtime;
+} __attribute__((packed));
+
+// One flush: this header followed by len bytes of operations
+struct JournalBlock {
+  uint16_t tag;
+  uint16_t ops;
+  uint32_t len;
+  uint32_t crc;           // over the operation bytes
+} __attribute__((packed));
+
+// Operation: this header followed by len bytes of paragraph text (SET only)
+struct JournalOpHeader {
+  uint8_t  op;
+  uint8_t  style;
+  uint16_t len;
+  uint32_t index;
+} __attribute__((packed));
+
+EditJournal& EDITJOURNAL() {
+  static EditJournal instance;
+  return instance;
+}
+
+static void noteStamp(const String& notePath, uint32_t& size, uint32_t& mtime) {
+  size = 0;
+  mtime = 0;
+  File note = SD_MMC.open(notePath.c_str(), FILE_READ);
+  if (!note) return;
+  size = note.size();
+  mtime = note.getLastWrite();
+  note.close();
+}
+
+// Keep the first len bytes of path, dropping a torn tail so later blocks are
+// not appended behind it
+static bool truncateFile(const String& path, size_t len) {
+  String tmp = path + ".tmp";
+  File in = SD_MMC.open(path.c_str(), FILE_READ);
+  File out = SD_MMC.open(tmp.c_str(), FILE_WRITE);
+  bool ok = in && out;
+  uint8_t buf[EDIT_JOURNAL_COPY_BUF];
+  while (ok && len > 0) {
+    size_t n = in.read(buf, min(len, sizeof(buf)));
+    ok = n > 0 && out.write(buf, n) == n;
+    len -= n;
+  }
+  if (in) in.close();
+  if (out) out.close();
+
+  if (ok) {
+    SD_MMC.remove(path.c_str());
+    ok = SD_MMC.rename(tmp.c_str(), path.c_str());
+  } else {
+    SD_MMC.remove(tmp.c_str());
+  }
+  return ok;
+}
+
+bool EditJournal::replay(const String& notePath, InsertFn insertLine, DeleteFn deleteLine, SetFn setLine) {
+  String jpath = notePath + EDIT_JOURNAL_SUFFIX;
+  IoSession io;
+
+  File file = SD_MMC.open(jpath.c_str(), FILE_READ);
+  if (!file) return false;
+
+  uint32_t size, mtime;
+  noteStamp(notePath, size, mtime);
+
+  JournalHeader hdr;
+  if (file.read((uint8_t*)&hdr, sizeof(hdr)) != sizeof(hdr) || hdr.magic != EDIT_JOURNAL_MAGIC ||
+      hdr.version != EDIT_JOURNAL_VERSION || hdr.baseSize != size || hdr.baseMtime != mtime) {
+    ESP_LOGW(TAG, "Discarding %s, it does not match the note", jpath.c_str());
+    file.close();
+    SD_MMC.remove(jpath.c_str());
+    return false;
+  }
+
+  std::vector<uint8_t> buf;
+  size_t good = sizeof(hdr);
+  uint32_t applied = 0;
+  JournalBlock blk;
+  while (file.read((uint8_t*)&blk, sizeof(blk)) == sizeof(blk)) {
+    if (blk.tag != EDIT_JOURNAL_BLOCK_TAG || blk.len > EDIT_JOURNAL_MAX_BLOCK) break;
+    buf.resize(blk.len);
+    if (file.read(buf.data(), blk.len) != blk.len) break;
+    if (esp_rom_crc32_le(0, buf.data(), blk.len) != blk.crc) break;
+
+    const uint8_t* p = buf.data();
+    const uint8_t* end = p + blk.len;
+    while (p + sizeof(JournalOpHeader) <= end) {
+      JournalOpHeader op;
+      memcpy(&op, p, sizeof(op));
+      p += sizeof(op);
+      if (p + op.len > end) break;
+
+      if (op.op == JOURNAL_OP_INS) {
+        insertLine(op.index);
+      } else if (op.op == JOURNAL_OP_DEL) {
+        deleteLine(op.index);
+      } else if (op.op == JOURNAL_OP_SET) {
+        String text;
+        text.concat((const char*)p, op.len);
+        setLine(op.index, (char)op.style, text);
+      }
+      p += op.len;
+      applied++;
+    }
+    good += sizeof(blk) + blk.len;
+  }
+  bool torn = good != file.size();
+  file.close();
+
+  if (torn) {
+    ESP_LOGW(TAG, "Dropping torn tail of %s", jpath.c_str());
+    if (!truncateFile(jpath, good)) SD_MMC.remove(jpath.c_str());
+  }
+  ESP_LOGI(TAG, "Replayed %lu edits from %s", (unsigned long)applied, jpath.c_str());
+  return applied > 0;
+}
+
+void EditJournal::begin(const String& notePath) {
+  pending.clear();
+  pendingOps = 0;
+  path = notePath + EDIT_JOURNAL_SUFFIX;
+
+  IoSession io;
+  noteStamp(notePath, baseSize, baseMtime);
+}
+
+void EditJournal::end() {
+  flush();
+  path = "";
+}
+
+void EditJournal::clear() {
+  pending.clear();
+  pendingOps = 0;
+  if (!active()) return;
+
+  IoSession io;
+  SD_MMC.remove(path.c_str());
+  path = "";
+}
+
+void EditJournal::remove(const String& notePath) {
+  String jpath = notePath + EDIT_JOURNAL_SUFFIX;
+  if (jpath == path) {
+    clear();
+    return;
+  }
+  IoSession io;
+  if (SD_MMC.exists(jpath.c_str())) SD_MMC.remove(jpath.c_str());
+}
+
+void EditJournal::queue(uint8_t op, uint32_t index, char style, const char* text, uint16_t len) {
+  if (!active()) return;
+  JournalOpHeader h = { op, (uint8_t)style, len, index };
+  const uint8_t* hp = (const uint8_t*)&h;
+  pending.insert(pending.end(), hp, hp + sizeof(h));
+  pending.insert(pending.end(), (const uint8_t*)text, (const uint8_t*)text + len);
+  pendingOps++;
+}
+
+void EditJournal::insertLine(uint32_t index) {
+  queue(JOURNAL_OP_INS, index, 0, "", 0);
+}
+
+void EditJournal::deleteLine(uint32_t index) {
+  queue(JOURNAL_OP_DEL, index, 0, "", 0);
+}
+
+void EditJournal::setLine(uint32_t index, char style, const String& text) {
+  queue(JOURNAL_OP_SET, index, style, text.c_str(), min(text.length(), (unsigned)UINT16_MAX));
+}
+
+bool EditJournal::flush() {
+  if (!active()) return false;
+  if (!pendingOps) return true;
+
+  IoSession io;
+  File file = SD_MMC.open(path.c_str(), FILE_APPEND);
+  if (!file) {
+    ESP_LOGE(TAG, "Failed to open %s for append", path.c_str());
+    return false;
+  }
+
+  // Header (first flush only), block header and operations go out in one write
+  size_t before = file.size();
+  std::vector<uint8_t> out;
+  if (before == 0) {
+    JournalHeader hdr = { EDIT_JOURNAL_MAGIC, EDIT_JOURNAL_VERSION, 0, baseSize, baseMtime };
+    out.insert(out.end(), (const uint8_t*)&hdr, (const uint8_t*)&hdr + sizeof(hdr));
+  }
+  JournalBlock blk = { EDIT_JOURNAL_BLOCK_TAG, pendingOps, (uint32_t)pending.size(),
+                       esp_rom_crc32_le(0, pending.data(), pending.size()) };
+  out.insert(out.end(), (const uint8_t*)&blk, (const uint8_t*)&blk + sizeof(blk));
+  out.insert(out.end(), pending.begin(), pending.end());
+
+  bool ok = file.write(out.data(), out.size()) == out.size();
+  file.close();
+
+  if (!ok) {
+    // Cut the partial block off again, or replay would stop in front of it
+    ESP_LOGE(TAG, "Write to %s failed, edits kept in RAM", path.c_str());
+    truncateFile(path, before);
+    return false;
+  }
+  pending.clear();
+  pendingOps = 0;
+  return true;
+}
+
+#endif
@@ -0,0 +1,67 @@
+#pragma once
+#include <Arduino.h>
+#include <FS.h>
+#include <vector>
+
+// ===================== EDIT JOURNAL =====================
+// Power-loss protection for the TXT editor without rewriting the note. Edits
+// are appended to "<note>.journal" every EDIT_JOURNAL_FLUSH_MS as one
+// CRC-checked block of paragraph operations:
+//
+//   INS index               empty paragraph inserted at index
+//   DEL index               paragraph at index removed (undo of an INS)
+//   SET index style text    paragraph at index now reads text
+//
+// Loading a note replays its journal on top of the saved file. A normal save
+// writes the whole note and deletes the journal. The header records the size
+// and mtime of the note the journal was started against, so a journal left
+// behind for a note that was since changed elsewhere (e.g. over USB) is
+// discarded instead of being applied to the wrong text. A torn final block
+// fails its CRC and is dropped, losing at most one flush interval of typing.
+
+#define EDIT_JOURNAL_SUFFIX    ".journal"
+#define EDIT_JOURNAL_FLUSH_MS  3000
+
+class EditJournal {
+public:
+  typedef void (*InsertFn)(uint32_t index);
+  typedef void (*DeleteFn)(uint32_t index);
+  typedef void (*SetFn)(uint32_t index, char style, const String& text);
+
+  // Apply the journal of notePath, as loaded, through the callbacks.
+  // Returns true if any edits were replayed.
+  bool replay(const String& notePath, InsertFn insertLine, DeleteFn deleteLine, SetFn setLine);
+
+  // Journal further edits of notePath against its current contents on SD
+  void begin(const String& notePath);
+  // Write pending operations and stop journaling
+  void end();
+  // The note was saved in full: drop pending operations and the journal
+  void clear();
+  // Delete the journal of a note that was deleted or recreated
+  void remove(const String& notePath);
+
+  bool active() const { return path.length() > 0; }
+
+  void insertLine(uint32_t index);
+  void deleteLine(uint32_t index);
+  void setLine(uint32_t index, char style, const String& text);
+
+  // Append pending operations as one block
+  bool flush();
+
+private:
+  String   path;        // journal file, "" when inactive
+  uint32_t baseSize = 0;
+  uint32_t baseMtime = 0;
+  std::vector<uint8_t> pending;
+  uint16_t pendingOps = 0;
+
+  void queue(uint8_t op, uint32_t index, char style, const char* text, uint16_t len);
+};
+
+EditJournal& EDITJOURNAL();
+
+// TXT editor: journal the paragraphs edited since the last flush
+// (OS_APPS/TXT_NEW.cpp). False if the open note has no journal.
+bool flushEditJournal();
@@ -0,0 +1,383 @@
+#include <globals.h>
+#include "file_index.h"
+#include "io_session.h"
+#include "dir_cache.h"
+#include "text_index.h"
+#include <esp_rom_crc.h>
+#if !OTA_APP // POCKETMAGE_OS
+
+static constexpr const char* TAG = "FILEINDEX";
+
+#define FILE_INDEX_MAGIC   0x49464D50  // "PMFI"
+#define FILE_INDEX_VERSION 1
+
+// Defined in FILEWIZ.cpp
+extern std::vector<String> excludedPaths;
+
+struct FileIndexHeader {
+  uint32_t magic;
+  uint16_t version;
+  uint16_t reserved;
+  uint32_t count;
+  uint32_t bytes;     // NUL-terminated paths, in index order
+  uint32_t crc;       // of the path bytes
+};
+
+FileIndex& FILEINDEX() {
+  static FileIndex instance;
+  return instance;
+}
+
+void fileWritten(const String& path) {
+  DIRCACHE().fileChanged(path);
+  FILEINDEX().fileAdded(path);
+  TEXTINDEX().fileChanged(path);
+}
+
+void fileDeleted(const String& path) {
+  DIRCACHE().fileChanged(path);
+  FILEINDEX().fileRemoved(path);
+  TEXTINDEX().fileRemoved(path);
+}
+
+bool keyboardIdleFor(uint32_t ms) {
+  static unsigned long lastKey = 0;
+  if (digitalRead(KB_IRQ) == 0) lastKey = millis();
+  return millis() - lastKey >= ms;
+}
+
+// ===================== ORDERING =====================
+
+FileIndex::Entry FileIndex::makeEntry(const char* p) {
+  Entry e = {};
+  size_t len = strlen(p);
+  const char* slash = strrchr(p, '/');
+  e.pathOff = arena.size();
+  e.pathLen = len;
+  e.baseOff = slash ? slash - p + 1 : 0;
+  e.gen = gen;
+  arena.insert(arena.end(), p, p + len + 1);
+  return e;
+}
+
+// First entry whose file name is not below name[0..len) ignoring case. Entries
+// sharing that prefix follow it contiguously.
+size_t FileIndex::lowerBound(const char* name, size_t len) const {
+  size_t lo = 0, hi = entries.size();
+  while (lo < hi) {
+    size_t mid = (lo + hi) / 2;
+    if (strncasecmp(base(entries[mid]), name, len) < 0) lo = mid + 1;
+    else hi = mid;
+  }
+  return lo;
+}
+
+int FileIndex::indexOf(const char* p) const {
+  const char* slash = strrchr(p, '/');
+  const char* b = slash ? slash + 1 : p;
+  size_t blen = strlen(b);
+  for (size_t i = lowerBound(b, blen); i < entries.size(); i++) {
+    if (strcasecmp(base(entries[i]), b) != 0) break;
+    if (strcasecmp(path(entries[i]), p) == 0) return i;
+  }
+  return -1;
+}
+
+void FileIndex::sortEntries() {
+  const char* a = arena.data();
+  std::sort(entries.begin(), entries.end(), [a](const Entry& x, const Entry& y) {
+    int c = strcasecmp(a + x.pathOff + x.baseOff, a + y.pathOff + y.baseOff);
+    if (c != 0) return c < 0;
+    if (x.pathLen != y.pathLen) return x.pathLen < y.pathLen;
+    return strcasecmp(a + x.pathOff, a + y.pathOff) < 0;
+  });
+}
+
+void FileIndex::insertSorted(const Entry& e) {
+  const char* b = base(e);
+  size_t pos = lowerBound(b, strlen(b) + 1);
+  entries.insert(entries.begin() + pos, e);
+}
+
+bool FileIndex::excluded(const String& p) const {
+  for (auto& ex : excludedPaths) {
+    if (p.equalsIgnoreCase(ex)) return true;
+  }
+  return false;
+}
+
+// ===================== UPDATES =====================
+
+void FileIndex::fileAdded(const String& p) {
+  if (!loaded) load();
+  if (p.length() == 0 || p.endsWith("/")) return;
+  for (auto& ex : excludedPaths) {
+    if (p.length() > ex.length() && p.charAt(ex.length()) == '/' &&
+        p.substring(0, ex.length()).equalsIgnoreCase(ex)) return;
+  }
+
+  int idx = indexOf(p.c_str());
+  if (idx >= 0) {
+    entries[idx].gen = gen;
+    return;
+  }
+  insertSorted(makeEntry(p.c_str()));
+  dirty = true;
+  lastEdit = millis();
+}
+
+void FileIndex::fileRemoved(const String& p) {
+  // A running walk may already have queued the file; it must not come back
+  for (size_t i = 0; i < pending.size();) {
+    if (strcasecmp(path(pending[i]), p.c_str()) == 0) {
+      garbage += pending[i].pathLen + 1;
+      pending.erase(pending.begin() + i);
+    }
+    else i++;
+  }
+
+  int idx = indexOf(p.c_str());
+  if (idx < 0) return;
+  garbage += entries[idx].pathLen + 1;
+  entries.erase(entries.begin() + idx);
+  dirty = true;
+  lastEdit = millis();
+}
+
+// ===================== BACKGROUND WALK =====================
+
+void FileIndex::rebuild() {
+  if (walkDir) walkDir.close();
+  walkDir = File();
+  dirStack.clear();
+  dirStack.push_back("/");
+  pending.clear();
+  gen++;
+  walkDone = false;
+}
+
+void FileIndex::walkSlice() {
+  IoSession io;
+  unsigned long start = millis();
+
+  while (millis() - start < FILE_INDEX_SLICE_MS) {
+    if (!walkDir) {
+      if (dirStack.empty()) {
+        finishWalk();
+        return;
+      }
+      walkPath = dirStack.back();
+      dirStack.pop_back();
+      walkDir = SD_MMC.open(walkPath);
+      if (!walkDir || !walkDir.isDirectory()) {
+        if (walkDir) walkDir.close();
+        walkDir = File();
+      }
+      continue;
+    }
+
+    bool isDir = false;
+    String name = walkDir.getNextFileName(&isDir);
+    if (name.length() == 0) {
+      walkDir.close();
+      walkDir = File();
+      continue;
+    }
+
+    String full = walkPath == "/" ? String("") : walkPath;
+    full += "/";
+    full += name.substring(name.lastIndexOf('/') + 1);
+
+    if (isDir) {
+      if (!excluded(full)) dirStack.push_back(full);
+    }
+    else {
+      int idx = indexOf(full.c_str());
+      if (idx >= 0) entries[idx].gen = gen;
+      else pending.push_back(makeEntry(full.c_str()));
+    }
+  }
+}
+
+// Drop files the walk did not see, merge the new ones and restore the order
+void FileIndex::finishWalk() {
+  size_t before = entries.size();
+  size_t out = 0;
+  for (size_t i = 0; i < entries.size(); i++) {
+    if (entries[i].gen == gen) entries[out++] = entries[i];
+    else garbage += entries[i].pathLen + 1;
+  }
+  entries.resize(out);
+  size_t removed = before - out;
+  size_t added = pending.size();
+
+  if (added) {
+    entries.insert(entries.end(), pending.begin(), pending.end());
+    sortEntries();
+
+    // A file reported by fileAdded() during the walk may have been found too
+    out = 0;
+    for (size_t i = 0; i < entries.size(); i++) {
+      if (out > 0 && strcasecmp(path(entries[out - 1]), path(entries[i])) == 0) {
+        garbage += entries[i].pathLen + 1;
+        added--;
+        continue;
+      }
+      entries[out++] = entries[i];
+    }
+    entries.resize(out);
+  }
+  pending.clear();
+  pending.shrink_to_fit();
+  walkDone = true;
+  walkCount++;
+
+  if (added || removed) {
+    dirty = true;
+    lastEdit = millis() - FILE_INDEX_SAVE_MS;
+  }
+  ESP_LOGI(TAG, "Walk done: %u files (+%u, -%u)", (unsigned)entries.size(), (unsigned)added, (unsigned)removed);
+}
+
+// ===================== PERSISTENCE =====================
+
+bool FileIndex::load() {
+  loaded = true;
+  IoSession io;
+
+  File f = SD_MMC.open(FILE_INDEX_PATH, FILE_READ);
+  if (!f) return false;
+
+  FileIndexHeader hdr;
+  bool ok = f.read((uint8_t*)&hdr, sizeof(hdr)) == sizeof(hdr) &&
+            hdr.magic == FILE_INDEX_MAGIC && hdr.version == FILE_INDEX_VERSION &&
+            hdr.bytes == f.size() - sizeof(hdr);
+  std::vector<char> bytes;
+  if (ok) {
+    bytes.resize(hdr.bytes);
+    ok = f.read((uint8_t*)bytes.data(), hdr.bytes) == hdr.bytes &&
+         esp_rom_crc32_le(0, (const uint8_t*)bytes.data(), hdr.bytes) == hdr.crc &&
+         (hdr.bytes == 0 || bytes.back() == '\0');
+  }
+  f.close();
+
+  if (!ok) {
+    ESP_LOGW(TAG, "Index file invalid, rebuilding");
+    return false;
+  }
+
+  arena.swap(bytes);
+  garbage = 0;
+  entries.clear();
+  entries.reserve(hdr.count);
+  for (size_t off = 0; off < arena.size() && entries.size() < hdr.count;) {
+    const char* p = arena.data() + off;
+    size_t len = strlen(p);
+    const char* slash = strrchr(p, '/');
+    Entry e = {};
+    e.pathOff = off;
+    e.pathLen = len;
+    e.baseOff = slash ? slash - p + 1 : 0;
+    e.gen = gen;
+    entries.push_back(e);
+    off += len + 1;
+  }
+  haveSaved = true;
+  ESP_LOGI(TAG, "Loaded %u files", (unsigned)entries.size());
+  return true;
+}
+
+// Writes the compacted path list to a temporary file, then replaces the index
+void FileIndex::save() {
+  // Files queued by a running walk share the arena and move with the rest;
+  // only the merged entries are written
+  std::vector<char> packed;
+  packed.reserve(arena.size() - garbage);
+  for (auto& e : entries) {
+    const char* p = path(e);
+    e.pathOff = packed.size();
+    packed.insert(packed.end(), p, p + e.pathLen + 1);
+  }
+  size_t savedBytes = packed.size();
+  for (auto& e : pending) {
+    const char* p = path(e);
+    e.pathOff = packed.size();
+    packed.insert(packed.end(), p, p + e.pathLen + 1);
+  }
+  arena.swap(packed);
+  garbage = 0;
+  dirty = false;
+
+  IoSession io;
+  FileIndexHeader hdr = {};
+  hdr.magic = FILE_INDEX_MAGIC;
+  hdr.version = FILE_INDEX_VERSION;
+  hdr.count = entries.size();
+  hdr.bytes = savedBytes;
+  hdr.crc = esp_rom_crc32_le(0, (const uint8_t*)arena.data(), savedBytes);
+
+  File f = SD_MMC.open(FILE_INDEX_TMP, FILE_WRITE);
+  if (!f) {
+    ESP_LOGE(TAG, "Failed to open %s", FILE_INDEX_TMP);
+    return;
+  }
+  bool ok = f.write((const uint8_t*)&hdr, sizeof(hdr)) == sizeof(hdr) &&
+            f.write((const uint8_t*)arena.data(), savedBytes) == savedBytes;
+  f.close();
+
+  if (!ok) {
+    ESP_LOGE(TAG, "Short write to %s", FILE_INDEX_TMP);
+    SD_MMC.remove(FILE_INDEX_TMP);
+    return;
+  }
+  SD_MMC.remove(FILE_INDEX_PATH);
+  SD_MMC.rename(FILE_INDEX_TMP, FILE_INDEX_PATH);
+  haveSaved = true;
+}
+
+void FileIndex::poll() {
+  if (mscEnabled || SD().getNoSD()) return;
+
+  // First pass after boot: serve the saved copy, verify it in the background
+  if (!loaded) load();
+  if (gen == 0) {
+    rebuild();
+    return;
+  }
+
+  // Never take SD time while the user is typing or another session is open
+  if (!walkDone && IOSESSION().depth() == 0 && keyboardIdleFor(FILE_INDEX_IDLE_MS)) {
+    walkSlice();
+  }
+
+  if (dirty && millis() - lastEdit >= FILE_INDEX_SAVE_MS && keyboardIdleFor(FILE_INDEX_IDLE_MS)) {
+    save();
+  }
+}
+
+// ===================== LOOKUP =====================
+
+String FileIndex::find(const String& name) {
+  if (name.length() == 0) return "";
+  String withExt = name + ".txt";
+  const Entry* best = nullptr;
+
+  for (size_t i = lowerBound(name.c_str(), name.length()); i < entries.size(); i++) {
+    const char* b = base(entries[i]);
+    if (strncasecmp(b, name.c_str(), name.length()) != 0) break;
+    if (strcasecmp(b, name.c_str()) != 0 && strcasecmp(b, withExt.c_str()) != 0) continue;
+    if (!best || entries[i].pathLen < best->pathLen) best = &entries[i];
+  }
+  return best ? String(path(*best)) : String("");
+}
+
+size_t FileIndex::complete(const String& prefix, String* out, size_t max) {
+  size_t n = 0;
+  for (size_t i = lowerBound(prefix.c_str(), prefix.length()); i < entries.size() && n < max; i++) {
+    if (strncasecmp(base(entries[i]), prefix.c_str(), prefix.length()) != 0) break;
+    out[n++] = path(entries[i]);
+  }
+  return n;
+}
+
+#endif
@@ -0,0 +1,94 @@
+#pragma once
+#include <Arduino.h>
+#include <vector>
+
+// ===================== FILE NAME INDEX =====================
+// Every file on the card, sorted by file name (case-insensitive), so HOME's
+// quick-open commands are a binary search instead of a directory listing.
+//
+// The index is kept in RAM and mirrored to /sys/files.idx. On boot the saved
+// copy is usable immediately; a background walk of the card then runs in
+// short slices from the main loop (paused while keys are being pressed) and
+// reconciles it: new files are added, files that were not seen are dropped.
+// Writers keep it current in between with fileAdded()/fileRemoved().
+
+#define FILE_INDEX_PATH     "/sys/files.idx"
+#define FILE_INDEX_TMP      "/sys/files.tmp"
+#define FILE_INDEX_SLICE_MS 6      // walk budget per loop iteration
+#define FILE_INDEX_IDLE_MS  750    // no walking for this long after a key press
+#define FILE_INDEX_SAVE_MS  3000   // write back after edits have settled
+
+class FileIndex {
+public:
+  // Call from the main loop: loads, walks and saves as needed
+  void poll();
+  // Walk the whole card again (after USB mass storage, for example)
+  void rebuild();
+
+  void fileAdded(const String& path);
+  void fileRemoved(const String& path);
+
+  // A saved copy was loaded or a walk has completed
+  bool ready() const { return loaded && (walkDone || haveSaved); }
+  bool walking() const { return !walkDone; }
+  size_t size() const { return entries.size(); }
+  String pathAt(size_t idx) const { return idx < entries.size() ? String(path(entries[idx])) : String(""); }
+  // Completed walks since boot; lets other indexes notice a fresh listing
+  uint32_t walks() const { return walkCount; }
+
+  // Full path of the file called name or name.txt (case-insensitive), "" if none.
+  // With several candidates the shortest path wins.
+  String find(const String& name);
+  // Up to max paths whose file name starts with prefix, in name order
+  size_t complete(const String& prefix, String* out, size_t max);
+
+private:
+  struct Entry {
+    uint32_t pathOff;   // into arena, NUL-terminated
+    uint16_t pathLen;
+    uint16_t baseOff;   // start of the file name within the path
+    uint8_t  gen;       // walk generation that last saw this file
+    uint8_t  pad[3];
+  };
+
+  std::vector<Entry> entries;   // sorted by file name
+  std::vector<Entry> pending;   // found by the current walk, not yet merged
+  std::vector<char>  arena;
+  uint32_t garbage = 0;         // arena bytes of removed entries
+
+  bool loaded = false;
+  bool haveSaved = false;
+  bool walkDone = false;
+  bool dirty = false;
+  uint8_t gen = 0;
+  uint32_t walkCount = 0;
+  unsigned long lastEdit = 0;
+
+  std::vector<String> dirStack;
+  File   walkDir;
+  String walkPath;
+
+  const char* base(const Entry& e) const { return arena.data() + e.pathOff + e.baseOff; }
+  const char* path(const Entry& e) const { return arena.data() + e.pathOff; }
+
+  Entry makeEntry(const char* path);
+  size_t lowerBound(const char* name, size_t len) const;
+  int  indexOf(const char* path) const;
+  void insertSorted(const Entry& e);
+  void sortEntries();
+  bool excluded(const String& dir) const;
+  void walkSlice();
+  void finishWalk();
+  bool load();
+  void save();
+};
+
+FileIndex& FILEINDEX();
+
+// Writers call these after creating, saving or deleting a file so the
+// directory cache, the name index and the full-text index all see it
+void fileWritten(const String& path);
+void fileDeleted(const String& path);
+
+// True when the keyboard has been quiet for at least ms (sampled from KB_IRQ)
+bool keyboardIdleFor(uint32_t ms);
@@ -0,0 +1,262 @@
+#include <globals.h>
+#include "esp_heap_caps.h"
+#include "glyph_cache.h"
+
+static constexpr const char* TAG = "GLYPHS";
+
+// Expanded glyph rows are bump-allocated from per-font chunks of this size
+static constexpr size_t GLYPH_ARENA_CHUNK = 2048;
+
+GlyphCache& GLYPHS() {
+  static GlyphCache instance;
+  return instance;
+}
+
+// Prefer PSRAM so the cache never competes with the app heap
+static void* glyphAlloc(size_t size) {
+  void* p = nullptr;
+  if (psramFound()) p = heap_caps_malloc(size, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+  if (!p) p = malloc(size);
+  return p;
+}
+
+// ===================== ARENA =====================
+// Chunks are chained through their first pointer-sized bytes so a font slot
+// can be released without any bookkeeping beyond the head pointer.
+
+struct GlyphArena {
+  uint8_t* head = nullptr;   // newest chunk
+  size_t   used = 0;         // bytes used in newest chunk
+};
+
+static GlyphArena arenas[GLYPH_CACHE_MAX_FONTS];
+
+static uint8_t* arenaAlloc(GlyphArena& a, size_t size) {
+  const size_t hdr = sizeof(uint8_t*);
+  if (size > GLYPH_ARENA_CHUNK - hdr) return nullptr;
+  if (!a.head || a.used + size > GLYPH_ARENA_CHUNK) {
+    uint8_t* chunk = (uint8_t*)glyphAlloc(GLYPH_ARENA_CHUNK);
+    if (!chunk) return nullptr;
+    *(uint8_t**)chunk = a.head;
+    a.head = chunk;
+    a.used = hdr;
+  }
+  uint8_t* p = a.head + a.used;
+  a.used += size;
+  return p;
+}
+
+static void arenaFree(GlyphArena& a) {
+  while (a.head) {
+    uint8_t* next = *(uint8_t**)a.head;
+    free(a.head);
+    a.head = next;
+  }
+  a.used = 0;
+}
+
+// ===================== FONT SLOTS =====================
+
+GlyphCache::FontSlot* GlyphCache::slotFor(const GFXfont* font) {
+  FontSlot* empty = nullptr;
+  for (int i = 0; i < GLYPH_CACHE_MAX_FONTS; i++) {
+    if (slots[i].font == font) return &slots[i];
+    if (!slots[i].font && !empty) empty = &slots[i];
+  }
+
+  if (!empty) {
+    empty = &slots[nextEvict];
+    nextEvict = (nextEvict + 1) % GLYPH_CACHE_MAX_FONTS;
+    releaseSlot(*empty);
+  }
+
+  uint16_t first = pgm_read_word(&font->first);
+  uint16_t last  = pgm_read_word(&font->last);
+  uint16_t count = last - first + 1;
+  CachedGlyph* glyphs = (CachedGlyph*)calloc(count, sizeof(CachedGlyph));
+  if (!glyphs) {
+    ESP_LOGE(TAG, "No memory for %u glyph entries", count);
+    return nullptr;
+  }
+
+  // Metrics are cheap to copy up front; bitmaps are expanded on first draw
+  const GFXglyph* src = font->glyph;
+  for (uint16_t i = 0; i < count; i++) {
+    glyphs[i].width    = pgm_read_byte(&src[i].width);
+    glyphs[i].height   = pgm_read_byte(&src[i].height);
+    glyphs[i].xAdvance = pgm_read_byte(&src[i].xAdvance);
+    glyphs[i].xOffset  = (int8_t)pgm_read_byte(&src[i].xOffset);
+    glyphs[i].yOffset  = (int8_t)pgm_read_byte(&src[i].yOffset);
+  }
+
+  empty->font = font;
+  empty->first = first;
+  empty->last = last;
+  empty->yAdvance = pgm_read_byte(&font->yAdvance);
+  empty->glyphs = glyphs;
+  return empty;
+}
+
+void GlyphCache::releaseSlot(FontSlot& slot) {
+  if (&slot == curSlot) curSlot = nullptr;
+  arenaFree(arenas[&slot - slots]);
+  free(slot.glyphs);
+  slot = FontSlot{};
+}
+
+void GlyphCache::clear() {
+  for (int i = 0; i < GLYPH_CACHE_MAX_FONTS; i++) releaseSlot(slots[i]);
+  nextEvict = 0;
+  if (curFont) curSlot = slotFor(curFont);
+}
+
+void GlyphCache::setFont(const GFXfont* font) {
+  display.setFont(font);
+  curFont = font;
+  curSlot = font ? slotFor(font) : nullptr;
+}
+
+// ===================== GLYPH EXPANSION =====================
+
+const GlyphCache::CachedGlyph* GlyphCache::glyphFor(FontSlot& slot, uint8_t c, bool needRows) {
+  if (c < slot.first || c > slot.last) return nullptr;
+  CachedGlyph& g = slot.glyphs[c - slot.first];
+  if (!needRows || g.rows || g.width == 0 || g.height == 0) return &g;
+
+  const uint8_t stride = (g.width + 7) >> 3;
+  uint8_t* rows = arenaAlloc(arenas[&slot - slots], stride * g.height);
+  if (!rows) return &g; // blitGlyph() falls back to the display for this one
+  memset(rows, 0, stride * g.height);
+
+  // GFXfont bitmaps are one continuous bit stream; re-pack it per row
+  const uint8_t* bitmap = slot.font->bitmap;
+  uint16_t offset = pgm_read_word(&slot.font->glyph[c - slot.first].bitmapOffset);
+  uint8_t bits = 0, bit = 0;
+  for (uint8_t yy = 0; yy < g.height; yy++) {
+    uint8_t* row = rows + yy * stride;
+    for (uint8_t xx = 0; xx < g.width; xx++) {
+      if (!(bit++ & 7)) bits = pgm_read_byte(&bitmap[offset++]);
+      if (bits & 0x80) row[xx >> 3] |= (0x80 >> (xx & 7));
+      bits <<= 1;
+    }
+  }
+  g.rows = rows;
+  return &g;
+}
+
+// Emit each row as horizontal runs: empty bytes are skipped whole, full bytes
+// extend the current run without testing bits.
+void GlyphCache::blitGlyph(const CachedGlyph& g, int16_t x, int16_t y) {
+  const uint8_t stride = (g.width + 7) >> 3;
+  for (uint8_t yy = 0; yy < g.height; yy++) {
+    const uint8_t* row = g.rows + yy * stride;
+    int16_t runStart = -1;
+    for (uint8_t bx = 0; bx < stride; bx++) {
+      uint8_t b = row[bx];
+      int16_t px = bx << 3;
+      if (b == 0x00) {
+        if (runStart >= 0) {
+          display.drawFastHLine(x + runStart, y + yy, px - runStart, textColor);
+          runStart = -1;
+        }
+        continue;
+      }
+      if (b == 0xFF) {
+        if (runStart < 0) runStart = px;
+        continue;
+      }
+      for (uint8_t k = 0; k < 8; k++, b <<= 1) {
+        if (b & 0x80) {
+          if (runStart < 0) runStart = px + k;
+        } else if (runStart >= 0) {
+          display.drawFastHLine(x + runStart, y + yy, px + k - runStart, textColor);
+          runStart = -1;
+        }
+      }
+    }
+    if (runStart >= 0) {
+      display.drawFastHLine(x + runStart, y + yy, g.width - runStart, textColor);
+    }
+  }
+}
+
+// ===================== TEXT =====================
+
+void GlyphCache::print(const char* text) {
+  if (!curSlot) {
+    display.print(text);
+    return;
+  }
+
+  int16_t cx = display.getCursorX();
+  int16_t cy = display.getCursorY();
+  const int16_t screenW = display.width();
+
+  for (const uint8_t* p = (const uint8_t*)text; *p; p++) {
+    uint8_t c = *p;
+    if (c == '\n') { cx = 0; cy += curSlot->yAdvance; continue; }
+    if (c == '\r') continue;
+
+    const CachedGlyph* g = glyphFor(*curSlot, c, true);
+    if (!g) continue;
+    if (g->width > 0 && g->height > 0) {
+      // Same wrap rule as Adafruit_GFX::write()
+      if (cx + g->xOffset + g->width > screenW) { cx = 0; cy += curSlot->yAdvance; }
+      if (g->rows) {
+        blitGlyph(*g, cx + g->xOffset, cy + g->yOffset);
+      } else {
+        display.drawChar(cx, cy, c, textColor, textColor, 1);
+      }
+    }
+    cx += g->xAdvance;
+  }
+  display.setCursor(cx, cy);
+}
+
+void GlyphCache::print(int value) {
+  char buf[12];
+  snprintf(buf, sizeof(buf), "%d", value);
+  print(buf);
+}
+
+int16_t GlyphCache::advanceWidth(const char* text) {
+  if (!curSlot) return 6 * strlen(text);
+  int16_t w = 0;
+  for (const uint8_t* p = (const uint8_t*)text; *p; p++) {
+    const CachedGlyph* g = glyphFor(*curSlot, *p, false);
+    if (g) w += g->xAdvance;
+  }
+  return w;
+}
+
+void GlyphCache::getTextBounds(const char* text, int16_t x, int16_t y,
+                               int16_t* x1, int16_t* y1, uint16_t* w, uint16_t* h) {
+  if (!curSlot) {
+    display.getTextBounds(text, x, y, x1, y1, w, h);
+    return;
+  }
+
+  const int16_t screenW = display.width();
+  int16_t minx = 0x7FFF, miny = 0x7FFF, maxx = -1, maxy = -1;
+
+  for (const uint8_t* p = (const uint8_t*)text; *p; p++) {
+    uint8_t c = *p;
+    if (c == '\n') { x = 0; y += curSlot->yAdvance; continue; }
+    if (c == '\r') continue;
+
+    const CachedGlyph* g = glyphFor(*curSlot, c, false);
+    if (!g) continue;
+    if (x + g->xOffset + g->width > screenW) { x = 0; y += curSlot->yAdvance; }
+    int16_t gx1 = x + g->xOffset, gy1 = y + g->yOffset;
+    int16_t gx2 = gx1 + g->width - 1, gy2 = gy1 + g->height - 1;
+    if (gx1 < minx) minx = gx1;
+    if (gy1 < miny) miny = gy1;
+    if (gx2 > maxx) maxx = gx2;
+    if (gy2 > maxy) maxy = gy2;
+    x += g->xAdvance;
+  }
+
+  *x1 = x; *y1 = y; *w = 0; *h = 0;
+  if (maxx >= minx) { *x1 = minx; *w = maxx - minx + 1; }
+  if (maxy >= miny) { *y1 = miny; *h = maxy - miny + 1; }
+}
@@ -0,0 +1,66 @@
+#pragma once
+#include <Arduino.h>
+#include <Adafruit_GFX.h>
+
+// ===================== GLYPH RUN CACHE =====================
+// Adafruit_GFX decodes every GFXfont glyph bit by bit on each print. This cache
+// expands each (font, char) pair once into byte-aligned rows (PSRAM when
+// available) and keeps an advance/metrics table per font, so text is blitted as
+// horizontal runs and measuring a string never touches the glyph bitmaps.
+//
+// Usage mirrors the display calls it replaces:
+//   GLYPHS().setFont(&FreeMono9pt8b);   // instead of display.setFont()
+//   GLYPHS().print("Gold: 42");         // instead of display.print()
+//   GLYPHS().getTextBounds(...)         // instead of display.getTextBounds()
+// A NULL font falls back to the built-in 6x8 font through the display itself.
+
+#define GLYPH_CACHE_MAX_FONTS 8
+
+class GlyphCache {
+public:
+  void setFont(const GFXfont* font);
+  const GFXfont* getFont() const { return curFont; }
+  void setTextColor(uint16_t color) { textColor = color; }
+
+  // Draw at the display cursor and advance it, like display.print()
+  void print(const char* text);
+  void print(const String& text) { print(text.c_str()); }
+  void print(int value);
+
+  // Same results as display.getTextBounds() for single-line text
+  void getTextBounds(const char* text, int16_t x, int16_t y,
+                     int16_t* x1, int16_t* y1, uint16_t* w, uint16_t* h);
+  // Sum of xAdvance over the string (pen movement in pixels)
+  int16_t advanceWidth(const char* text);
+
+  // Drop every expanded glyph (e.g. before a heap-hungry app starts)
+  void clear();
+
+private:
+  struct CachedGlyph {
+    uint8_t* rows;      // byte-aligned bitmap, nullptr until first draw
+    uint8_t  width, height;
+    uint8_t  xAdvance;
+    int8_t   xOffset, yOffset;
+  };
+
+  struct FontSlot {
+    const GFXfont* font;
+    uint16_t       first, last;
+    uint8_t        yAdvance;
+    CachedGlyph*   glyphs;
+  };
+
+  FontSlot  slots[GLYPH_CACHE_MAX_FONTS] = {};
+  FontSlot* curSlot = nullptr;
+  const GFXfont* curFont = nullptr;
+  uint16_t  textColor = 0x0000; // GxEPD_BLACK
+  uint8_t   nextEvict = 0;
+
+  FontSlot* slotFor(const GFXfont* font);
+  void      releaseSlot(FontSlot& slot);
+  const CachedGlyph* glyphFor(FontSlot& slot, uint8_t c, bool needRows);
+  void      blitGlyph(const CachedGlyph& g, int16_t x, int16_t y);
+};
+
+GlyphCache& GLYPHS();
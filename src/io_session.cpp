@@ -0,0 +1,121 @@
+#include <globals.h>
+#include "io_session.h"
+
+static constexpr const char* TAG = "IOSESSION";
+
+IoSessionManager& IOSESSION() {
+  static IoSessionManager instance;
+  return instance;
+}
+
+// Sessions open from both the keyboard and the e-ink task; the clock
+// decision and the fields behind it change under this lock
+static SemaphoreHandle_t sessionLock() {
+  static SemaphoreHandle_t lock = xSemaphoreCreateMutex();
+  return lock;
+}
+
+// ===================== FREQUENCY STATS =====================
+
+// Charge the time since the last sample to the frequency that was running.
+// The clock is read back from the hardware so changes made elsewhere (sleep,
+// USB, other apps) are attributed correctly too.
+void IoSessionManager::account() {
+  unsigned long now = millis();
+  uint32_t mhz = getCpuFrequencyMhz();
+  if (curMhz != 0) {
+    FreqSlot* slot = nullptr;
+    for (int i = 0; i < IO_FREQ_SLOTS; i++) {
+      if (freqs[i].mhz == curMhz || freqs[i].mhz == 0) {
+        slot = &freqs[i];
+        break;
+      }
+    }
+    if (slot) {
+      slot->mhz = curMhz;
+      slot->ms += now - curSince;
+    }
+  }
+  curMhz = mhz;
+  curSince = now;
+}
+
+uint32_t IoSessionManager::msAtMhz(uint32_t mhz) {
+  xSemaphoreTake(sessionLock(), portMAX_DELAY);
+  account();
+  uint32_t ms = 0;
+  for (int i = 0; i < IO_FREQ_SLOTS; i++) {
+    if (freqs[i].mhz == mhz) ms = freqs[i].ms;
+  }
+  xSemaphoreGive(sessionLock());
+  return ms;
+}
+
+void IoSessionManager::logStats() {
+  xSemaphoreTake(sessionLock(), portMAX_DELAY);
+  account();
+  for (int i = 0; i < IO_FREQ_SLOTS && freqs[i].mhz; i++) {
+    ESP_LOGI(TAG, "%u MHz: %lu ms", (unsigned)freqs[i].mhz, (unsigned long)freqs[i].ms);
+  }
+  ESP_LOGI(TAG, "%lu sessions, %lu clock raises", (unsigned long)sessions, (unsigned long)raises);
+  xSemaphoreGive(sessionLock());
+}
+
+// ===================== SESSIONS =====================
+
+// The switch is done once the core reports the new frequency and the APB bus
+// (which clocks SDMMC) is back at 80 MHz; usually well under a millisecond.
+bool IoSessionManager::waitReady(uint32_t mhz) {
+  unsigned long start = millis();
+  while (getCpuFrequencyMhz() != mhz || getApbFrequency() != 80000000) {
+    if (millis() - start >= IO_READY_TIMEOUT_MS) {
+      ESP_LOGW(TAG, "Clock not settled at %u MHz after %d ms", (unsigned)mhz, IO_READY_TIMEOUT_MS);
+      return false;
+    }
+    delay(1);
+  }
+  return true;
+}
+
+void IoSessionManager::begin() {
+  xSemaphoreTake(sessionLock(), portMAX_DELAY);
+  sessions++;
+  if (openCount.fetch_add(1) == 0) SDActive = true;
+
+  if (getCpuFrequencyMhz() < IO_FAST_MHZ) {
+    account();
+    pocketmage::setCpuSpeed(IO_FAST_MHZ);
+    waitReady(IO_FAST_MHZ);
+    account();
+    raises++;
+  }
+  holding = true;
+  xSemaphoreGive(sessionLock());
+}
+
+void IoSessionManager::end() {
+  xSemaphoreTake(sessionLock(), portMAX_DELAY);
+  if (openCount.load() == 0) {
+    ESP_LOGW(TAG, "end() without begin()");
+  } else if (openCount.fetch_sub(1) == 1) {
+    SDActive = false;
+    lastEnd = millis();
+  }
+  xSemaphoreGive(sessionLock());
+}
+
+void IoSessionManager::poll() {
+  // USB mass storage runs the card at full speed until the host is done
+  if (mscEnabled) return;
+
+  xSemaphoreTake(sessionLock(), portMAX_DELAY);
+  if (holding && openCount == 0 && millis() - lastEnd >= IO_IDLE_HOLD_MS) {
+    holding = false;
+    if (SAVE_POWER && getCpuFrequencyMhz() != POWER_SAVE_FREQ) {
+      account();
+      pocketmage::setCpuSpeed(POWER_SAVE_FREQ);
+      account();
+    }
+  }
+  xSemaphoreGive(sessionLock());
+}
@@ -0,0 +1,67 @@
+#pragma once
+#include <Arduino.h>
+#include <atomic>
+
+// ===================== I/O SESSIONS =====================
+// SD access needs the CPU at full speed. Instead of raising the clock, sleeping
+// 50 ms and dropping it again around every file operation, callers open a
+// reference-counted session:
+//
+//   IOSESSION().begin();   // or: IoSession io;  (RAII)
+//   ... SD_MMC calls ...
+//   IOSESSION().end();
+//
+// The first begin() raises the clock and waits only until the new frequency
+// has actually taken effect. Nested and back-to-back sessions reuse it; the
+// clock drops back to POWER_SAVE_FREQ from poll() once no session has been
+// open for IO_IDLE_HOLD_MS. SDActive is held for as long as a session is open.
+
+#define IO_FAST_MHZ        240
+#define IO_IDLE_HOLD_MS    250   // keep the clock up this long after the last end()
+#define IO_READY_TIMEOUT_MS 50   // upper bound on the readiness wait (old fixed delay)
+#define IO_FREQ_SLOTS      4     // distinct frequencies tracked in the stats
+
+class IoSessionManager {
+public:
+  void begin();
+  void end();
+  // Call from the main loop; lowers the clock after the idle hold
+  void poll();
+
+  uint8_t depth() const { return openCount; }
+
+  // Time spent at a CPU frequency since boot (ms), 0 if never seen
+  uint32_t msAtMhz(uint32_t mhz);
+  uint32_t sessionCount() const { return sessions; }
+  uint32_t clockRaises() const { return raises; }
+  void logStats();
+
+private:
+  struct FreqSlot {
+    uint32_t mhz;
+    uint32_t ms;
+  };
+
+  FreqSlot freqs[IO_FREQ_SLOTS] = {};
+  uint32_t curMhz = 0;
+  unsigned long curSince = 0;
+  unsigned long lastEnd = 0;
+  uint32_t sessions = 0;
+  uint32_t raises = 0;
+  std::atomic<uint8_t> openCount{0}; // sessions are opened from the e-ink task too
+  bool     holding = false;   // clock raised by us and not yet lowered
+
+  void account();
+  bool waitReady(uint32_t mhz);
+};
+
+IoSessionManager& IOSESSION();
+
+// Scoped session: begin() on construction, end() when it goes out of scope
+class IoSession {
+public:
+  IoSession() { IOSESSION().begin(); }
+  ~IoSession() { IOSESSION().end(); }
+  IoSession(const IoSession&) = delete;
+  IoSession& operator=(const IoSession&) = delete;
+};
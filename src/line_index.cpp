@@ -0,0 +1,61 @@
+#include <globals.h>
+#include "line_index.h"
+#if !OTA_APP // POCKETMAGE_OS
+
+void LineIndex::reset(size_t paragraphs) {
+  counts.assign(paragraphs, 0);
+  tree.assign(paragraphs + 1, 0);
+  sum = 0;
+  topBit = 1;
+  while (topBit * 2 <= paragraphs) topBit *= 2;
+}
+
+void LineIndex::build() {
+  size_t n = counts.size();
+  sum = 0;
+  for (size_t i = 1; i <= n; i++) {
+    tree[i] = counts[i - 1];
+    sum += counts[i - 1];
+  }
+  // Push each node into its parent once
+  for (size_t i = 1; i <= n; i++) {
+    size_t parent = i + (i & -i);
+    if (parent <= n) tree[parent] += tree[i];
+  }
+}
+
+void LineIndex::set(size_t paragraph, uint32_t lines) {
+  if (paragraph >= counts.size()) return;
+  int32_t delta = (int32_t)lines - (int32_t)counts[paragraph];
+  if (delta == 0) return;
+  counts[paragraph] = lines;
+  sum += delta;
+  for (size_t i = paragraph + 1; i < tree.size(); i += i & -i) tree[i] += delta;
+}
+
+uint32_t LineIndex::start(size_t paragraph) const {
+  uint32_t total = 0;
+  for (size_t i = min(paragraph, counts.size()); i > 0; i -= i & -i) total += tree[i];
+  return total;
+}
+
+bool LineIndex::find(uint32_t line, size_t& paragraph, uint32_t& sub) const {
+  if (line >= sum) return false;
+
+  // Descend to the last position whose prefix sum is <= line; the paragraph
+  // after it is the first one that reaches past line
+  size_t pos = 0;
+  uint32_t before = 0;
+  for (size_t step = topBit; step > 0; step >>= 1) {
+    size_t next = pos + step;
+    if (next < tree.size() && before + tree[next] <= line) {
+      pos = next;
+      before += tree[next];
+    }
+  }
+  paragraph = pos;
+  sub = line - before;
+  return true;
+}
+
+#endif
@@ -0,0 +1,40 @@
+#pragma once
+#include <Arduino.h>
+#include <vector>
+
+// ===================== DISPLAY LINE INDEX =====================
+// Fenwick tree over the number of wrapped display lines in each paragraph of
+// the TXT editor. Maps a scroll position to (paragraph, line within it) and a
+// paragraph to its first display line in O(log n), so scrolling and drawing
+// do not walk the document from the top.
+//
+// Inserting or removing paragraphs needs a rebuild (O(n)); a paragraph that
+// gains or loses wrapped lines is a point update.
+
+class LineIndex {
+public:
+  // Rebuild: reset(), count() every paragraph, then build()
+  void reset(size_t paragraphs);
+  void count(size_t paragraph, uint32_t lines) { counts[paragraph] = lines; }
+  void build();
+
+  // Paragraph now has lines display lines
+  void set(size_t paragraph, uint32_t lines);
+
+  size_t   paragraphs() const { return counts.size(); }
+  uint32_t lines(size_t paragraph) const { return counts[paragraph]; }
+  uint32_t total() const { return sum; }
+
+  // First display line of paragraph
+  uint32_t start(size_t paragraph) const;
+
+  // Paragraph holding display line line, and its line within that paragraph.
+  // Paragraphs without lines (blank) are never returned. False past the end.
+  bool find(uint32_t line, size_t& paragraph, uint32_t& sub) const;
+
+private:
+  std::vector<uint32_t> counts;
+  std::vector<uint32_t> tree;   // 1-based Fenwick tree
+  uint32_t sum = 0;
+  size_t   topBit = 0;          // highest power of two <= paragraphs
+};
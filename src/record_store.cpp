@@ -0,0 +1,361 @@
+#include <globals.h>
+#include "esp_rom_crc.h"
+#include "io_session.h"
+#include "record_store.h"
+#if !OTA_APP // POCKETMAGE_OS
+
+static constexpr const char* TAG = "RECORDS";
+
+// Version 1 files (tasks.bin before the shared store) journal bare entries
+// without commit blocks; they are still read and upgraded on the next compact.
+static constexpr uint16_t RECORD_FORMAT_V1 = 1;
+static constexpr uint16_t RECORD_FORMAT    = 2;
+static constexpr uint16_t COMMIT_TAG       = 0xB10C;
+
+enum RecordOp : uint8_t { RECORD_OP_PUT = 1, RECORD_OP_DEL = 2 };
+
+struct RecordFileHeader {
+  uint32_t magic;
+  uint16_t version;
+  uint16_t recordSize;
+  uint32_t count;            // snapshot records following the header
+};
+
+// A commit block is this header followed by `entries` journal entries of
+// (4 + recordSize) bytes each: { op, pad[3], record }.
+struct CommitHeader {
+  uint16_t tag;
+  uint16_t entries;
+  uint32_t crc;              // over the entry bytes
+};
+
+static constexpr size_t ENTRY_HDR = 4;
+
+static RecordTable* tables[RECORD_MAX_TABLES];
+static uint8_t tableCount = 0;
+
+static void storeBegin() {
+  IOSESSION().begin();
+}
+
+static void storeEnd() {
+  IOSESSION().end();
+}
+
+RecordTable::RecordTable(const RecordSchema& schema) : schema(schema) {
+  if (tableCount < RECORD_MAX_TABLES) tables[tableCount++] = this;
+  else ESP_LOGE(TAG, "Too many tables, %s will not auto-flush", schema.path);
+}
+
+void flushRecordStores(bool force) {
+  unsigned long now = millis();
+  for (uint8_t i = 0; i < tableCount; i++) {
+    RecordTable* t = tables[i];
+    if (!t->dirty()) continue;
+    if (force || now - t->lastEditMillis() >= RECORD_FLUSH_IDLE_MS) t->flush();
+  }
+}
+
+// ===================== INDEX =====================
+
+bool RecordTable::ordered(uint16_t a, uint16_t b) const {
+  const uint8_t* ra = slotPtr(a);
+  const uint8_t* rb = slotPtr(b);
+  if (schema.before) {
+    if (schema.before(ra, rb)) return true;
+    if (schema.before(rb, ra)) return false;
+  }
+  return idOf(ra) < idOf(rb);
+}
+
+void RecordTable::indexInsert(uint16_t slot) {
+  auto pos = std::lower_bound(order.begin(), order.end(), slot,
+                              [&](uint16_t s, uint16_t v) { return ordered(s, v); });
+  order.insert(pos, slot);
+}
+
+void RecordTable::indexErase(uint16_t slot) {
+  auto pos = std::lower_bound(order.begin(), order.end(), slot,
+                              [&](uint16_t s, uint16_t v) { return ordered(s, v); });
+  if (pos != order.end() && *pos == slot) order.erase(pos);
+}
+
+int RecordTable::findSlot(uint16_t id) const {
+  for (size_t i = 0; i < slotCount(); i++) {
+    if (idOf(slotPtr(i)) == id) return i;
+  }
+  return -1;
+}
+
+const void* RecordTable::find(uint16_t id) const {
+  if (id == 0) return nullptr;
+  int slot = findSlot(id);
+  return slot < 0 ? nullptr : slotPtr(slot);
+}
+
+void RecordTable::applyPut(const void* rec) {
+  uint16_t id = idOf(rec);
+  int slot = findSlot(id);
+  if (slot >= 0) {
+    indexErase(slot);
+  } else {
+    slot = findSlot(0);
+    if (slot < 0) {
+      slot = slotCount();
+      slots.resize(slots.size() + schema.recordSize);
+    }
+  }
+  memcpy(slotPtr(slot), rec, schema.recordSize);
+  indexInsert(slot);
+  if (id >= nextId) nextId = id + 1;
+  rev++;
+}
+
+void RecordTable::applyDel(uint16_t id) {
+  int slot = findSlot(id);
+  if (slot < 0) return;
+  indexErase(slot);
+  memset(slotPtr(slot), 0, schema.recordSize);
+  rev++;
+}
+
+// ===================== WRITE-BACK =====================
+
+// Later edits to the same id replace the queued entry, so a record that is
+// edited many times between flushes costs one entry on SD.
+void RecordTable::queue(uint8_t op, uint16_t id, const void* rec) {
+  const size_t entrySize = ENTRY_HDR + schema.recordSize;
+  uint8_t* entry = nullptr;
+  for (size_t off = 0; off < pending.size(); off += entrySize) {
+    if (idOf(&pending[off + ENTRY_HDR]) == id) {
+      entry = &pending[off];
+      break;
+    }
+  }
+  if (!entry) {
+    pending.resize(pending.size() + entrySize);
+    entry = &pending[pending.size() - entrySize];
+    pendingCount++;
+  }
+  memset(entry, 0, entrySize);
+  entry[0] = op;
+  if (rec) memcpy(entry + ENTRY_HDR, rec, schema.recordSize);
+  else memcpy(entry + ENTRY_HDR, &id, sizeof(id));
+  lastEdit = millis();
+}
+
+uint16_t RecordTable::add(const void* rec) {
+  load();
+  std::vector<uint8_t> r((const uint8_t*)rec, (const uint8_t*)rec + schema.recordSize);
+  uint16_t id = nextId;
+  memcpy(r.data(), &id, sizeof(id));
+  applyPut(r.data());
+  queue(RECORD_OP_PUT, id, r.data());
+  return id;
+}
+
+bool RecordTable::update(const void* rec) {
+  load();
+  uint16_t id = idOf(rec);
+  if (id == 0) return false;
+  int slot = findSlot(id);
+  if (slot < 0) return false;
+  if (memcmp(slotPtr(slot), rec, schema.recordSize) == 0) return true;
+  applyPut(rec);
+  queue(RECORD_OP_PUT, id, rec);
+  return true;
+}
+
+bool RecordTable::remove(uint16_t id) {
+  load();
+  if (id == 0 || findSlot(id) < 0) return false;
+  applyDel(id);
+  queue(RECORD_OP_DEL, id, nullptr);
+  return true;
+}
+
+// ===================== SD =====================
+
+bool RecordTable::load() {
+  if (loaded) return true;
+  loaded = true;
+
+  storeBegin();
+
+  // A crash between remove and rename in compact() leaves only the temp file
+  if (!SD_MMC.exists(schema.path) && SD_MMC.exists(schema.tmpPath)) {
+    SD_MMC.rename(schema.tmpPath, schema.path);
+  }
+
+  File file = SD_MMC.open(schema.path, FILE_READ);
+  if (!file) {
+    storeEnd();
+    return importLegacy();
+  }
+
+  RecordFileHeader hdr;
+  if (file.read((uint8_t*)&hdr, sizeof(hdr)) != sizeof(hdr) || hdr.magic != schema.magic ||
+      hdr.recordSize != schema.recordSize ||
+      (hdr.version != RECORD_FORMAT && hdr.version != RECORD_FORMAT_V1)) {
+    // Keep the unreadable file for inspection and start a fresh table
+    ESP_LOGE(TAG, "Bad header in %s", schema.path);
+    file.close();
+    String bad = String(schema.path) + ".bad";
+    SD_MMC.remove(bad);
+    SD_MMC.rename(schema.path, bad);
+    storeEnd();
+    return false;
+  }
+
+  slots.reserve(hdr.count * schema.recordSize);
+  std::vector<uint8_t> rec(schema.recordSize);
+  for (uint32_t i = 0; i < hdr.count; i++) {
+    if (file.read(rec.data(), schema.recordSize) != schema.recordSize) break;
+    if (idOf(rec.data()) != 0) applyPut(rec.data());
+  }
+
+  bool clean = replay(file, hdr.version);
+  file.close();
+  storeEnd();
+
+  ESP_LOGI(TAG, "Loaded %u records from %s (%u journal entries)",
+           (unsigned)order.size(), schema.path, journalEntries);
+
+  // Anything after a torn block would never be replayed, so rewrite the file
+  // before new blocks are appended behind it. Old formats are upgraded here too.
+  if (!clean || hdr.version != RECORD_FORMAT) return compact();
+  return true;
+}
+
+// Returns false when the journal ends in a torn or corrupt block
+bool RecordTable::replay(File& file, uint16_t version) {
+  const size_t entrySize = ENTRY_HDR + schema.recordSize;
+  std::vector<uint8_t> buf;
+
+  auto applyEntries = [&](const uint8_t* p, size_t n) {
+    for (size_t i = 0; i < n; i++, p += entrySize) {
+      if (p[0] == RECORD_OP_PUT)      applyPut(p + ENTRY_HDR);
+      else if (p[0] == RECORD_OP_DEL) applyDel(idOf(p + ENTRY_HDR));
+    }
+    journalEntries += n;
+  };
+
+  if (version == RECORD_FORMAT_V1) {
+    buf.resize(entrySize);
+    while (file.read(buf.data(), entrySize) == entrySize) applyEntries(buf.data(), 1);
+    return file.available() == 0;
+  }
+
+  CommitHeader ch;
+  while (file.read((uint8_t*)&ch, sizeof(ch)) == sizeof(ch)) {
+    if (ch.tag != COMMIT_TAG) return false;
+    size_t len = (size_t)ch.entries * entrySize;
+    buf.resize(len);
+    if (file.read(buf.data(), len) != len) return false;
+    if (esp_rom_crc32_le(0, buf.data(), len) != ch.crc) return false;
+    applyEntries(buf.data(), ch.entries);
+  }
+  return file.available() == 0;
+}
+
+bool RecordTable::importLegacy() {
+  if (!schema.legacyPath || !schema.importLine) return true;
+
+  storeBegin();
+  File file = SD_MMC.open(schema.legacyPath, FILE_READ);
+  if (!file) {
+    storeEnd();
+    return true; // Nothing stored yet
+  }
+  while (file.available()) {
+    String line = file.readStringUntil('\n');
+    line.trim();
+    if (line.length() > 0) schema.importLine(*this, line);
+  }
+  file.close();
+  storeEnd();
+
+  ESP_LOGI(TAG, "Imported %u records from %s", (unsigned)order.size(), schema.legacyPath);
+  if (!compact()) return false;
+
+  String bak = String(schema.legacyPath) + ".bak";
+  storeBegin();
+  SD_MMC.remove(bak);
+  SD_MMC.rename(schema.legacyPath, bak);
+  storeEnd();
+  return true;
+}
+
+bool RecordTable::flush() {
+  if (!pendingCount) return true;
+
+  storeBegin();
+  if (!SD_MMC.exists(schema.path)) {
+    storeEnd();
+    return compact(); // The first write creates the snapshot, which holds every edit
+  }
+
+  // Header and entries go out in one write so the block lands as a unit
+  std::vector<uint8_t> block(sizeof(CommitHeader) + pending.size());
+  CommitHeader ch = { COMMIT_TAG, pendingCount, esp_rom_crc32_le(0, pending.data(), pending.size()) };
+  memcpy(block.data(), &ch, sizeof(ch));
+  memcpy(block.data() + sizeof(ch), pending.data(), pending.size());
+
+  File file = SD_MMC.open(schema.path, FILE_APPEND);
+  if (!file) {
+    ESP_LOGE(TAG, "Failed to open %s for append", schema.path);
+    storeEnd();
+    return false;
+  }
+  bool ok = file.write(block.data(), block.size()) == block.size();
+  file.close();
+  storeEnd();
+
+  if (!ok) {
+    ESP_LOGE(TAG, "Write to %s failed, edits kept in RAM", schema.path);
+    return false;
+  }
+
+  journalEntries += pendingCount;
+  pending.clear();
+  pendingCount = 0;
+
+  // Fold the journal back in once it is larger than the data it describes
+  if (journalEntries > order.size() + 16) compact();
+  return true;
+}
+
+bool RecordTable::compact() {
+  storeBegin();
+  File file = SD_MMC.open(schema.tmpPath, FILE_WRITE);
+  if (!file) {
+    ESP_LOGE(TAG, "Failed to open %s", schema.tmpPath);
+    storeEnd();
+    return false;
+  }
+
+  RecordFileHeader hdr = { schema.magic, RECORD_FORMAT, schema.recordSize, (uint32_t)order.size() };
+  bool ok = file.write((const uint8_t*)&hdr, sizeof(hdr)) == sizeof(hdr);
+  for (size_t i = 0; ok && i < order.size(); i++) {
+    ok = file.write(slotPtr(order[i]), schema.recordSize) == schema.recordSize;
+  }
+  file.close();
+
+  if (ok) {
+    SD_MMC.remove(schema.path);
+    ok = SD_MMC.rename(schema.tmpPath, schema.path);
+  }
+  storeEnd();
+
+  if (!ok) {
+    ESP_LOGE(TAG, "Compaction of %s failed", schema.path);
+    return false;
+  }
+  // The snapshot already contains every queued edit
+  journalEntries = 0;
+  pending.clear();
+  pendingCount = 0;
+  return true;
+}
+
+#endif
@@ -0,0 +1,105 @@
+#pragma once
+#include <Arduino.h>
+#include <FS.h>
+#include <vector>
+
+// ===================== RECORD STORE =====================
+// Small embedded table store for the OS data files in /sys. Every table holds
+// fixed-size records whose first field is a uint16_t id. On SD a table is:
+//
+//   [header][snapshot records...][commit block][commit block]...
+//
+// Edits only touch the in-RAM copy and queue a journal entry. Queued entries
+// are written as one CRC-checked commit block when the table has been idle for
+// RECORD_FLUSH_IDLE_MS, or immediately before sleep/reboot/USB. A torn block
+// from a power cut fails its CRC and is dropped on load, so a batch is either
+// applied completely or not at all. Once the journal outgrows the live data
+// the table is rewritten to a temp file and renamed over the original.
+
+#define RECORD_FLUSH_IDLE_MS 3000
+#define RECORD_MAX_TABLES    8
+
+class RecordTable;
+
+struct RecordSchema {
+  const char* path;          // e.g. "/sys/tasks.bin"
+  const char* tmpPath;       // compaction target, renamed over path
+  uint32_t    magic;
+  uint16_t    recordSize;
+  // Optional: keep at() in this order (ties broken by id)
+  bool (*before)(const void* a, const void* b);
+  // Optional: text file imported line by line when path does not exist yet;
+  // it is renamed to <legacyPath>.bak afterwards
+  const char* legacyPath;
+  void (*importLine)(RecordTable& table, const String& line);
+};
+
+class RecordTable {
+public:
+  explicit RecordTable(const RecordSchema& schema);
+
+  // Reads the table from SD the first time only
+  bool load();
+  bool isLoaded() const { return loaded; }
+
+  // Returns the new id, 0 on failure
+  uint16_t add(const void* rec);
+  // No-op (and no SD write later) when the record is unchanged
+  bool update(const void* rec);
+  bool remove(uint16_t id);
+
+  size_t size() const { return order.size(); }
+  const void* at(size_t idx) const { return slotPtr(order[idx]); }
+  const void* find(uint16_t id) const;
+
+  // Bumped on every change, so views can tell when to rebuild
+  uint32_t revision() const { return rev; }
+  bool dirty() const { return pendingCount > 0; }
+  unsigned long lastEditMillis() const { return lastEdit; }
+
+  // Write queued edits as one commit block
+  bool flush();
+  // Rewrite header + snapshot, dropping the journal
+  bool compact();
+
+private:
+  const RecordSchema& schema;
+  std::vector<uint8_t>  slots;        // recordSize bytes per slot, id 0 = free
+  std::vector<uint16_t> order;        // live slots, sorted if schema.before is set
+  std::vector<uint8_t>  pending;      // queued journal entries
+  uint16_t pendingCount = 0;
+  uint16_t nextId = 1;
+  uint32_t journalEntries = 0;
+  uint32_t rev = 0;
+  unsigned long lastEdit = 0;
+  bool     loaded = false;
+
+  size_t slotCount() const { return slots.size() / schema.recordSize; }
+  uint8_t* slotPtr(uint16_t slot) { return &slots[slot * schema.recordSize]; }
+  const uint8_t* slotPtr(uint16_t slot) const { return &slots[slot * schema.recordSize]; }
+  static uint16_t idOf(const void* rec) { return *(const uint16_t*)rec; }
+
+  int  findSlot(uint16_t id) const;
+  bool ordered(uint16_t a, uint16_t b) const;
+  void indexInsert(uint16_t slot);
+  void indexErase(uint16_t slot);
+  void applyPut(const void* rec);
+  void applyDel(uint16_t id);
+  void queue(uint8_t op, uint16_t id, const void* rec);
+  bool replay(File& file, uint16_t version);
+  bool importLegacy();
+};
+
+// Typed view over a RecordTable; T must start with "uint16_t id"
+template <typename T>
+class Table : public RecordTable {
+public:
+  explicit Table(const RecordSchema& schema) : RecordTable(schema) {}
+  uint16_t add(const T& rec)      { return RecordTable::add(&rec); }
+  bool update(const T& rec)       { return RecordTable::update(&rec); }
+  const T& at(size_t idx) const   { return *(const T*)RecordTable::at(idx); }
+  const T* find(uint16_t id) const { return (const T*)RecordTable::find(id); }
+};
+
+// Flush tables idle for RECORD_FLUSH_IDLE_MS, or every dirty table when forced
+void flushRecordStores(bool force = false);
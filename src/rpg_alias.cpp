@@ -0,0 +1,42 @@
+#include <globals.h>
+#include "rpg_alias.h"
+#if OTA_APP
+
+bool AliasTable::build(const uint16_t* weights, uint8_t count) {
+  n = 0;
+  count = min(count, (uint8_t)ALIAS_MAX);
+  uint32_t total = 0;
+  for (int i = 0; i < count; i++) total += weights[i];
+  if (total == 0) return false;
+
+  // Scale so a full column holds exactly total
+  uint32_t scaled[ALIAS_MAX];
+  uint8_t small[ALIAS_MAX], large[ALIAS_MAX];
+  int ns = 0, nl = 0;
+  for (int i = 0; i < count; i++) {
+    scaled[i] = (uint32_t)weights[i] * count;
+    alias[i] = i;
+    keep[i] = 0xFFFF;
+    if (scaled[i] < total) small[ns++] = i;
+    else large[nl++] = i;
+  }
+
+  // Top each short column up from a tall one
+  while (ns > 0 && nl > 0) {
+    uint8_t s = small[--ns];
+    uint8_t l = large[nl - 1];
+    keep[s] = (uint64_t)scaled[s] * 65536 / total;
+    alias[s] = l;
+    scaled[l] -= total - scaled[s];
+    if (scaled[l] < total) {
+      nl--;
+      small[ns++] = l;
+    }
+  }
+  // Whatever is left is full up to rounding and keeps its own entry
+
+  n = count;
+  return true;
+}
+
+#endif
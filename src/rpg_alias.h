@@ -0,0 +1,31 @@
+#pragma once
+#include <Arduino.h>
+
+// ===================== ALIAS TABLES =====================
+// Weighted random choice in constant time (Walker's alias method). build()
+// spreads the weights over count equal columns, each holding at most two
+// outcomes: its own entry up to a threshold and one alias above it. A draw
+// takes one 32-bit random value: the high half picks the column, the low half
+// is compared against the column's threshold. Encounter and loot tables are
+// compiled into these when their data is loaded, so rolling costs the same
+// for a two-entry table as for a sixteen-entry one.
+
+#define ALIAS_MAX  16
+
+class AliasTable {
+public:
+  // False (and an empty table) if count is 0 or every weight is 0
+  bool build(const uint16_t* weights, uint8_t count);
+  uint8_t size() const { return n; }
+
+  // Entry index with probability weight / total, from a uniform 32-bit value
+  uint8_t pick(uint32_t r) const {
+    uint8_t col = ((r >> 16) * n) >> 16;
+    return (r & 0xFFFF) < keep[col] ? col : alias[col];
+  }
+
+private:
+  uint8_t  n = 0;
+  uint16_t keep[ALIAS_MAX];    // of 65536; full columns alias themselves
+  uint8_t  alias[ALIAS_MAX];
+};
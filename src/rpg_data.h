@@ -195,7 +195,8 @@ static const char DATA_LEVELCURVE[] PROGMEM =
 // ---- DUNGEON 1: Crystal Caves ----
 static const char DATA_DUNGEON_1[] PROGMEM =
 "[INFO]\n"
-"id=1\nname=Crystal Caves\nfloors=3\nminLevel=1\nencounterRate=20\nenemies=1,2,3,7,20\nbossId=16\n\n"
+"id=1\nname=Crystal Caves\nfloors=3\nminLevel=1\nencounterRate=20\nenemies=1,2,3,7,20\nbossId=16\n"
+"encounter=1|1:40,2:35,3:20,20:5\nencounter=2-3|1:20,2:25,3:25,7:20,20:10\n\n"
 "[FLOOR1]\n"
 "map=0000000000000000\nmap=0009111111110000\nmap=0001001001011000\nmap=0011111111111100\n"
 "map=0010010110010100\nmap=0011111111111100\nmap=0001001005011000\nmap=0011111111111100\n"
@@ -212,7 +213,8 @@ static const char DATA_DUNGEON_1[] PROGMEM =
 // ---- DUNGEON 2: Goblin Warrens ----
 static const char DATA_DUNGEON_2[] PROGMEM =
 "[INFO]\n"
-"id=2\nname=Goblin Warrens\nfloors=4\nminLevel=3\nencounterRate=25\nenemies=4,5,6,7,11,21\nbossId=17\n\n"
+"id=2\nname=Goblin Warrens\nfloors=4\nminLevel=3\nencounterRate=25\nenemies=4,5,6,7,11,21\nbossId=17\n"
+"encounter=1-2|4:35,5:25,6:20,7:15,21:5\nencounter=3-4|4:20,5:20,6:20,7:10,11:20,21:10\n\n"
 "[FLOOR1]\n"
 "map=0000000000000000\nmap=0091111100111100\nmap=0010010100100100\nmap=0011111111111100\n"
 "map=0001001010010000\nmap=0011111111110000\nmap=0010100101011100\nmap=0011110111010100\n"
@@ -233,7 +235,8 @@ static const char DATA_DUNGEON_2[] PROGMEM =
 // ---- DUNGEON 3: Shadow Tower ----
 static const char DATA_DUNGEON_3[] PROGMEM =
 "[INFO]\n"
-"id=3\nname=Shadow Tower\nfloors=5\nminLevel=6\nencounterRate=30\nenemies=8,9,10,12,13,22\nbossId=18\n\n"
+"id=3\nname=Shadow Tower\nfloors=5\nminLevel=6\nencounterRate=30\nenemies=8,9,10,12,13,22\nbossId=18\n"
+"encounter=1-2|8:20,9:10,10:20,12:35,13:15\nencounter=3-5|8:20,9:15,10:20,12:20,13:15,22:10\n\n"
 "[FLOOR1]\n"
 "map=0000000000000000\nmap=0091111111111100\nmap=0010010100100100\nmap=0011111111111100\n"
 "map=0001001010010100\nmap=0011111111111100\nmap=0010010100100100\nmap=0011111111111100\n"
@@ -284,5 +287,26 @@ static const char DATA_DUNGEON_4[] PROGMEM =
 "map=0001110501110000\nmap=0011111111111000\nmap=0010010110010100\nmap=0011111111111100\n"
 "map=0001108001110000\nmap=0000111111000000\nmap=0000011100000000\nmap=0000000000000000\n\n";
 
+// ---- DUNGEON 5: Endless Depths ----
+// No [FLOOR] sections: floors are generated from the save's seed. The enemy
+// pool is weakest first and opens up with depth; bosses are the strongest
+// enemy in reach. Encounter bands shift the odds toward the deep end.
+static const char DATA_DUNGEON_5[] PROGMEM =
+"[INFO]\n"
+"id=5\nname=Endless Depths\nfloors=0\nminLevel=2\nencounterRate=20\nenemies=1,7,4,6,10,12,23,25\nendless=1\n"
+"encounter=1-3|1:50,7:35,4:15\nencounter=4-8|7:25,4:30,6:30,10:15\n"
+"encounter=9-15|4:15,6:25,10:25,12:25,23:10\nencounter=16-65535|6:10,10:20,12:25,23:25,25:20\n\n";
+
+// ---- CHEST LOOT ----
+// One [LOOT] band per floor range; drop=itemId,weight,minQty,maxQty, where
+// item 0 is gold. Floors past the last band use it.
+static const char DATA_LOOT[] PROGMEM =
+"[LOOT]\n"
+"floors=1-4\ndrop=1,40,1,2\ndrop=2,20,1,1\ndrop=0,20,20,49\ndrop=5,20,1,1\n\n"
+"[LOOT]\n"
+"floors=5-9\ndrop=1,25,2,3\ndrop=4,20,1,1\ndrop=3,20,1,1\ndrop=0,20,40,89\ndrop=5,15,1,1\n\n"
+"[LOOT]\n"
+"floors=10-65535\ndrop=4,30,1,2\ndrop=3,20,1,2\ndrop=0,25,80,159\ndrop=5,25,1,2\n\n";
+
 // Number of dungeons available
-#define EMBEDDED_DUNGEON_COUNT 4
+#define EMBEDDED_DUNGEON_COUNT 5
@@ -0,0 +1,70 @@
+#include <globals.h>
+#include "rpg_fov.h"
+#if OTA_APP
+
+// (xx, xy, yx, yy): map (col, row) in octant space to (dx, dy)
+static const int8_t FOV_OCTANTS[8][4] = {
+  { 1,  0,  0,  1 }, { 0,  1,  1,  0 }, { 0, -1,  1,  0 }, {-1,  0,  0,  1 },
+  {-1,  0,  0, -1 }, { 0, -1, -1,  0 }, { 0,  1, -1,  0 }, { 1,  0,  0, -1 },
+};
+
+// Widest |dx| inside the radius for each |dy|; r*r + r rounds the circle out
+struct FovSpans {
+  uint8_t dx[FOV_RADIUS + 1];
+  constexpr FovSpans() : dx() {
+    for (int dy = 0; dy <= FOV_RADIUS; dy++) {
+      int d = 0;
+      while ((d + 1) * (d + 1) + dy * dy <= FOV_RADIUS * FOV_RADIUS + FOV_RADIUS) d++;
+      dx[dy] = d;
+    }
+  }
+};
+static constexpr FovSpans FOV_SPANS;
+
+struct FovScan {
+  int ox, oy;
+  FovOpaqueFn opaque;
+  FovRevealFn reveal;
+};
+
+static void castLight(const FovScan& s, int row, float start, float end, const int8_t* t) {
+  if (start < end) return;
+  float newStart = 0;
+  for (int j = row; j <= FOV_RADIUS; j++) {
+    bool blocked = false;
+    for (int dx = -j, dy = -j; dx <= 0; dx++) {
+      float leftSlope = (dx - 0.5f) / (dy + 0.5f);
+      float rightSlope = (dx + 0.5f) / (dy - 0.5f);
+      if (start < rightSlope) continue;
+      if (end > leftSlope) break;
+
+      int ax = -dx, ay = j;     // column and depth in octant space
+      int x = s.ox + ax * t[0] + ay * t[1];
+      int y = s.oy + ax * t[2] + ay * t[3];
+      if (ax <= FOV_SPANS.dx[ay]) s.reveal(x, y);
+
+      bool wall = s.opaque(x, y);
+      if (blocked) {
+        if (wall) {
+          newStart = rightSlope;
+        } else {
+          blocked = false;
+          start = newStart;
+        }
+      } else if (wall && j < FOV_RADIUS) {
+        blocked = true;
+        castLight(s, j + 1, start, leftSlope, t);
+        newStart = rightSlope;
+      }
+    }
+    if (blocked) break;
+  }
+}
+
+void computeFov(int ox, int oy, FovOpaqueFn opaque, FovRevealFn reveal) {
+  FovScan s = { ox, oy, opaque, reveal };
+  reveal(ox, oy);
+  for (int o = 0; o < 8; o++) castLight(s, 1, 1.0f, 0.0f, FOV_OCTANTS[o]);
+}
+
+#endif
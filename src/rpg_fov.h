@@ -0,0 +1,19 @@
+#pragma once
+#include <Arduino.h>
+
+// ===================== FIELD OF VIEW =====================
+// Line of sight for the dungeon fog of war, by recursive shadowcasting: each
+// of the eight octants is scanned row by row outward from the viewer, and a
+// run of opaque tiles narrows the slope range later rows may see, so every
+// tile within FOV_RADIUS is visited at most once per octant. The octant
+// transforms and the circular radius (widest column per row) are constant
+// tables, leaving only additions and compares in the scan.
+
+#define FOV_RADIUS  5
+#define FOV_MAX_TILES ((2 * FOV_RADIUS + 1) * (2 * FOV_RADIUS + 1))
+
+typedef bool (*FovOpaqueFn)(int x, int y);
+// Called for every visible tile, possibly more than once
+typedef void (*FovRevealFn)(int x, int y);
+
+void computeFov(int ox, int oy, FovOpaqueFn opaque, FovRevealFn reveal);
@@ -0,0 +1,99 @@
+#include <globals.h>
+#include "rpg_map.h"
+#include "rpg_tiles.h"
+#if OTA_APP
+
+void ChunkMap::open(uint16_t width, uint16_t height, ChunkLoader load) {
+  w = min(width, (uint16_t)MAP_MAX_SIDE);
+  h = min(height, (uint16_t)MAP_MAX_SIDE);
+  xSemaphoreTake(lock, portMAX_DELAY);
+  loader = load;
+  for (Slot& s : slots) s.key = NO_CHUNK;
+  last = nullptr;
+  xSemaphoreGive(lock);
+  camX = camY = 0;
+  marked = 0;
+}
+
+ChunkMap::Slot& ChunkMap::chunk(uint8_t cx, uint8_t cy) {
+  uint16_t key = cy * MAP_CHUNK + cx;
+  if (last && last->key == key) return *last;
+
+  Slot* victim = &slots[0];
+  for (Slot& s : slots) {
+    if (s.key == key) {
+      s.used = ++clock;
+      last = &s;
+      return s;
+    }
+    if (s.key == NO_CHUNK || (victim->key != NO_CHUNK && s.used < victim->used)) victim = &s;
+  }
+
+  uint8_t tiles[MAP_CHUNK * MAP_CHUNK];
+  memset(tiles, TILE_WALL, sizeof(tiles));
+  if (loader) loader(cx, cy, tiles);
+
+  // Clip to the map so tile() needs no bounds test of its own beyond inside()
+  for (int y = 0; y < MAP_CHUNK; y++) {
+    for (int x = 0; x < MAP_CHUNK; x++) {
+      if (!inside(cx * MAP_CHUNK + x, cy * MAP_CHUNK + y)) tiles[y * MAP_CHUNK + x] = TILE_WALL;
+    }
+  }
+  for (int i = 0; i < MAP_CHUNK_BYTES; i++) {
+    victim->data[i] = (tiles[i * 2] & 0x0F) | (tiles[i * 2 + 1] << 4);
+  }
+  victim->key = key;
+  victim->used = ++clock;
+  last = victim;
+  return *victim;
+}
+
+uint8_t ChunkMap::tile(int x, int y) {
+  if (!inside(x, y)) return TILE_WALL;
+  xSemaphoreTake(lock, portMAX_DELAY);
+  const Slot& s = chunk(x / MAP_CHUNK, y / MAP_CHUNK);
+  uint8_t b = s.data[(y % MAP_CHUNK) * (MAP_CHUNK / 2) + (x % MAP_CHUNK) / 2];
+  xSemaphoreGive(lock);
+  return (x & 1) ? b >> 4 : b & 0x0F;
+}
+
+void ChunkMap::setTile(int x, int y, uint8_t t) {
+  if (!inside(x, y)) return;
+  xSemaphoreTake(lock, portMAX_DELAY);
+  Slot& s = chunk(x / MAP_CHUNK, y / MAP_CHUNK);
+  uint8_t& b = s.data[(y % MAP_CHUNK) * (MAP_CHUNK / 2) + (x % MAP_CHUNK) / 2];
+  b = (x & 1) ? (b & 0x0F) | (t << 4) : (b & 0xF0) | (t & 0x0F);
+  xSemaphoreGive(lock);
+}
+
+void ChunkMap::setMark(uint8_t t, uint8_t x, uint8_t y) {
+  if (t >= 16) return;
+  marks[t] = (y << 8) | x;
+  marked |= 1 << t;
+}
+
+bool ChunkMap::findMark(uint8_t t, uint8_t& x, uint8_t& y) const {
+  if (t >= 16 || !(marked & (1 << t))) return false;
+  x = marks[t] & 0xFF;
+  y = marks[t] >> 8;
+  return true;
+}
+
+static uint16_t scrollAxis(int pos, uint16_t cam, int view, int size) {
+  int c = cam;
+  if (pos < c + MAP_VIEW_MARGIN) c = pos - MAP_VIEW_MARGIN;
+  else if (pos > c + view - 1 - MAP_VIEW_MARGIN) c = pos - (view - 1 - MAP_VIEW_MARGIN);
+  c = min(c, size - view);
+  return max(c, 0);
+}
+
+bool ChunkMap::follow(int x, int y) {
+  uint16_t nx = scrollAxis(x, camX, MAP_VIEW_W, w);
+  uint16_t ny = scrollAxis(y, camY, MAP_VIEW_H, h);
+  bool moved = nx != camX || ny != camY;
+  camX = nx;
+  camY = ny;
+  return moved;
+}
+
+#endif
@@ -0,0 +1,79 @@
+#pragma once
+#include <Arduino.h>
+
+// ===================== CHUNKED DUNGEON MAP =====================
+// Dungeon floors of up to MAP_MAX_SIDE x MAP_MAX_SIDE tiles. The map is
+// addressed as 16x16-tile chunks packed two tiles per byte (128 bytes each);
+// only MAP_CACHE_CHUNKS of them are resident, in a least-recently-used cache
+// that pulls missing chunks from the floor's loader (parsed from flash text,
+// regenerated, or read from a content pack). RAM use is the same for a
+// 16x12 floor as for a 256x256 one.
+//
+// The camera is a MAP_VIEW_W x MAP_VIEW_H window that scrolls to keep the
+// player MAP_VIEW_MARGIN tiles from its edge; drawing walks the window only,
+// which touches at most four chunks.
+//
+// Changes made through setTile() live in the cache only. Loaders re-apply
+// persistent changes (world state) so an evicted chunk comes back the same.
+//
+// The keyboard task moves and paths through the map while the e-ink task
+// draws it, so every cache access goes through a mutex.
+
+#define MAP_CHUNK          16
+#define MAP_CHUNK_BYTES    (MAP_CHUNK * MAP_CHUNK / 2)
+#define MAP_MAX_SIDE       256
+#define MAP_CACHE_CHUNKS   6
+#define MAP_VIEW_W         16
+#define MAP_VIEW_H         12
+#define MAP_VIEW_MARGIN    3
+
+class ChunkMap {
+public:
+  // Fill tiles[MAP_CHUNK * MAP_CHUNK] (one tile per byte, row-major) for
+  // chunk (cx, cy). Tiles past the map edge are already walls.
+  typedef void (*ChunkLoader)(uint8_t cx, uint8_t cy, uint8_t* tiles);
+
+  // Switch to a new floor; drops every cached chunk and mark
+  void open(uint16_t w, uint16_t h, ChunkLoader loader);
+
+  uint16_t width() const { return w; }
+  uint16_t height() const { return h; }
+  bool inside(int x, int y) const { return x >= 0 && y >= 0 && x < w && y < h; }
+  // Tile index for world state and other per-floor bitsets
+  uint16_t index(int x, int y) const { return y * w + x; }
+
+  // Walls outside the map
+  uint8_t tile(int x, int y);
+  void setTile(int x, int y, uint8_t t);
+
+  // Where a landmark tile (entrance, stairs) sits, noted by the floor
+  // loader so arrivals need no scan of the whole map
+  void setMark(uint8_t t, uint8_t x, uint8_t y);
+  bool findMark(uint8_t t, uint8_t& x, uint8_t& y) const;
+
+  // Scroll the camera so (x, y) is inside the margin; false if it did not move
+  bool follow(int x, int y);
+  uint16_t viewX() const { return camX; }
+  uint16_t viewY() const { return camY; }
+
+private:
+  struct Slot {
+    uint16_t key;                  // cy * MAP_CHUNK + cx, NO_CHUNK if empty
+    uint32_t used;                 // LRU stamp
+    uint8_t  data[MAP_CHUNK_BYTES];
+  };
+  static constexpr uint16_t NO_CHUNK = 0xFFFF;
+
+  Slot        slots[MAP_CACHE_CHUNKS];
+  Slot*       last = nullptr;      // most recent hit
+  uint32_t    clock = 0;
+  uint16_t    w = 0, h = 0;
+  uint16_t    camX = 0, camY = 0;
+  ChunkLoader loader = nullptr;
+  uint16_t    marks[16];           // y << 8 | x
+  uint16_t    marked = 0;          // bit t set once marks[t] is valid
+  SemaphoreHandle_t lock = xSemaphoreCreateMutex();  // guards slots, last and clock
+
+  // Caller holds lock
+  Slot& chunk(uint8_t cx, uint8_t cy);
+};
@@ -0,0 +1,151 @@
+#include <globals.h>
+#include "rpg_mapgen.h"
+#if OTA_APP
+
+// xorshift32: the generator must not touch the game's random() sequence,
+// and the same seed has to give the same floor on every run
+struct MapRng {
+  uint32_t s;
+  uint32_t next() {
+    s ^= s << 13;
+    s ^= s >> 17;
+    s ^= s << 5;
+    return s;
+  }
+  int range(int n) { return n > 0 ? next() % n : 0; }
+};
+
+struct Room {
+  uint8_t x, y, w, h;
+  uint8_t cx() const { return x + w / 2; }
+  uint8_t cy() const { return y + h / 2; }
+};
+
+uint32_t floorSeed(uint32_t worldSeed, uint16_t dungeonId, uint16_t floor) {
+  uint32_t h = worldSeed ^ (dungeonId * 0x9E3779B9u) ^ (floor * 0x85EBCA6Bu);
+  h ^= h >> 16;
+  h *= 0x7FEB352Du;
+  h ^= h >> 15;
+  h *= 0x846CA68Bu;
+  h ^= h >> 16;
+  return h ? h : 1;   // xorshift is stuck at 0
+}
+
+static void carve(uint8_t* map, int x0, int y0, int x1, int y1) {
+  if (x0 > x1) { int t = x0; x0 = x1; x1 = t; }
+  if (y0 > y1) { int t = y0; y0 = y1; y1 = t; }
+  for (int y = y0; y <= y1; y++) {
+    for (int x = x0; x <= x1; x++) map[y * DUNGEON_W + x] = TILE_FLOOR;
+  }
+}
+
+// Take a random tile out of the candidate list
+static int takeRandom(MapRng& rng, uint8_t* list, int& count) {
+  if (count == 0) return -1;
+  int i = rng.range(count);
+  int tile = list[i];
+  list[i] = list[--count];
+  return tile;
+}
+
+void generateFloor(uint32_t seed, uint16_t floor, uint8_t* map) {
+  static_assert(DUNGEON_TILES <= 255, "tile indices are stored in bytes");
+  MapRng rng = { seed };
+  memset(map, TILE_WALL, DUNGEON_TILES);
+
+  // Rooms, kept one wall apart and off the outer border
+  Room rooms[MAPGEN_MAX_ROOMS];
+  int roomCount = 0;
+  for (int t = 0; t < MAPGEN_ROOM_TRIES && roomCount < MAPGEN_MAX_ROOMS; t++) {
+    Room r;
+    r.w = 3 + rng.range(4);
+    r.h = 2 + rng.range(3);
+    r.x = 1 + rng.range(DUNGEON_W - r.w - 1);
+    r.y = 1 + rng.range(DUNGEON_H - r.h - 1);
+    bool clear = true;
+    for (int i = 0; i < roomCount && clear; i++) {
+      const Room& o = rooms[i];
+      clear = r.x > o.x + o.w || o.x > r.x + r.w || r.y > o.y + o.h || o.y > r.y + r.h;
+    }
+    if (!clear) continue;
+    carve(map, r.x, r.y, r.x + r.w - 1, r.y + r.h - 1);
+    rooms[roomCount++] = r;
+  }
+  if (roomCount == 0) {
+    rooms[0] = { 2, 2, 6, 4 };
+    carve(map, 2, 2, 7, 5);
+    roomCount = 1;
+  }
+
+  // Chain the rooms together
+  for (int i = 1; i < roomCount; i++) {
+    int ax = rooms[i - 1].cx(), ay = rooms[i - 1].cy();
+    int bx = rooms[i].cx(), by = rooms[i].cy();
+    if (rng.range(2)) {
+      carve(map, ax, ay, bx, ay);
+      carve(map, bx, ay, bx, by);
+    } else {
+      carve(map, ax, ay, ax, by);
+      carve(map, ax, by, bx, by);
+    }
+  }
+
+  // Flood fill from the arrival point; every feature goes on a tile it reached
+  int start = rooms[0].cy() * DUNGEON_W + rooms[0].cx();
+  uint8_t dist[DUNGEON_TILES];
+  uint8_t queue[DUNGEON_TILES];
+  memset(dist, 0xFF, sizeof(dist));
+  int head = 0, tail = 0;
+  dist[start] = 0;
+  queue[tail++] = start;
+  while (head < tail) {
+    int cur = queue[head++];
+    int x = cur % DUNGEON_W, y = cur / DUNGEON_W;
+    const int nbr[4] = { x > 0 ? cur - 1 : -1, x < DUNGEON_W - 1 ? cur + 1 : -1,
+                         y > 0 ? cur - DUNGEON_W : -1, y < DUNGEON_H - 1 ? cur + DUNGEON_W : -1 };
+    for (int n : nbr) {
+      if (n < 0 || map[n] == TILE_WALL || dist[n] != 0xFF) continue;
+      dist[n] = dist[cur] + 1;
+      queue[tail++] = n;
+    }
+  }
+
+  // BFS order is by distance, so the last tile dequeued is the farthest
+  int stairs = queue[tail - 1];
+  map[start] = floor <= 1 ? TILE_ENTRANCE : TILE_STAIRS_UP;
+  if (stairs != start) map[stairs] = TILE_STAIRS_DOWN;
+
+  if (floor % MAPGEN_BOSS_EVERY == 0 && dist[stairs] > 1) {
+    // On the shortest path, one step before the stairs
+    int x = stairs % DUNGEON_W, y = stairs / DUNGEON_W;
+    const int nbr[4] = { x > 0 ? stairs - 1 : -1, x < DUNGEON_W - 1 ? stairs + 1 : -1,
+                         y > 0 ? stairs - DUNGEON_W : -1, y < DUNGEON_H - 1 ? stairs + DUNGEON_W : -1 };
+    for (int n : nbr) {
+      if (n >= 0 && dist[n] == dist[stairs] - 1 && map[n] == TILE_FLOOR) {
+        map[n] = TILE_BOSS;
+        break;
+      }
+    }
+  }
+
+  // Reachable plain floor, minus the tiles next to the arrival point
+  uint8_t open[DUNGEON_TILES];
+  int openCount = 0;
+  for (int i = 0; i < tail; i++) {
+    int t = queue[i];
+    if (map[t] == TILE_FLOOR && dist[t] > 1) open[openCount++] = t;
+  }
+
+  int chests = 1 + rng.range(2);
+  for (int i = 0; i < chests; i++) {
+    int t = takeRandom(rng, open, openCount);
+    if (t >= 0) map[t] = TILE_CHEST;
+  }
+  int traps = 1 + min(floor / 4, 3) + rng.range(2);
+  for (int i = 0; i < traps; i++) {
+    int t = takeRandom(rng, open, openCount);
+    if (t >= 0) map[t] = TILE_TRAP;
+  }
+}
+
+#endif
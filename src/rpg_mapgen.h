@@ -0,0 +1,24 @@
+#pragma once
+#include <Arduino.h>
+#include "rpg_tiles.h"
+
+// ===================== FLOOR GENERATOR =====================
+// Endless-descent floors for Mage's Descent. A floor is a pure function of
+// its seed: rooms are dropped at random without overlapping, joined in order
+// by L-shaped corridors, and a flood fill from the arrival stairs decides
+// where everything else goes. The down stairs take the reachable tile
+// farthest from the arrival point, a boss guards them every
+// MAPGEN_BOSS_EVERY floors, and chests and traps only land on reachable
+// floor, so every generated floor can be completed. Nothing is stored per
+// floor: revisiting one regenerates it, and its opened chests and sprung
+// traps come from the world state as for hand-drawn floors.
+
+#define MAPGEN_MAX_ROOMS   6
+#define MAPGEN_ROOM_TRIES  24
+#define MAPGEN_BOSS_EVERY  5
+
+// Seed of one floor of one dungeon in a game started with worldSeed
+uint32_t floorSeed(uint32_t worldSeed, uint16_t dungeonId, uint16_t floor);
+
+// Fill map (DUNGEON_W x DUNGEON_H) with floor number floor (1-based)
+void generateFloor(uint32_t seed, uint16_t floor, uint8_t* map);
@@ -0,0 +1,187 @@
+#include <globals.h>
+#include <algorithm>
+#include "io_session.h"
+#include "rpg_pack.h"
+#if OTA_APP
+
+static constexpr const char* TAG = "RPG_PACK";
+
+struct PackHeader {
+  uint32_t magic;
+  uint16_t version;
+  uint16_t typeCount;
+};
+
+struct PackTypeEntry {
+  uint32_t count;
+  uint32_t indexOffset;
+};
+
+PackLibrary& PACKS() {
+  static PackLibrary instance;
+  return instance;
+}
+
+bool PackLibrary::load(const String& path, Pack& pack) {
+  File f = SD_MMC.open(path, FILE_READ);
+  if (!f) return false;
+
+  PackHeader hdr;
+  if (f.read((uint8_t*)&hdr, sizeof(hdr)) != sizeof(hdr) || hdr.magic != PACK_MAGIC || hdr.version != PACK_VERSION) {
+    ESP_LOGW(TAG, "%s is not a version %d pack", path.c_str(), PACK_VERSION);
+    f.close();
+    return false;
+  }
+
+  // Types this build does not know about are skipped
+  PackTypeEntry entries[PACK_TYPES] = {};
+  size_t known = min((int)hdr.typeCount, (int)PACK_TYPES);
+  if (f.read((uint8_t*)entries, known * sizeof(PackTypeEntry)) != known * sizeof(PackTypeEntry)) {
+    f.close();
+    return false;
+  }
+
+  const uint32_t fileSize = f.size();
+  bool ok = true;
+  for (size_t t = 0; t < known && ok; t++) {
+    uint32_t count = entries[t].count;
+    if (count == 0) continue;
+
+    // The index must fit in the file before anything is allocated for it
+    uint32_t indexOffset = entries[t].indexOffset;
+    uint64_t idBytes = (uint64_t)count * sizeof(uint16_t);
+    uint64_t offBytes = ((uint64_t)count + 1) * sizeof(uint32_t);
+    uint64_t indexEnd = (uint64_t)indexOffset + ((idBytes + 3) & ~3ULL) + offBytes;
+    if (indexEnd > fileSize) {
+      ok = false;
+      break;
+    }
+
+    TypeIndex& idx = pack.types[t];
+    idx.ids.resize(count);
+    idx.offsets.resize(count + 1);
+    ok = f.seek(indexOffset) &&
+         f.read((uint8_t*)idx.ids.data(), idBytes) == idBytes &&
+         f.seek(indexOffset + ((idBytes + 3) & ~3)) &&
+         f.read((uint8_t*)idx.offsets.data(), offBytes) == offBytes;
+
+    // Lookups binary-search the ids and record lengths come from offset
+    // differences, so both have to be ordered and inside the file
+    ok = ok && idx.offsets[0] >= indexEnd && idx.offsets[count] <= fileSize;
+    for (uint32_t i = 0; i < count && ok; i++) {
+      ok = idx.offsets[i] <= idx.offsets[i + 1] && (i == 0 || idx.ids[i - 1] < idx.ids[i]);
+    }
+  }
+  f.close();
+  if (!ok) ESP_LOGW(TAG, "%s: bad index", path.c_str());
+  return ok;
+}
+
+int PackLibrary::mount() {
+  unmount();
+  IoSession io;
+  File dir = SD_MMC.open(PACK_DIR);
+  if (!dir || !dir.isDirectory()) {
+    if (dir) dir.close();
+    return 0;
+  }
+
+  std::vector<String> paths;
+  for (File f = dir.openNextFile(); f; f = dir.openNextFile()) {
+    String name = f.name();
+    bool isPack = !f.isDirectory() && name.endsWith(PACK_EXT);
+    f.close();
+    if (!isPack) continue;
+    name = name.substring(name.lastIndexOf('/') + 1);
+    paths.push_back(String(PACK_DIR) + "/" + name);
+  }
+  dir.close();
+
+  // Name order decides which pack wins a shared id
+  std::sort(paths.begin(), paths.end(), [](const String& a, const String& b) { return a < b; });
+  for (const String& path : paths) {
+    if (packs.size() >= PACK_MAX_MOUNTS) {
+      ESP_LOGW(TAG, "Only %d packs are mounted; %s skipped", PACK_MAX_MOUNTS, path.c_str());
+      continue;
+    }
+    Pack pack;
+    pack.path = path;
+    if (load(path, pack)) {
+      packs.push_back(std::move(pack));
+      ESP_LOGI(TAG, "Mounted %s", path.c_str());
+    }
+  }
+  return packs.size();
+}
+
+void PackLibrary::unmount() {
+  xSemaphoreTake(readerLock, portMAX_DELAY);
+  if (reader) reader.close();
+  readerPack = -1;
+  xSemaphoreGive(readerLock);
+  packs.clear();
+}
+
+bool PackLibrary::find(PackType type, uint16_t id, int& pack, size_t& slot) const {
+  for (int p = (int)packs.size() - 1; p >= 0; p--) {
+    const std::vector<uint16_t>& ids = packs[p].types[type].ids;
+    auto it = std::lower_bound(ids.begin(), ids.end(), id);
+    if (it != ids.end() && *it == id) {
+      pack = p;
+      slot = it - ids.begin();
+      return true;
+    }
+  }
+  return false;
+}
+
+uint32_t PackLibrary::size(PackType type, uint16_t id) {
+  int p;
+  size_t slot;
+  if (!find(type, id, p, slot)) return 0;
+  const std::vector<uint32_t>& off = packs[p].types[type].offsets;
+  return off[slot + 1] - off[slot];
+}
+
+uint32_t PackLibrary::read(PackType type, uint16_t id, char* buf, size_t cap) {
+  int p;
+  size_t slot;
+  if (cap == 0 || !find(type, id, p, slot)) return 0;
+  const std::vector<uint32_t>& off = packs[p].types[type].offsets;
+  uint32_t len = off[slot + 1] - off[slot];
+  size_t want = min((size_t)len, cap - 1);
+
+  IoSession io;
+  xSemaphoreTake(readerLock, portMAX_DELAY);
+  if (readerPack != p || !reader) {
+    if (reader) reader.close();
+    reader = SD_MMC.open(packs[p].path, FILE_READ);
+    readerPack = reader ? p : -1;
+  }
+  bool opened = readerPack == p;
+  bool ok = opened && reader.seek(off[slot]) && reader.read((uint8_t*)buf, want) == want;
+  xSemaphoreGive(readerLock);
+
+  if (!opened) {
+    ESP_LOGE(TAG, "Cannot open %s", packs[p].path.c_str());
+    return 0;
+  }
+  if (!ok) {
+    ESP_LOGE(TAG, "Read failed: type %d id %d", type, id);
+    return 0;
+  }
+  buf[want] = 0;
+  return len;
+}
+
+void PackLibrary::ids(PackType type, std::vector<uint16_t>& out) const {
+  out.clear();
+  for (const Pack& pack : packs) {
+    const std::vector<uint16_t>& ids = pack.types[type].ids;
+    out.insert(out.end(), ids.begin(), ids.end());
+  }
+  std::sort(out.begin(), out.end());
+  out.erase(std::unique(out.begin(), out.end()), out.end());
+}
+
+#endif
@@ -0,0 +1,78 @@
+#pragma once
+#include <Arduino.h>
+#include <FS.h>
+#include <vector>
+
+// ===================== CONTENT PACKS =====================
+// Extra or replacement game content on SD, so new enemies, items or dungeons
+// need no reflash. build_content_pack.py compiles the text sources (the same
+// [ENEMY]/[ITEM]/... blocks as rpg_data.h) into a .mdpak file; every pack in
+// PACK_DIR is mounted at start and a pack record overrides the embedded one
+// with the same id (later pack names override earlier ones).
+//
+// Pack layout, little-endian:
+//   header       "MDPK", uint16 version, uint16 typeCount
+//   type table   typeCount x { uint32 count, uint32 indexOffset }
+//   per type     uint16 ids[count] (ascending), padded to 4 bytes,
+//                uint32 offsets[count + 1] (record i is offsets[i]..[i+1])
+//   records      the record's text block, as in the source files
+//
+// Mounting reads the index arrays straight into RAM; nothing is parsed. A
+// lookup is a binary search over the ids, and a record costs one seek and
+// one read.
+
+#define PACK_DIR          "/rpg/packs"
+#define PACK_EXT          ".mdpak"
+#define PACK_MAGIC        0x4B50444D   // "MDPK"
+#define PACK_VERSION      1
+#define PACK_MAX_MOUNTS   4
+#define PACK_RECORD_MAX   512          // buffer for one enemy/item/spell/quest/shop
+
+enum PackType : uint8_t {
+  PACK_ENEMY = 0,
+  PACK_ITEM,
+  PACK_SPELL,
+  PACK_QUEST,
+  PACK_SHOP,
+  PACK_DUNGEON,
+  PACK_TYPES
+};
+
+class PackLibrary {
+public:
+  // Mount every pack in PACK_DIR; returns how many mounted
+  int mount();
+  void unmount();
+  int mounted() const { return packs.size(); }
+
+  // Length of a record, 0 if no pack has it
+  uint32_t size(PackType type, uint16_t id);
+  // Read up to cap - 1 bytes of a record into buf and NUL-terminate it.
+  // Returns the full record length (more than read if truncated), 0 if
+  // no pack has it.
+  uint32_t read(PackType type, uint16_t id, char* buf, size_t cap);
+  // Every id of a type across all packs, ascending
+  void ids(PackType type, std::vector<uint16_t>& out) const;
+
+private:
+  struct TypeIndex {
+    std::vector<uint16_t> ids;
+    std::vector<uint32_t> offsets;     // ids.size() + 1 entries
+  };
+  struct Pack {
+    String    path;
+    TypeIndex types[PACK_TYPES];
+  };
+
+  std::vector<Pack> packs;
+  File   reader;                         // last pack read, kept open
+  int    readerPack = -1;
+  // Records are read from the keyboard and the e-ink task; one at a time
+  SemaphoreHandle_t readerLock = xSemaphoreCreateMutex();
+
+  bool load(const String& path, Pack& pack);
+  // Newest pack holding the record; its index and the record's slot
+  bool find(PackType type, uint16_t id, int& pack, size_t& slot) const;
+};
+
+PackLibrary& PACKS();
@@ -0,0 +1,106 @@
+#include <globals.h>
+#include "esp_heap_caps.h"
+#include "rpg_path.h"
+#if OTA_APP
+
+static constexpr const char* TAG = "RPG_PATH";
+
+// BFS queue shared by all fields; grows to the largest floor built
+static uint16_t* pathQueue = nullptr;
+static size_t pathQueueCap = 0;
+
+static uint16_t* allocTiles(size_t count) {
+  uint16_t* p = nullptr;
+  if (psramFound()) p = (uint16_t*)heap_caps_malloc(count * sizeof(uint16_t), MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+  if (!p) p = (uint16_t*)malloc(count * sizeof(uint16_t));
+  return p;
+}
+
+bool DistanceField::build(uint16_t width, uint16_t height, TileFn passable, TileFn goal) {
+  ok = false;
+  size_t count = (size_t)width * height;
+  if (count == 0 || count > 65536) return false;
+
+  if (cap < count) {
+    free(dist);
+    dist = allocTiles(count);
+    cap = dist ? count : 0;
+  }
+  if (pathQueueCap < count) {
+    free(pathQueue);
+    pathQueue = allocTiles(count);
+    pathQueueCap = pathQueue ? count : 0;
+  }
+  if (!dist || !pathQueue) {
+    ESP_LOGE(TAG, "No memory for a %ux%u distance field", width, height);
+    return false;
+  }
+  w = width;
+  h = height;
+
+  // Walls are marked by leaving them at PATH_UNREACHED - 1; they are never
+  // queued and never reported as reachable
+  static constexpr uint16_t WALL = PATH_UNREACHED - 1;
+  size_t head = 0, tail = 0;
+  for (int by = 0; by < h; by += 16) {
+    for (int bx = 0; bx < w; bx += 16) {
+      for (int y = by; y < by + 16 && y < h; y++) {
+        for (int x = bx; x < bx + 16 && x < w; x++) {
+          uint16_t idx = y * w + x;
+          if (!passable(x, y)) {
+            dist[idx] = WALL;
+          } else if (goal(x, y)) {
+            dist[idx] = 0;
+            pathQueue[tail++] = idx;
+          } else {
+            dist[idx] = PATH_UNREACHED;
+          }
+        }
+      }
+    }
+  }
+
+  while (head < tail) {
+    uint16_t cur = pathQueue[head++];
+    int x = cur % w, y = cur / w;
+    uint16_t d = dist[cur] + 1;
+    const int nbr[4] = { x > 0 ? cur - 1 : -1, x < w - 1 ? cur + 1 : -1,
+                         y > 0 ? cur - w : -1, y < h - 1 ? cur + w : -1 };
+    for (int n : nbr) {
+      if (n < 0 || dist[n] != PATH_UNREACHED) continue;
+      dist[n] = d;
+      pathQueue[tail++] = n;
+    }
+  }
+
+  for (size_t i = 0; i < count; i++) {
+    if (dist[i] == WALL) dist[i] = PATH_UNREACHED;
+  }
+  ok = true;
+  return true;
+}
+
+uint16_t DistanceField::at(int x, int y) const {
+  if (!ok || x < 0 || y < 0 || x >= w || y >= h) return PATH_UNREACHED;
+  return dist[y * w + x];
+}
+
+bool DistanceField::next(int x, int y, int& nx, int& ny) const {
+  uint16_t best = at(x, y);
+  if (best == 0 || best == PATH_UNREACHED) return false;
+  const int dx[4] = { 0, 0, -1, 1 };
+  const int dy[4] = { -1, 1, 0, 0 };
+  bool found = false;
+  for (int i = 0; i < 4; i++) {
+    uint16_t d = at(x + dx[i], y + dy[i]);
+    if (d < best) {
+      best = d;
+      nx = x + dx[i];
+      ny = y + dy[i];
+      found = true;
+    }
+  }
+  return found;
+}
+
+#endif
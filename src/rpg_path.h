@@ -0,0 +1,34 @@
+#pragma once
+#include <Arduino.h>
+
+// ===================== DISTANCE FIELDS =====================
+// Breadth-first distance from every tile of a floor to the nearest goal tile
+// (stairs, unopened chests, ...). Built once, a field answers "which way
+// now?" from any tile in four lookups, so walking a path of any length costs
+// nothing more. Goals are seeded together, which makes "nearest of several"
+// free. Fields live in PSRAM when available and keep their buffers across
+// rebuilds.
+
+#define PATH_UNREACHED 0xFFFF
+
+class DistanceField {
+public:
+  typedef bool (*TileFn)(int x, int y);
+
+  // Rebuild for a w x h floor. Tiles are visited in 16x16 blocks so a
+  // chunked map loads each chunk once. False if out of memory.
+  bool build(uint16_t w, uint16_t h, TileFn passable, TileFn goal);
+  bool valid() const { return ok; }
+  void invalidate() { ok = false; }
+
+  // Steps to the nearest goal, PATH_UNREACHED if there is no way
+  uint16_t at(int x, int y) const;
+  // Neighbour one step closer to a goal; false on a goal or when unreachable
+  bool next(int x, int y, int& nx, int& ny) const;
+
+private:
+  uint16_t* dist = nullptr;
+  size_t    cap = 0;
+  uint16_t  w = 0, h = 0;
+  bool      ok = false;
+};
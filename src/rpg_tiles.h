@@ -0,0 +1,25 @@
+#pragma once
+#include <Arduino.h>
+
+// ===================== DUNGEON TILES =====================
+// Tile codes shared by the floor loader, the generator and the map views.
+// Hand-drawn floors in rpg_data.h store each tile as its decimal digit and
+// take their size from their map= rows; generated floors are DUNGEON_W x
+// DUNGEON_H. Codes fit in 4 bits (see rpg_map.h).
+
+#define DUNGEON_W      16
+#define DUNGEON_H      12
+#define DUNGEON_TILES  (DUNGEON_W * DUNGEON_H)
+
+enum TileType : uint8_t {
+  TILE_WALL = 0,
+  TILE_FLOOR = 1,
+  TILE_DOOR = 2,
+  TILE_STAIRS_DOWN = 3,
+  TILE_STAIRS_UP = 4,
+  TILE_CHEST = 5,
+  TILE_NPC = 6,
+  TILE_TRAP = 7,
+  TILE_BOSS = 8,
+  TILE_ENTRANCE = 9
+};
@@ -0,0 +1,63 @@
+#include <globals.h>
+#include "rpg_timeline.h"
+#if OTA_APP
+
+static constexpr const char* TAG = "RPG_TIMELINE";
+
+Timeline& TIMELINE() {
+  static Timeline instance;
+  return instance;
+}
+
+Timeline::Event* Timeline::push(uint16_t waitMs) {
+  if (count >= TIMELINE_SLOTS) {
+    ESP_LOGW(TAG, "Timeline full, event dropped");
+    return nullptr;
+  }
+  if (count == 0) mark = millis();
+  Event& e = events[(head + count) % TIMELINE_SLOTS];
+  count++;
+  e.wait = waitMs;
+  e.fn = nullptr;
+  e.msg[0] = 0;
+  return &e;
+}
+
+bool Timeline::say(uint16_t waitMs, const char* msg) {
+  Event* e = push(waitMs);
+  if (!e) return false;
+  strncpy(e->msg, msg, TIMELINE_MSG_LEN - 1);
+  e->msg[TIMELINE_MSG_LEN - 1] = 0;
+  return true;
+}
+
+bool Timeline::after(uint16_t waitMs, Action fn) {
+  Event* e = push(waitMs);
+  if (!e) return false;
+  e->fn = fn;
+  return true;
+}
+
+void Timeline::fire() {
+  // Pop first: the action may queue follow-up events
+  Event e = events[head];
+  head = (head + 1) % TIMELINE_SLOTS;
+  count--;
+  if (e.fn) e.fn();
+  else if (show) show(e.msg);
+}
+
+void Timeline::update(unsigned long now) {
+  while (count > 0 && now - mark >= events[head].wait) {
+    mark = now;
+    fire();
+  }
+}
+
+void Timeline::skip() {
+  if (count == 0) return;
+  mark = millis();
+  fire();
+}
+
+#endif
@@ -0,0 +1,47 @@
+#pragma once
+#include <Arduino.h>
+
+// ===================== TIMELINE =====================
+// Timed feedback without blocking the input loop. Events are queued in order;
+// each fires waitMs after the one before it (or after it was queued, if the
+// timeline was idle) and either shows an OLED message or runs a deferred
+// action such as the enemy's turn or a state change. update() is polled from
+// the keyboard loop, so music and the OS keep running in the gaps, and skip()
+// lets a key press fire the next event at once.
+
+#define TIMELINE_SLOTS    8
+#define TIMELINE_MSG_LEN  40
+
+class Timeline {
+public:
+  typedef void (*Action)();
+  typedef void (*MessageSink)(const char* msg);
+
+  void begin(MessageSink sink) { show = sink; clear(); }
+
+  // False (and nothing queued) if the timeline is full
+  bool say(uint16_t waitMs, const char* msg);
+  bool after(uint16_t waitMs, Action fn);
+
+  void update(unsigned long now);
+  void skip();
+  void clear() { count = 0; }
+  bool busy() const { return count > 0; }
+
+private:
+  struct Event {
+    uint16_t wait;
+    Action   fn;                      // null for a message
+    char     msg[TIMELINE_MSG_LEN];
+  };
+
+  Event         events[TIMELINE_SLOTS];
+  uint8_t       head = 0, count = 0;
+  unsigned long mark = 0;             // when the last event fired
+  MessageSink   show = nullptr;
+
+  Event* push(uint16_t waitMs);
+  void fire();
+};
+
+Timeline& TIMELINE();
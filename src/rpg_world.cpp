@@ -0,0 +1,127 @@
+#include <globals.h>
+#include "rpg_world.h"
+#if OTA_APP
+
+static constexpr const char* TAG = "RPG_WORLD";
+
+static const char WORLD_FLAG_KEYS[WORLD_FLAG_KINDS] = { 'c', 't', 'b', 's' };
+
+WorldState& WORLD() {
+  static WorldState instance;
+  return instance;
+}
+
+int WorldState::find(uint32_t key) const {
+  if (cached >= 0 && cached < (int)floors.size() && floors[cached].key == key) return cached;
+
+  int lo = 0, hi = (int)floors.size();
+  while (lo < hi) {
+    int mid = (lo + hi) / 2;
+    if (floors[mid].key < key) lo = mid + 1;
+    else hi = mid;
+  }
+  if (lo < (int)floors.size() && floors[lo].key == key) {
+    cached = lo;
+    return lo;
+  }
+  return -1;
+}
+
+WorldState::FloorFlags& WorldState::get(uint32_t key) {
+  int i = find(key);
+  if (i >= 0) return floors[i];
+
+  auto it = floors.begin();
+  while (it != floors.end() && it->key < key) ++it;
+  it = floors.insert(it, FloorFlags());
+  it->key = key;
+  cached = it - floors.begin();
+  return *it;
+}
+
+bool WorldState::test(WorldFlag kind, uint16_t dungeon, uint16_t floor, uint16_t tile) const {
+  int i = find(keyOf(dungeon, floor));
+  if (i < 0) return false;
+  const std::vector<uint32_t>& bits = floors[i].bits[kind];
+  size_t word = tile >> 5;
+  return word < bits.size() && ((bits[word] >> (tile & 31)) & 1);
+}
+
+void WorldState::set(WorldFlag kind, uint16_t dungeon, uint16_t floor, uint16_t tile) {
+  std::vector<uint32_t>& bits = get(keyOf(dungeon, floor)).bits[kind];
+  size_t word = tile >> 5;
+  if (word >= bits.size()) bits.resize(word + 1, 0);
+  bits[word] |= 1UL << (tile & 31);
+}
+
+void WorldState::clear() {
+  floors.clear();
+  cached = -1;
+}
+
+void WorldState::save(Print& out) const {
+  for (const FloorFlags& f : floors) {
+    for (int k = 0; k < WORLD_FLAG_KINDS; k++) {
+      const std::vector<uint32_t>& bits = f.bits[k];
+      const uint32_t total = bits.size() * 32;
+      auto isSet = [&](uint32_t t) { return t < total && ((bits[t >> 5] >> (t & 31)) & 1); };
+      bool first = true;
+      for (uint32_t t = 0; t < total; t++) {
+        if (!isSet(t)) {
+          // Skip clear words whole
+          if ((t & 31) == 0 && bits[t >> 5] == 0) t += 31;
+          continue;
+        }
+        uint32_t runEnd = t;
+        while (isSet(runEnd + 1)) runEnd++;
+        if (first) {
+          out.printf("%c%u.%u=", WORLD_FLAG_KEYS[k], (unsigned)(f.key >> 16), (unsigned)(f.key & 0xFFFF));
+          first = false;
+        } else {
+          out.print(',');
+        }
+        out.print((unsigned)t);
+        if (runEnd > t) {
+          out.print('-');
+          out.print((unsigned)runEnd);
+        }
+        t = runEnd;
+      }
+      if (!first) out.println();
+    }
+  }
+}
+
+bool WorldState::parse(const String& line) {
+  if (line.length() < 4) return false;
+  int kind = -1;
+  for (int k = 0; k < WORLD_FLAG_KINDS; k++) {
+    if (line[0] == WORLD_FLAG_KEYS[k]) kind = k;
+  }
+  int dot = line.indexOf('.');
+  int eq = line.indexOf('=');
+  if (kind < 0 || dot < 2 || eq < dot + 2) {
+    ESP_LOGW(TAG, "Bad world line: %s", line.c_str());
+    return false;
+  }
+
+  uint16_t dungeon = line.substring(1, dot).toInt();
+  uint16_t floor = line.substring(dot + 1, eq).toInt();
+  const char* p = line.c_str() + eq + 1;
+  while (*p) {
+    char* end;
+    unsigned long first = strtoul(p, &end, 10);
+    if (end == p) break;
+    unsigned long last = first;
+    if (*end == '-') {
+      p = end + 1;
+      last = strtoul(p, &end, 10);
+      if (end == p) break;
+    }
+    for (unsigned long t = first; t <= last && t <= UINT16_MAX; t++) set((WorldFlag)kind, dungeon, floor, t);
+    p = (*end == ',') ? end + 1 : end;
+  }
+  return true;
+}
+
+#endif
@@ -0,0 +1,53 @@
+#pragma once
+#include <Arduino.h>
+#include <vector>
+
+// ===================== WORLD STATE =====================
+// Persistent per-floor state for Mage's Descent: opened chests, sprung traps,
+// defeated bosses and explored tiles. Each (dungeon, floor) that has been
+// touched gets one bitset per kind, addressed by tile index (y * map width +
+// x), so a test or set is a shift and a mask once the floor is found; the
+// last floor looked up is cached, which makes that O(1) for every step on the
+// current floor.
+// Floors nobody has touched cost nothing, and bitsets only grow to the
+// highest tile set, so the store scales to any number of floors without
+// growing the save header or Player.
+//
+// In the save each floor and kind is one line listing its set tiles, with
+// runs of neighbours as ranges:
+//   c1.3=5,40        chests 5 and 40 on dungeon 1, floor 3 are open
+//   s1.3=17-30,33    tiles 17 to 30 and 33 have been seen
+
+enum WorldFlag : uint8_t {
+  WORLD_CHEST = 0,    // chest opened
+  WORLD_TRAP  = 1,    // trap sprung, now plain floor
+  WORLD_BOSS  = 2,    // boss defeated
+  WORLD_SEEN  = 3,    // explored (fog of war lifted)
+  WORLD_FLAG_KINDS
+};
+
+class WorldState {
+public:
+  bool test(WorldFlag kind, uint16_t dungeon, uint16_t floor, uint16_t tile) const;
+  void set(WorldFlag kind, uint16_t dungeon, uint16_t floor, uint16_t tile);
+  void clear();
+
+  // Write the [WORLD] section body / read back one of its lines
+  void save(Print& out) const;
+  bool parse(const String& line);
+
+private:
+  struct FloorFlags {
+    uint32_t key;                               // dungeon << 16 | floor
+    std::vector<uint32_t> bits[WORLD_FLAG_KINDS];
+  };
+
+  std::vector<FloorFlags> floors;   // sorted by key
+  mutable int cached = -1;          // index of the last floor found
+
+  static uint32_t keyOf(uint16_t dungeon, uint16_t floor) { return ((uint32_t)dungeon << 16) | floor; }
+  int find(uint32_t key) const;
+  FloorFlags& get(uint32_t key);
+};
+
+WorldState& WORLD();
@@ -0,0 +1,158 @@
+#include <globals.h>
+#include "esp_heap_caps.h"
+#include "spell_check.h"
+#include "io_session.h"
+#if !OTA_APP // POCKETMAGE_OS
+
+static constexpr const char* TAG = "SPELL";
+
+#define SPELL_MAGIC    0x46424D50  // "PMBF"
+#define SPELL_VERSION  1
+#define SPELL_MAX_WORD 31
+
+struct SpellHeader {
+  uint32_t magic;
+  uint16_t version;
+  uint8_t  k;
+  uint8_t  reserved;
+  uint32_t mBits;
+  uint32_t nWords;
+} __attribute__((packed));
+
+SpellChecker& SPELL() {
+  static SpellChecker instance;
+  return instance;
+}
+
+// Same hashes as create_spell_bloom.py
+static uint32_t fnv1a(const char* s, size_t len) {
+  uint32_t h = 2166136261u;
+  for (size_t i = 0; i < len; i++) {
+    h ^= (uint8_t)s[i];
+    h *= 16777619u;
+  }
+  return h;
+}
+
+static uint32_t fmix32(uint32_t h) {
+  h ^= h >> 16;
+  h *= 0x85EBCA6Bu;
+  h ^= h >> 13;
+  h *= 0xC2B2AE35u;
+  h ^= h >> 16;
+  return h;
+}
+
+bool SpellChecker::begin() {
+  if (bits || tried) return ready();
+  tried = true;
+
+  IoSession io;
+  File f = SD_MMC.open(SPELL_BLOOM_PATH, FILE_READ);
+  if (!f) {
+    ESP_LOGI(TAG, "%s not installed, spell check off", SPELL_BLOOM_PATH);
+    return false;
+  }
+
+  SpellHeader hdr;
+  if (f.read((uint8_t*)&hdr, sizeof(hdr)) != sizeof(hdr) || hdr.magic != SPELL_MAGIC ||
+      hdr.version != SPELL_VERSION || hdr.k == 0 || hdr.mBits == 0 ||
+      f.size() - sizeof(hdr) != hdr.mBits / 8) {
+    ESP_LOGE(TAG, "Invalid %s", SPELL_BLOOM_PATH);
+    f.close();
+    return false;
+  }
+
+  size_t bytes = hdr.mBits / 8;
+  uint8_t* buf = nullptr;
+  if (psramFound()) buf = (uint8_t*)heap_caps_malloc(bytes, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+  if (!buf) {
+    ESP_LOGW(TAG, "No PSRAM for %u byte filter, spell check off", (unsigned)bytes);
+    f.close();
+    return false;
+  }
+
+  bool ok = f.read(buf, bytes) == bytes;
+  f.close();
+  if (!ok) {
+    heap_caps_free(buf);
+    return false;
+  }
+
+  bits = buf;
+  mBits = hdr.mBits;
+  k = hdr.k;
+  ESP_LOGI(TAG, "Loaded %lu words (%u KB)", (unsigned long)hdr.nWords, (unsigned)(bytes / 1024));
+  return true;
+}
+
+bool SpellChecker::contains(const char* word, size_t len) const {
+  if (len < 2) return false;
+  uint32_t h1 = fnv1a(word, len);
+  uint32_t h2 = fmix32(h1) | 1;
+  for (uint8_t i = 0; i < k; i++) {
+    uint32_t bit = (h1 + i * h2) % mBits;
+    if (!(bits[bit >> 3] & (1 << (bit & 7)))) return false;
+  }
+  return true;
+}
+
+bool SpellChecker::stem(const char* w, size_t len, size_t strip, const char* add) const {
+  if (len <= strip + 1) return false;
+  char buf[SPELL_MAX_WORD + 2];
+  size_t n = len - strip;
+  memcpy(buf, w, n);
+  size_t addLen = strlen(add);
+  memcpy(buf + n, add, addLen);
+  return contains(buf, n + addLen);
+}
+
+static bool endsWith(const char* w, size_t len, const char* suffix) {
+  size_t sl = strlen(suffix);
+  return len > sl && memcmp(w + len - sl, suffix, sl) == 0;
+}
+
+bool SpellChecker::known(const String& word) {
+  if (!bits) return true;
+
+  // Trim punctuation and markdown around the word
+  int start = 0, end = word.length();
+  while (start < end && !isalpha((uint8_t)word[start])) start++;
+  while (end > start && !isalpha((uint8_t)word[end - 1])) end--;
+  size_t len = end - start;
+  if (len < 2 || len > SPELL_MAX_WORD) return true;
+
+  char w[SPELL_MAX_WORD + 1];
+  for (size_t i = 0; i < len; i++) {
+    uint8_t c = word[start + i];
+    if (!isalpha(c) && c != '\'') return true;   // numbers, URLs, symbols
+    w[i] = tolower(c);
+  }
+  w[len] = '\0';
+
+  if (contains(w, len)) return true;
+
+  // Inflections the dictionary lists only by their stem
+  if (endsWith(w, len, "'s"))   return stem(w, len, 2, "");
+  if (endsWith(w, len, "ies"))  return stem(w, len, 3, "y");
+  if (endsWith(w, len, "ied"))  return stem(w, len, 3, "y");
+  if (endsWith(w, len, "ily"))  return stem(w, len, 3, "y");
+  if (endsWith(w, len, "es") && stem(w, len, 2, "")) return true;
+  if (endsWith(w, len, "s") && !endsWith(w, len, "ss")) return stem(w, len, 1, "");
+  if (endsWith(w, len, "ing") || endsWith(w, len, "ed") || endsWith(w, len, "er") ||
+      endsWith(w, len, "est")) {
+    size_t strip = endsWith(w, len, "ing") || endsWith(w, len, "est") ? 3 : 2;
+    if (stem(w, len, strip, "") || stem(w, len, strip, "e")) return true;
+    // Doubled consonant: stopped -> stop
+    if (len > strip + 2 && w[len - strip - 1] == w[len - strip - 2]) {
+      return stem(w, len, strip + 1, "");
+    }
+    return false;
+  }
+  if (endsWith(w, len, "ly"))   return stem(w, len, 2, "");
+  if (endsWith(w, len, "ness")) return stem(w, len, 4, "");
+  if (endsWith(w, len, "ment")) return stem(w, len, 4, "");
+  return false;
+}
+
+#endif
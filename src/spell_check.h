@@ -0,0 +1,37 @@
+#pragma once
+#include <Arduino.h>
+
+// ===================== SPELL CHECK =====================
+// Bloom filter of the LEXICON headwords, built on the host by
+// create_spell_bloom.py and stored as /dict/spell.bloom. The filter (~10 bits
+// per word) is loaded once into PSRAM; a lookup is K bit probes, plus a few
+// more for common inflections (plural, -ed, -ing, ...) that a dictionary does
+// not list as headwords.
+//
+// A Bloom filter has no false negatives for dictionary words, and about 1%
+// of misspellings will slip through as "known".
+
+#define SPELL_BLOOM_PATH "/dict/spell.bloom"
+
+class SpellChecker {
+public:
+  // Load the filter if present; cheap to call again
+  bool begin();
+  bool ready() const { return bits != nullptr; }
+
+  // True for dictionary words and for anything that is not a plain word
+  // (numbers, symbols, single letters). Surrounding punctuation is ignored.
+  bool known(const String& word);
+
+private:
+  uint8_t* bits = nullptr;
+  uint32_t mBits = 0;
+  uint8_t  k = 0;
+  bool     tried = false;
+
+  bool contains(const char* word, size_t len) const;
+  // Replace the last strip characters of w with add and look that up
+  bool stem(const char* w, size_t len, size_t strip, const char* add) const;
+};
+
+SpellChecker& SPELL();
@@ -0,0 +1,90 @@
+#include <globals.h>
+#include "sys_tables.h"
+#if !OTA_APP // POCKETMAGE_OS
+
+// ===================== TASKS =====================
+
+static bool taskBefore(const void* a, const void* b) {
+  return ((const TaskRecord*)a)->due < ((const TaskRecord*)b)->due;
+}
+
+// name|YYYYMMDD|priority|completed
+static void importTaskLine(RecordTable& table, const String& line) {
+  int d1 = line.indexOf('|');
+  int d2 = line.indexOf('|', d1 + 1);
+  int d3 = line.indexOf('|', d2 + 1);
+  if (d1 < 0 || d2 < 0 || d3 < 0) return;
+
+  TaskRecord rec = {};
+  setField(rec.name, line.substring(0, d1));
+  rec.due       = line.substring(d1 + 1, d2).toInt();
+  rec.priority  = line.substring(d2 + 1, d3).toInt();
+  rec.completed = line.substring(d3 + 1).toInt();
+  table.add(&rec);
+}
+
+static const RecordSchema TASK_SCHEMA = {
+  "/sys/tasks.bin", "/sys/tasks.tmp", 0x53544D50 /* "PMTS" */, sizeof(TaskRecord),
+  taskBefore, "/sys/tasks.txt", importTaskLine
+};
+
+Table<TaskRecord>& TASKSTORE() {
+  static Table<TaskRecord> instance(TASK_SCHEMA);
+  return instance;
+}
+
+// ===================== EVENTS =====================
+
+static bool eventBefore(const void* a, const void* b) {
+  return strcmp(((const EventRecord*)a)->date, ((const EventRecord*)b)->date) < 0;
+}
+
+// name|YYYYMMDD|HH:MM|H:MM|repeat|note
+static void importEventLine(RecordTable& table, const String& line) {
+  int d1 = line.indexOf('|');
+  int d2 = line.indexOf('|', d1 + 1);
+  int d3 = line.indexOf('|', d2 + 1);
+  int d4 = line.indexOf('|', d3 + 1);
+  int d5 = line.indexOf('|', d4 + 1);
+  if (d1 < 0 || d2 < 0 || d3 < 0 || d4 < 0 || d5 < 0) return;
+
+  EventRecord rec = {};
+  setField(rec.name,     line.substring(0, d1));
+  setField(rec.date,     line.substring(d1 + 1, d2));
+  setField(rec.time,     line.substring(d2 + 1, d3));
+  setField(rec.duration, line.substring(d3 + 1, d4));
+  setField(rec.repeat,   line.substring(d4 + 1, d5));
+  setField(rec.note,     line.substring(d5 + 1));
+  table.add(&rec);
+}
+
+static const RecordSchema EVENT_SCHEMA = {
+  "/sys/events.bin", "/sys/events.tmp", 0x45564D50 /* "PMVE" */, sizeof(EventRecord),
+  eventBefore, "/sys/events.txt", importEventLine
+};
+
+Table<EventRecord>& EVENTSTORE() {
+  static Table<EventRecord> instance(EVENT_SCHEMA);
+  return instance;
+}
+
+// ===================== POMODORO =====================
+
+static void importPomodoroLine(RecordTable& table, const String& line) {
+  if (table.size() > 0) return;
+  PomodoroRecord rec = {};
+  rec.completed = line.toInt();
+  table.add(&rec);
+}
+
+static const RecordSchema POMODORO_SCHEMA = {
+  "/sys/pomodoro.bin", "/sys/pomodoro.tmp", 0x4F504D50 /* "PMPO" */, sizeof(PomodoroRecord),
+  nullptr, "/sys/pomodoro.txt", importPomodoroLine
+};
+
+Table<PomodoroRecord>& POMODOROSTORE() {
+  static Table<PomodoroRecord> instance(POMODORO_SCHEMA);
+  return instance;
+}
+
+#endif
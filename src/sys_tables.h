@@ -0,0 +1,45 @@
+#pragma once
+#include "record_store.h"
+
+// ===================== SYSTEM TABLES =====================
+// Typed schemas for the OS data files kept in the record store. The old text
+// files (/sys/tasks.txt, /sys/events.txt, /sys/pomodoro.txt) are imported on
+// first use and kept as *.bak.
+
+#define TASK_NAME_LEN 48
+
+struct TaskRecord {
+  uint16_t id;               // 0 = free slot
+  uint8_t  priority;
+  uint8_t  completed;
+  uint32_t due;              // YYYYMMDD
+  char     name[TASK_NAME_LEN];
+};
+
+// Event fields keep the exact strings the calendar edits and matches on
+struct EventRecord {
+  uint16_t id;
+  char     date[10];         // YYYYMMDD
+  char     time[6];          // HH:MM
+  char     duration[8];      // H:MM
+  char     repeat[24];       // NO, DAILY, WEEKLY MOWEFR, MONTHLY 2Tu, YEARLY Apr22
+  char     name[40];
+  char     note[96];
+};
+
+struct PomodoroRecord {
+  uint16_t id;
+  uint16_t reserved;
+  uint32_t completed;        // work sessions finished, all time
+};
+
+// Copy a String into a fixed record field, always NUL-terminated
+template <size_t N>
+inline void setField(char (&dst)[N], const String& src) {
+  strncpy(dst, src.c_str(), N - 1);
+  dst[N - 1] = 0;
+}
+
+Table<TaskRecord>& TASKSTORE();         // sorted by (due, id)
+Table<EventRecord>& EVENTSTORE();       // sorted by (date, id)
+Table<PomodoroRecord>& POMODOROSTORE(); // single row
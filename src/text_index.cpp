@@ -0,0 +1,635 @@
+#include <globals.h>
+#include "text_index.h"
+#include "file_index.h"
+#include "io_session.h"
+#include <esp_rom_crc.h>
+#include <math.h>
+#if !OTA_APP // POCKETMAGE_OS
+
+static constexpr const char* TAG = "SEARCH";
+
+#define SEARCH_DOCS_MAGIC   0x58534D50  // "PMSX"
+#define SEARCH_DOCS_VERSION 1
+#define SEARCH_BLOCK_TAG    0x5053      // "SP"
+
+// Folders that hold data rather than writing
+static const char* const SEARCH_SKIP[] = { "/sys/", "/dict/", "/apps/" };
+
+struct SearchDocsHeader {
+  uint32_t magic;
+  uint16_t version;
+  uint16_t reserved;
+  uint32_t count;
+  uint32_t nextGen;
+  uint32_t bytes;
+  uint32_t crc;
+};
+
+struct SearchBlock {
+  uint16_t tag;
+  uint16_t reserved;
+  uint32_t len;
+  uint32_t crc;
+};
+
+TextIndex& TEXTINDEX() {
+  static TextIndex instance;
+  return instance;
+}
+
+// ===================== ENCODING =====================
+
+static uint32_t termHash(const char* s, size_t len) {
+  uint32_t h = 2166136261u;  // FNV-1a
+  for (size_t i = 0; i < len; i++) {
+    h ^= (uint8_t)s[i];
+    h *= 16777619u;
+  }
+  return h;
+}
+
+static bool isTokenChar(uint8_t c) {
+  return isalnum(c) || c >= 0x80;
+}
+
+static void putVarint(std::vector<uint8_t>& out, uint32_t v) {
+  while (v >= 0x80) {
+    out.push_back((uint8_t)(v | 0x80));
+    v >>= 7;
+  }
+  out.push_back((uint8_t)v);
+}
+
+static bool getVarint(const uint8_t*& p, const uint8_t* end, uint32_t& v) {
+  v = 0;
+  for (int shift = 0; shift < 35; shift += 7) {
+    if (p >= end) return false;
+    uint8_t b = *p++;
+    v |= (uint32_t)(b & 0x7F) << shift;
+    if (!(b & 0x80)) return true;
+  }
+  return false;
+}
+
+// One posting record. lines points at the delta-coded offsets.
+struct Posting {
+  uint32_t hash;
+  uint32_t doc;
+  uint32_t gen;
+  uint32_t tf;
+  uint32_t count;
+  const uint8_t* lines;
+};
+
+static bool readPosting(const uint8_t*& p, const uint8_t* end, Posting& rec) {
+  if (end - p < 4) return false;
+  memcpy(&rec.hash, p, 4);
+  p += 4;
+  if (!getVarint(p, end, rec.doc) || !getVarint(p, end, rec.gen) ||
+      !getVarint(p, end, rec.tf) || !getVarint(p, end, rec.count)) return false;
+  rec.lines = p;
+  uint32_t skip;
+  for (uint32_t i = 0; i < rec.count; i++) {
+    if (!getVarint(p, end, skip)) return false;
+  }
+  return true;
+}
+
+static String bucketPath(uint8_t bucket) {
+  char buf[32];
+  snprintf(buf, sizeof(buf), SEARCH_DIR "/b%02u.bin", (unsigned)bucket);
+  return String(buf);
+}
+
+// Splits text into lowercase term hashes, dropping repeats
+static void queryTerms(const String& query, std::vector<uint32_t>& out) {
+  char token[SEARCH_MAX_TERM];
+  size_t len = 0;
+  for (size_t i = 0; i <= query.length(); i++) {
+    uint8_t c = i < query.length() ? query[i] : ' ';
+    if (isTokenChar(c)) {
+      if (len < SEARCH_MAX_TERM) token[len++] = tolower(c);
+      continue;
+    }
+    if (len >= SEARCH_MIN_TERM) {
+      uint32_t h = termHash(token, len);
+      if (std::find(out.begin(), out.end(), h) == out.end()) out.push_back(h);
+    }
+    len = 0;
+  }
+}
+
+// ===================== FILE TABLE =====================
+
+bool TextIndex::indexable(const String& path) const {
+  if (!path.endsWith(".txt") && !path.endsWith(".TXT")) return false;
+  for (const char* skip : SEARCH_SKIP) {
+    if (path.startsWith(skip)) return false;
+  }
+  return true;
+}
+
+int TextIndex::docFor(const String& path, bool create) {
+  auto it = docIds.find(path);
+  if (it != docIds.end()) return it->second;
+  if (!create) return -1;
+
+  size_t id = 0;
+  while (id < docs.size() && docs[id].path.length()) id++;
+  if (id == docs.size()) {
+    if (docs.size() >= 0xFFFF) return -1;
+    docs.emplace_back();
+  }
+  docs[id].path = path;
+  docs[id].live = false;
+  docIds[path] = id;
+  return id;
+}
+
+void TextIndex::load() {
+  loaded = true;
+  IoSession io;
+
+  File f = SD_MMC.open(SEARCH_DOCS_PATH, FILE_READ);
+  if (!f) {
+    for (uint8_t b = 0; b < SEARCH_BUCKETS; b++) SD_MMC.remove(bucketPath(b));
+    return;
+  }
+
+  SearchDocsHeader hdr;
+  bool ok = f.read((uint8_t*)&hdr, sizeof(hdr)) == sizeof(hdr) &&
+            hdr.magic == SEARCH_DOCS_MAGIC && hdr.version == SEARCH_DOCS_VERSION &&
+            hdr.bytes == f.size() - sizeof(hdr);
+  std::vector<uint8_t> bytes;
+  if (ok) {
+    bytes.resize(hdr.bytes);
+    ok = f.read(bytes.data(), hdr.bytes) == hdr.bytes &&
+         esp_rom_crc32_le(0, bytes.data(), hdr.bytes) == hdr.crc;
+  }
+  f.close();
+  if (!ok) {
+    // Postings can't be trusted without their table; start over
+    ESP_LOGW(TAG, "File table invalid, reindexing everything");
+    for (uint8_t b = 0; b < SEARCH_BUCKETS; b++) SD_MMC.remove(bucketPath(b));
+    return;
+  }
+
+  // Postings flushed after this table was last written carry generations up
+  // to one batch beyond nextGen; skip past them so they can never look current
+  nextGen = hdr.nextGen + SEARCH_BATCH_FILES;
+
+  const uint8_t* p = bytes.data();
+  const uint8_t* end = p + bytes.size();
+  docs.resize(hdr.count);
+  for (uint32_t i = 0; i < hdr.count && end - p >= 14; i++) {
+    Doc& d = docs[i];
+    memcpy(&d.size, p, 4);
+    memcpy(&d.mtime, p + 4, 4);
+    memcpy(&d.gen, p + 8, 4);
+    d.live = p[12];
+    uint8_t len = p[13];
+    p += 14;
+    if (end - p < len) break;
+    d.path = "";
+    d.path.reserve(len);
+    for (uint8_t c = 0; c < len; c++) d.path += (char)p[c];
+    p += len;
+    if (d.path.length()) docIds[d.path] = i;
+  }
+  ESP_LOGI(TAG, "Loaded %u files", (unsigned)docs.size());
+}
+
+void TextIndex::saveDocs() {
+  std::vector<uint8_t> bytes;
+  for (auto& d : docs) {
+    uint8_t rec[14];
+    memcpy(rec, &d.size, 4);
+    memcpy(rec + 4, &d.mtime, 4);
+    memcpy(rec + 8, &d.gen, 4);
+    rec[12] = d.live;
+    rec[13] = d.path.length() > 255 ? 0 : d.path.length();
+    bytes.insert(bytes.end(), rec, rec + 14);
+    bytes.insert(bytes.end(), d.path.c_str(), d.path.c_str() + rec[13]);
+  }
+
+  SearchDocsHeader hdr = {};
+  hdr.magic = SEARCH_DOCS_MAGIC;
+  hdr.version = SEARCH_DOCS_VERSION;
+  hdr.count = docs.size();
+  hdr.nextGen = nextGen;
+  hdr.bytes = bytes.size();
+  hdr.crc = esp_rom_crc32_le(0, bytes.data(), bytes.size());
+
+  IoSession io;
+  File f = SD_MMC.open(SEARCH_DOCS_TMP, FILE_WRITE);
+  if (!f) {
+    ESP_LOGE(TAG, "Failed to open %s", SEARCH_DOCS_TMP);
+    return;
+  }
+  bool ok = f.write((const uint8_t*)&hdr, sizeof(hdr)) == sizeof(hdr) &&
+            f.write(bytes.data(), bytes.size()) == bytes.size();
+  f.close();
+  if (!ok) {
+    SD_MMC.remove(SEARCH_DOCS_TMP);
+    return;
+  }
+  SD_MMC.remove(SEARCH_DOCS_PATH);
+  SD_MMC.rename(SEARCH_DOCS_TMP, SEARCH_DOCS_PATH);
+  docsDirty = false;
+}
+
+// ===================== UPDATES =====================
+
+void TextIndex::fileChanged(const String& path) {
+  if (!indexable(path)) return;
+  if (curDoc >= 0 && docs[curDoc].path == path) {
+    // Restart: the rest of the old contents is no longer what's on the card
+    curFile.close();
+    curDoc = -1;
+    terms.clear();
+  }
+  auto it = std::find(queue.begin(), queue.end(), path);
+  if (it != queue.end()) queue.erase(it);
+  queue.push_front(path);
+}
+
+void TextIndex::fileRemoved(const String& path) {
+  int id = docFor(path, false);
+  if (id < 0) return;
+  if (curDoc == id) {
+    curFile.close();
+    curDoc = -1;
+    terms.clear();
+  }
+  auto it = std::find(queue.begin(), queue.end(), path);
+  if (it != queue.end()) queue.erase(it);
+
+  docIds.erase(path);
+  docs[id].path = "";
+  docs[id].live = false;
+  docsDirty = true;
+}
+
+void TextIndex::closeFiles() {
+  if (curDoc >= 0) {
+    curFile.close();
+    queue.push_front(docs[curDoc].path);
+    curDoc = -1;
+    terms.clear();
+  }
+  flushBatch();
+}
+
+// ===================== BACKGROUND INDEXING =====================
+
+// Queue every file that is new or changed since it was last indexed, and
+// retire files that no longer exist
+void TextIndex::scanSlice() {
+  unsigned long start = millis();
+  if (scanCursor == 0) seen.assign(docs.size(), 0);
+
+  IoSession io;
+  while (scanCursor < FILEINDEX().size()) {
+    if (millis() - start >= SEARCH_SLICE_MS) return;
+    String path = FILEINDEX().pathAt(scanCursor++);
+    if (!indexable(path)) continue;
+
+    int id = docFor(path, false);
+    if (id >= 0 && id < (int)seen.size()) seen[id] = 1;
+
+    File f = SD_MMC.open(path, FILE_READ);
+    if (!f) continue;
+    uint32_t size = f.size();
+    uint32_t mtime = f.getLastWrite();
+    f.close();
+
+    if (id < 0 || !docs[id].live || docs[id].size != size || docs[id].mtime != mtime) {
+      if (std::find(queue.begin(), queue.end(), path) == queue.end()) queue.push_back(path);
+    }
+  }
+
+  for (size_t i = 0; i < seen.size(); i++) {
+    if (!seen[i] && docs[i].path.length()) {
+      bool queued = std::find(queue.begin(), queue.end(), docs[i].path) != queue.end();
+      if (!queued) fileRemoved(docs[i].path);
+    }
+  }
+  seen.clear();
+  scanDone = true;
+  ESP_LOGI(TAG, "Scan done, %u files to index", (unsigned)queue.size());
+}
+
+void TextIndex::startDoc(const String& path) {
+  curDoc = docFor(path, true);
+  if (curDoc < 0) return;
+
+  curFile = SD_MMC.open(path, FILE_READ);
+  if (!curFile) {
+    fileRemoved(path);
+    curDoc = -1;
+    return;
+  }
+  curOffset = 0;
+  lineStart = 0;
+  tokenLen = 0;
+  terms.clear();
+}
+
+void TextIndex::endToken() {
+  if (tokenLen >= SEARCH_MIN_TERM) {
+    TermAcc& acc = terms[termHash(token, tokenLen)];
+    if (acc.tf < 0xFFFF) acc.tf++;
+    if ((acc.lines.empty() || acc.lines.back() != tokenLine) && acc.lines.size() < SEARCH_MAX_LINES) {
+      acc.lines.push_back(tokenLine);
+    }
+  }
+  tokenLen = 0;
+}
+
+void TextIndex::indexSlice() {
+  unsigned long start = millis();
+  IoSession io;
+
+  while (millis() - start < SEARCH_SLICE_MS) {
+    if (curDoc < 0) {
+      if (queue.empty()) return;
+      String path = queue.front();
+      queue.pop_front();
+      startDoc(path);
+      continue;
+    }
+
+    uint8_t buf[512];
+    size_t n = curOffset < SEARCH_MAX_FILE ? curFile.read(buf, sizeof(buf)) : 0;
+    if (n == 0) {
+      finishDoc();
+      continue;
+    }
+
+    for (size_t i = 0; i < n; i++) {
+      uint8_t c = buf[i];
+      if (isTokenChar(c)) {
+        if (tokenLen == 0) tokenLine = lineStart;
+        if (tokenLen < SEARCH_MAX_TERM) token[tokenLen++] = tolower(c);
+        continue;
+      }
+      endToken();
+      if (c == '\n') lineStart = curOffset + i + 1;
+    }
+    curOffset += n;
+  }
+}
+
+// Encode the file's terms into the pending buckets under a new generation
+void TextIndex::finishDoc() {
+  endToken();
+  Doc& d = docs[curDoc];
+  d.size = curFile.size();
+  d.mtime = curFile.getLastWrite();
+  curFile.close();
+
+  d.gen = ++nextGen;
+  d.live = true;
+  for (auto& t : terms) {
+    std::vector<uint8_t>& out = pending[t.first % SEARCH_BUCKETS];
+    size_t before = out.size();
+    out.insert(out.end(), (const uint8_t*)&t.first, (const uint8_t*)&t.first + 4);
+    putVarint(out, curDoc);
+    putVarint(out, d.gen);
+    putVarint(out, t.second.tf);
+    putVarint(out, t.second.lines.size());
+    uint32_t prev = 0;
+    for (uint32_t line : t.second.lines) {
+      putVarint(out, line - prev);
+      prev = line;
+    }
+    pendingBytes += out.size() - before;
+  }
+  terms.clear();
+  docsDirty = true;
+  reindexed++;
+  pendingFiles++;
+  curDoc = -1;
+
+  if (pendingBytes >= SEARCH_BATCH_BYTES || pendingFiles >= SEARCH_BATCH_FILES) flushBatch();
+}
+
+// Postings first, then the file table that makes them current. A crash in
+// between leaves postings whose generation nothing refers to.
+void TextIndex::flushBatch() {
+  if (pendingBytes == 0 && !docsDirty) return;
+  IoSession io;
+  SD_MMC.mkdir(SEARCH_DIR);
+
+  for (uint8_t b = 0; b < SEARCH_BUCKETS; b++) {
+    if (pending[b].empty()) continue;
+    SearchBlock blk = {};
+    blk.tag = SEARCH_BLOCK_TAG;
+    blk.len = pending[b].size();
+    blk.crc = esp_rom_crc32_le(0, pending[b].data(), pending[b].size());
+
+    File f = SD_MMC.open(bucketPath(b), FILE_APPEND);
+    if (!f) {
+      ESP_LOGE(TAG, "Failed to open bucket %u", (unsigned)b);
+      continue;
+    }
+    f.write((const uint8_t*)&blk, sizeof(blk));
+    f.write(pending[b].data(), pending[b].size());
+    f.close();
+    pending[b].clear();
+    pending[b].shrink_to_fit();
+  }
+  pendingBytes = 0;
+  pendingFiles = 0;
+  saveDocs();
+}
+
+// ===================== BUCKETS =====================
+
+// Concatenated payloads of all intact blocks. A torn or corrupt block ends the
+// read and marks the bucket for compaction.
+bool TextIndex::readBucket(uint8_t bucket, std::vector<uint8_t>& out) {
+  out.clear();
+  File f = SD_MMC.open(bucketPath(bucket), FILE_READ);
+  if (!f) return true;
+
+  bool intact = true;
+  SearchBlock blk;
+  while (f.available()) {
+    if (f.read((uint8_t*)&blk, sizeof(blk)) != sizeof(blk) || blk.tag != SEARCH_BLOCK_TAG ||
+        blk.len > f.size()) {
+      intact = false;
+      break;
+    }
+    size_t at = out.size();
+    out.resize(at + blk.len);
+    if (f.read(out.data() + at, blk.len) != blk.len ||
+        esp_rom_crc32_le(0, out.data() + at, blk.len) != blk.crc) {
+      out.resize(at);
+      intact = false;
+      break;
+    }
+  }
+  f.close();
+
+  if (!intact) tornBuckets |= 1ULL << bucket;
+  return intact;
+}
+
+// Rewrite a bucket with only its current postings, when enough are stale
+void TextIndex::compactBucket(uint8_t bucket) {
+  IoSession io;
+  std::vector<uint8_t> data;
+  bool intact = readBucket(bucket, data);
+
+  std::vector<uint8_t> live;
+  const uint8_t* p = data.data();
+  const uint8_t* end = p + data.size();
+  Posting rec;
+  while (p < end) {
+    const uint8_t* recStart = p;
+    if (!readPosting(p, end, rec)) break;
+    if (rec.doc < docs.size() && docs[rec.doc].live && docs[rec.doc].gen == rec.gen) {
+      live.insert(live.end(), recStart, p);
+    }
+  }
+
+  if (intact && live.size() * 3 >= data.size() * 2) return;
+
+  String path = bucketPath(bucket);
+  String tmp = path + ".tmp";
+  File f = SD_MMC.open(tmp, FILE_WRITE);
+  if (!f) return;
+  if (!live.empty()) {
+    SearchBlock blk = {};
+    blk.tag = SEARCH_BLOCK_TAG;
+    blk.len = live.size();
+    blk.crc = esp_rom_crc32_le(0, live.data(), live.size());
+    f.write((const uint8_t*)&blk, sizeof(blk));
+    f.write(live.data(), live.size());
+  }
+  f.close();
+  SD_MMC.remove(path);
+  SD_MMC.rename(tmp, path);
+  tornBuckets &= ~(1ULL << bucket);
+  ESP_LOGI(TAG, "Compacted bucket %u: %u -> %u bytes", (unsigned)bucket, (unsigned)data.size(), (unsigned)live.size());
+}
+
+void TextIndex::poll() {
+  if (mscEnabled || SD().getNoSD()) return;
+  if (!keyboardIdleFor(SEARCH_IDLE_MS) || IOSESSION().depth() > 0) return;
+  if (!loaded) {
+    load();
+    return;
+  }
+
+  // Reconcile after every completed walk of the card
+  if (FILEINDEX().walks() != scannedWalk && !FILEINDEX().walking()) {
+    scannedWalk = FILEINDEX().walks();
+    scanCursor = 0;
+    scanDone = false;
+  }
+  if (!scanDone && scannedWalk) {
+    scanSlice();
+    return;
+  }
+
+  if (curDoc >= 0 || !queue.empty()) {
+    indexSlice();
+    return;
+  }
+  if (pendingBytes || docsDirty) {
+    flushBatch();
+    return;
+  }
+
+  // Idle: one bucket per iteration once a pass is due
+  if (compactCursor >= SEARCH_BUCKETS && (reindexed - compactedAt >= SEARCH_COMPACT_EVERY || tornBuckets)) {
+    compactCursor = 0;
+    compactedAt = reindexed;
+  }
+  if (compactCursor < SEARCH_BUCKETS) compactBucket(compactCursor++);
+}
+
+// ===================== QUERY =====================
+
+size_t TextIndex::search(const String& query, std::vector<SearchHit>& hits) {
+  hits.clear();
+  std::vector<uint32_t> words;
+  queryTerms(query, words);
+  if (words.empty()) return 0;
+  if (!loaded) load();
+
+  IoSession io;
+  flushBatch();
+
+  uint32_t liveDocs = 0;
+  for (auto& d : docs) liveDocs += d.live;
+
+  struct Match {
+    float    score = 0;
+    uint8_t  terms = 0;
+    uint32_t line = 0;
+    uint32_t rarest = UINT32_MAX;   // document frequency of the word line came from
+  };
+  std::unordered_map<uint32_t, Match> matches;
+
+  std::vector<uint8_t> data;
+  for (size_t w = 0; w < words.size(); w++) {
+    readBucket(words[w] % SEARCH_BUCKETS, data);
+
+    // Current postings for this word: file id -> (tf, first line)
+    std::vector<std::pair<uint32_t, std::pair<uint32_t, uint32_t>>> found;
+    const uint8_t* p = data.data();
+    const uint8_t* end = p + data.size();
+    Posting rec;
+    while (p < end && readPosting(p, end, rec)) {
+      if (rec.hash != words[w] || rec.doc >= docs.size()) continue;
+      if (!docs[rec.doc].live || docs[rec.doc].gen != rec.gen) continue;
+      uint32_t first = 0;
+      const uint8_t* lp = rec.lines;
+      if (rec.count) getVarint(lp, end, first);
+      found.push_back({rec.doc, {rec.tf, first}});
+    }
+    if (found.empty()) return 0;
+
+    float idf = logf(1.0f + (float)liveDocs / found.size());
+    for (auto& f : found) {
+      Match& m = matches[f.first];
+      if (m.terms != w) continue;   // missed an earlier word
+      m.terms++;
+      m.score += (1.0f + logf((float)f.second.first)) * idf;
+      if (found.size() < m.rarest) {
+        m.rarest = found.size();
+        m.line = f.second.second;
+      }
+    }
+  }
+
+  std::vector<std::pair<uint32_t, Match>> ranked;
+  for (auto& m : matches) {
+    if (m.second.terms == words.size()) ranked.push_back(m);
+  }
+  std::sort(ranked.begin(), ranked.end(), [this](const std::pair<uint32_t, Match>& a, const std::pair<uint32_t, Match>& b) {
+    if (a.second.score != b.second.score) return a.second.score > b.second.score;
+    return docs[a.first].mtime > docs[b.first].mtime;
+  });
+  if (ranked.size() > SEARCH_MAX_HITS) ranked.resize(SEARCH_MAX_HITS);
+
+  for (auto& r : ranked) {
+    SearchHit hit;
+    hit.path = docs[r.first].path;
+    hit.score = r.second.score;
+    File f = SD_MMC.open(hit.path, FILE_READ);
+    if (f) {
+      f.seek(r.second.line);
+      hit.snippet = f.readStringUntil('\n');
+      hit.snippet.trim();
+      f.close();
+    }
+    hits.push_back(hit);
+  }
+  return hits.size();
+}
+
+#endif
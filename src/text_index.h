@@ -0,0 +1,125 @@
+#pragma once
+#include <Arduino.h>
+#include <deque>
+#include <map>
+#include <unordered_map>
+#include <vector>
+
+// ===================== FULL-TEXT INDEX =====================
+// Word search across journal entries and notes (.txt outside /sys, /dict and
+// /apps). Postings live on SD under /sys/search:
+//
+//   docs.bin   file table: path, size, mtime, generation
+//   bNN.bin    64 posting buckets, chosen by term hash. Append-only CRC'd
+//              blocks of records {term hash, file id, generation, count,
+//              delta-varint byte offsets of the lines the term occurs on}
+//
+// A query reads one bucket per term, so its cost does not grow with the
+// number of files. Reindexing a file bumps its generation, which retires its
+// old postings; buckets are compacted in the background once enough of them
+// are stale.
+//
+// Indexing runs from the main loop in short slices, only while the keyboard
+// is idle. It starts from the file name index (files that changed since the
+// last run) and from fileChanged() calls made by writers.
+
+#define SEARCH_DIR          "/sys/search"
+#define SEARCH_DOCS_PATH    SEARCH_DIR "/docs.bin"
+#define SEARCH_DOCS_TMP     SEARCH_DIR "/docs.tmp"
+#define SEARCH_BUCKETS      64
+#define SEARCH_SLICE_MS     8      // indexing budget per loop iteration
+#define SEARCH_IDLE_MS      1500   // keyboard quiet time before indexing resumes
+#define SEARCH_BATCH_BYTES  8192   // postings buffered before they are written
+#define SEARCH_BATCH_FILES  64     // ... or files indexed, whichever comes first
+#define SEARCH_MIN_TERM     2
+#define SEARCH_MAX_TERM     24     // longer words are indexed by their prefix
+#define SEARCH_MAX_LINES    64     // line offsets kept per term and file
+#define SEARCH_MAX_FILE     (512UL * 1024)  // bytes indexed per file
+#define SEARCH_COMPACT_EVERY 32    // reindexed files between compaction passes
+#define SEARCH_MAX_HITS     8
+
+struct SearchHit {
+  String path;
+  String snippet;   // first line containing the rarest query word
+  float  score;
+};
+
+class TextIndex {
+public:
+  // Call from the main loop
+  void poll();
+
+  void fileChanged(const String& path);
+  void fileRemoved(const String& path);
+  // Write buffered postings and close the file being indexed (before unmount)
+  void closeFiles();
+
+  // Files still waiting to be (re)indexed
+  bool busy() const { return !queue.empty() || curDoc >= 0 || !scanDone; }
+
+  // Ranked hits containing every word of query, best first
+  size_t search(const String& query, std::vector<SearchHit>& hits);
+
+private:
+  struct Doc {
+    String   path;      // "" for a free slot
+    uint32_t size = 0;
+    uint32_t mtime = 0;
+    uint32_t gen = 0;   // postings with another generation are stale
+    bool     live = false;
+  };
+
+  struct TermAcc {
+    uint16_t tf = 0;
+    std::vector<uint32_t> lines;
+  };
+
+  std::vector<Doc> docs;
+  std::map<String, uint16_t> docIds;
+  std::deque<String> queue;
+  bool loaded = false;
+  bool docsDirty = false;
+  uint32_t nextGen = 0;   // generations are never reused, see load()
+
+  // Reconciling against the file name index
+  uint32_t scannedWalk = 0;
+  size_t   scanCursor = 0;
+  bool     scanDone = false;
+  std::vector<uint8_t> seen;
+
+  // File being tokenized
+  int      curDoc = -1;
+  File     curFile;
+  uint32_t curOffset = 0;
+  uint32_t lineStart = 0;
+  uint32_t tokenLine = 0;
+  char     token[SEARCH_MAX_TERM + 1];
+  uint8_t  tokenLen = 0;
+  std::unordered_map<uint32_t, TermAcc> terms;
+
+  // Postings not yet on SD
+  std::vector<uint8_t> pending[SEARCH_BUCKETS];
+  size_t pendingBytes = 0;
+  uint8_t pendingFiles = 0;
+
+  // Background compaction
+  uint32_t reindexed = 0;
+  uint32_t compactedAt = 0;
+  uint8_t  compactCursor = SEARCH_BUCKETS;
+  uint64_t tornBuckets = 0;
+
+  bool   indexable(const String& path) const;
+  int    docFor(const String& path, bool create);
+  void   load();
+  void   saveDocs();
+  void   scanSlice();
+  void   startDoc(const String& path);
+  void   indexSlice();
+  void   endToken();
+  void   finishDoc();
+  void   flushBatch();
+  bool   readBucket(uint8_t bucket, std::vector<uint8_t>& out);
+  void   compactBucket(uint8_t bucket);
+};
+
+TextIndex& TEXTINDEX();
@@ -0,0 +1,46 @@
+#include <globals.h>
+#include "text_search.h"
+#if !OTA_APP // POCKETMAGE_OS
+
+static inline uint8_t fold(uint8_t c) {
+  return (c >= 'A' && c <= 'Z') ? c + ('a' - 'A') : c;
+}
+
+bool TextFinder::set(const String& pattern) {
+  // A cut pattern would match (and replace) text the user did not ask for
+  len = 0;
+  if (pattern.length() == 0 || pattern.length() > TEXT_SEARCH_MAX_PATTERN) return false;
+  len = pattern.length();
+
+  for (uint8_t i = 0; i < len; i++) pat[i] = fold(pattern[i]);
+
+  // Distance from the last occurrence of each character to the pattern end,
+  // both cases of a letter sharing one entry
+  memset(shift, len, sizeof(shift));
+  for (uint8_t i = 0; i + 1 < len; i++) {
+    uint8_t c = pat[i];
+    shift[c] = len - 1 - i;
+    if (c >= 'a' && c <= 'z') shift[c - ('a' - 'A')] = len - 1 - i;
+  }
+  return true;
+}
+
+int TextFinder::find(const char* text, size_t textLen, size_t from) const {
+  if (len == 0 || textLen < len) return -1;
+
+  const uint8_t* t = (const uint8_t*)text;
+  const uint8_t last = pat[len - 1];
+  size_t pos = from;
+  while (pos + len <= textLen) {
+    uint8_t c = t[pos + len - 1];
+    if (fold(c) == last) {
+      size_t i = 0;
+      while (i + 1 < len && fold(t[pos + i]) == (uint8_t)pat[i]) i++;
+      if (i + 1 == len) return (int)pos;
+    }
+    pos += shift[c];
+  }
+  return -1;
+}
+
+#endif
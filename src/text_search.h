@@ -0,0 +1,26 @@
+#pragma once
+#include <Arduino.h>
+
+// ===================== TEXT SEARCH =====================
+// Boyer-Moore-Horspool substring search, ignoring ASCII case. The pattern is
+// preprocessed once into a 256-entry shift table; a scan then compares the
+// last character of each window and skips ahead by up to the pattern length,
+// so longer patterns search faster. Runs over raw char buffers.
+
+#define TEXT_SEARCH_MAX_PATTERN 64
+
+class TextFinder {
+public:
+  // False (and no pattern) if empty or longer than TEXT_SEARCH_MAX_PATTERN
+  bool set(const String& pattern);
+  size_t length() const { return len; }
+
+  // Offset of the first match at or after from, -1 if none
+  int find(const char* text, size_t textLen, size_t from = 0) const;
+  int find(const String& text, size_t from = 0) const { return find(text.c_str(), text.length(), from); }
+
+private:
+  char    pat[TEXT_SEARCH_MAX_PATTERN];   // lowercase
+  uint8_t shift[256];
+  uint8_t len = 0;
+};
@@ -0,0 +1,174 @@
+#include <globals.h>
+#include "esp_heap_caps.h"
+#include "undo_ring.h"
+#if !OTA_APP // POCKETMAGE_OS
+
+static constexpr const char* TAG = "UNDO";
+
+#define UNDO_FLAG_JOINED 0x01
+
+struct UndoHeader {
+  uint8_t  kind;
+  uint8_t  flags;
+  uint8_t  oldStyle;
+  uint8_t  newStyle;
+  uint32_t para;
+  uint32_t offset;
+  uint16_t removedLen;
+  uint16_t insertedLen;
+} __attribute__((packed));
+
+// Record: header, removed text, inserted text, uint16_t total length
+static constexpr size_t UNDO_FOOTER = sizeof(uint16_t);
+
+UndoRing& UNDO() {
+  static UndoRing instance;
+  return instance;
+}
+
+bool UndoRing::alloc() {
+  if (buf) return true;
+  if (psramFound()) buf = (uint8_t*)heap_caps_malloc(UNDO_RING_BYTES, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+  if (!buf) buf = (uint8_t*)malloc(UNDO_RING_BYTES);
+  if (!buf) ESP_LOGE(TAG, "No memory for undo history");
+  return buf != nullptr;
+}
+
+void UndoRing::put(size_t pos, const void* src, size_t n) {
+  const uint8_t* s = (const uint8_t*)src;
+  size_t first = min(n, (size_t)(UNDO_RING_BYTES - pos));
+  memcpy(buf + pos, s, first);
+  memcpy(buf, s + first, n - first);
+}
+
+void UndoRing::get(size_t pos, void* dst, size_t n) const {
+  uint8_t* d = (uint8_t*)dst;
+  size_t first = min(n, (size_t)(UNDO_RING_BYTES - pos));
+  memcpy(d, buf + pos, first);
+  memcpy(d + first, buf, n - first);
+}
+
+static inline size_t wrap(size_t pos) {
+  return pos % UNDO_RING_BYTES;
+}
+
+size_t UndoRing::recordLen(size_t start) const {
+  UndoHeader h;
+  get(start, &h, sizeof(h));
+  return sizeof(h) + h.removedLen + h.insertedLen + UNDO_FOOTER;
+}
+
+size_t UndoRing::lenBefore(size_t end) const {
+  uint16_t len;
+  get(wrap(end + UNDO_RING_BYTES - UNDO_FOOTER), &len, sizeof(len));
+  return len;
+}
+
+void UndoRing::decode(size_t start, EditDelta& out) const {
+  UndoHeader h;
+  get(start, &h, sizeof(h));
+  out.kind = h.kind;
+  out.joined = h.flags & UNDO_FLAG_JOINED;
+  out.para = h.para;
+  out.offset = h.offset;
+  out.oldStyle = (char)h.oldStyle;
+  out.newStyle = (char)h.newStyle;
+
+  char tmp[64];
+  size_t pos = wrap(start + sizeof(h));
+  String* parts[2] = { &out.removed, &out.inserted };
+  uint16_t lens[2] = { h.removedLen, h.insertedLen };
+  for (int p = 0; p < 2; p++) {
+    *parts[p] = "";
+    parts[p]->reserve(lens[p]);
+    for (uint16_t done = 0; done < lens[p];) {
+      uint16_t n = min((uint16_t)(lens[p] - done), (uint16_t)sizeof(tmp));
+      get(pos, tmp, n);
+      parts[p]->concat(tmp, n);
+      pos = wrap(pos + n);
+      done += n;
+    }
+  }
+}
+
+void UndoRing::dropOldest() {
+  size_t len = recordLen(tail);
+  tail = wrap(tail + len);
+  used -= len;
+  undoCount--;
+}
+
+void UndoRing::push(const EditDelta& d) {
+  if (!alloc()) return;
+
+  size_t len = sizeof(UndoHeader) + d.removed.length() + d.inserted.length() + UNDO_FOOTER;
+  if (len > UNDO_RING_BYTES / 2 || d.removed.length() > UINT16_MAX || d.inserted.length() > UINT16_MAX) {
+    // Too large to keep; older steps would no longer line up with the text
+    ESP_LOGW(TAG, "Edit of %u bytes too large, history cleared", (unsigned)len);
+    clear();
+    return;
+  }
+
+  // A new edit ends the redo branch
+  used -= (head + UNDO_RING_BYTES - cursor) % UNDO_RING_BYTES;
+  head = cursor;
+  redoCount = 0;
+
+  while (undoCount > 0 && used + len > UNDO_RING_BYTES) dropOldest();
+  if (undoCount == 0) {
+    tail = head;
+    used = 0;
+  }
+
+  UndoHeader h = { d.kind, (uint8_t)(d.joined ? UNDO_FLAG_JOINED : 0), (uint8_t)d.oldStyle,
+                   (uint8_t)d.newStyle, d.para, d.offset, (uint16_t)d.removed.length(),
+                   (uint16_t)d.inserted.length() };
+  size_t pos = head;
+  put(pos, &h, sizeof(h));
+  pos = wrap(pos + sizeof(h));
+  put(pos, d.removed.c_str(), d.removed.length());
+  pos = wrap(pos + d.removed.length());
+  put(pos, d.inserted.c_str(), d.inserted.length());
+  pos = wrap(pos + d.inserted.length());
+  uint16_t total = len;
+  put(pos, &total, sizeof(total));
+
+  head = wrap(head + len);
+  cursor = head;
+  used += len;
+  undoCount++;
+}
+
+bool UndoRing::undo(EditDelta& out) {
+  if (!buf || undoCount == 0) return false;
+  size_t len = lenBefore(cursor);
+  cursor = wrap(cursor + UNDO_RING_BYTES - len);
+  decode(cursor, out);
+  undoCount--;
+  redoCount++;
+  return true;
+}
+
+bool UndoRing::redo(EditDelta& out) {
+  if (!buf || redoCount == 0) return false;
+  decode(cursor, out);
+  cursor = wrap(cursor + recordLen(cursor));
+  redoCount--;
+  undoCount++;
+  return true;
+}
+
+bool UndoRing::redoJoined() const {
+  if (!buf || redoCount == 0) return false;
+  UndoHeader h;
+  get(cursor, &h, sizeof(h));
+  return h.flags & UNDO_FLAG_JOINED;
+}
+
+void UndoRing::clear() {
+  tail = cursor = head = 0;
+  used = 0;
+  undoCount = redoCount = 0;
+}
+
+#endif
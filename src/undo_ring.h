@@ -0,0 +1,67 @@
+#pragma once
+#include <Arduino.h>
+
+// ===================== UNDO RING =====================
+// Undo/redo history for the TXT editor in one fixed-size byte ring
+// (UNDO_RING_BYTES, in PSRAM when available). Each entry is a compact delta
+// against one paragraph: the byte range that changed (text removed and text
+// inserted at an offset) plus the style before and after, or the insertion /
+// removal of a whole paragraph. Records are variable length with a trailing
+// length word so the ring can be walked in both directions; when it is full
+// the oldest records are dropped, so memory stays bounded however long the
+// session runs.
+//
+//   [tail .. cursor)   entries that can be undone, oldest first
+//   [cursor .. head)   entries that can be redone; a new push drops them
+
+#define UNDO_RING_BYTES     16384
+#define UNDO_COALESCE_MS    2000   // typing pause that starts a new undo step
+
+enum UndoKind : uint8_t {
+  UNDO_TEXT = 1,        // removed -> inserted at offset, oldStyle -> newStyle
+  UNDO_INSERT_PARA = 2, // empty paragraph with newStyle inserted at para
+};
+
+struct EditDelta {
+  uint8_t  kind;
+  bool     joined;      // undone and redone together with the entry before it
+  uint32_t para;
+  uint32_t offset;
+  char     oldStyle;
+  char     newStyle;
+  String   removed;
+  String   inserted;
+};
+
+class UndoRing {
+public:
+  void push(const EditDelta& d);
+  // Entry to revert / to re-apply; false when there is none
+  bool undo(EditDelta& out);
+  bool redo(EditDelta& out);
+  // The next redo entry belongs to the group just redone
+  bool redoJoined() const;
+
+  bool canUndo() const { return undoCount > 0; }
+  bool canRedo() const { return redoCount > 0; }
+  void clear();
+
+private:
+  uint8_t* buf = nullptr;
+  size_t   tail = 0;       // oldest record
+  size_t   cursor = 0;     // end of the undoable records
+  size_t   head = 0;       // end of all records
+  size_t   used = 0;       // bytes between tail and head
+  uint16_t undoCount = 0;
+  uint16_t redoCount = 0;
+
+  bool   alloc();
+  void   put(size_t pos, const void* src, size_t n);
+  void   get(size_t pos, void* dst, size_t n) const;
+  size_t recordLen(size_t start) const;
+  size_t lenBefore(size_t end) const;
+  void   decode(size_t start, EditDelta& out) const;
+  void   dropOldest();
+};
+
+UndoRing& UNDO();
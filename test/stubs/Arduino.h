@@ -0,0 +1,31 @@
+#pragma once
+// Just enough of the Arduino core to build the host tests
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <string>
+
+using std::min;
+using std::max;
+
+unsigned long millis();
+
+class String {
+public:
+  String(const char* c = "") : s(c) {}
+  String(const std::string& str) : s(str) {}
+  const char* c_str() const { return s.c_str(); }
+  unsigned length() const { return s.size(); }
+  bool concat(const char* p, unsigned n) { s.append(p, n); return true; }
+  String operator+(const char* o) const { return String(s + o); }
+  String operator+(const String& o) const { return String(s + o.s); }
+  bool operator==(const String& o) const { return s == o.s; }
+  bool operator!=(const String& o) const { return s != o.s; }
+  bool operator<(const String& o) const { return s < o.s; }
+
+private:
+  std::string s;
+};
+
+class Print {};
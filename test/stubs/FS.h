@@ -0,0 +1,75 @@
+#pragma once
+// In-memory SD card for the host tests
+#include <Arduino.h>
+#include <map>
+#include <memory>
+#include <vector>
+
+#define FILE_READ   "r"
+#define FILE_WRITE  "w"
+#define FILE_APPEND "a"
+
+struct MemFile {
+  std::vector<uint8_t> data;
+  uint32_t mtime = 0;
+};
+
+class File {
+public:
+  File() {}
+  File(std::shared_ptr<MemFile> f, bool w) : file(f), writable(w) {}
+  explicit operator bool() const { return file != nullptr; }
+
+  size_t read(uint8_t* buf, size_t n) {
+    n = min(n, file->data.size() - pos);
+    memcpy(buf, file->data.data() + pos, n);
+    pos += n;
+    return n;
+  }
+  size_t write(const uint8_t* buf, size_t n) {
+    if (!writable) return 0;
+    file->data.insert(file->data.end(), buf, buf + n);
+    file->mtime++;
+    return n;
+  }
+  bool seek(uint32_t p) {
+    if (p > file->data.size()) return false;
+    pos = p;
+    return true;
+  }
+  size_t size() const { return file->data.size(); }
+  uint32_t getLastWrite() const { return file->mtime; }
+  void close() { file.reset(); }
+
+private:
+  std::shared_ptr<MemFile> file;
+  bool writable = false;
+  size_t pos = 0;
+};
+
+class MemFS {
+public:
+  File open(const char* path, const char* mode = FILE_READ) {
+    auto it = files.find(path);
+    if (mode[0] == 'r') return it == files.end() ? File() : File(it->second, false);
+    if (mode[0] == 'w' || it == files.end()) {
+      files[path] = std::make_shared<MemFile>();
+      files[path]->mtime = ++clock;
+    }
+    return File(files[path], true);
+  }
+  bool exists(const char* path) { return files.count(path) > 0; }
+  bool remove(const char* path) { return files.erase(path) > 0; }
+  bool rename(const char* from, const char* to) {
+    auto it = files.find(from);
+    if (it == files.end()) return false;
+    files[to] = it->second;
+    files.erase(it);
+    return true;
+  }
+
+  std::map<std::string, std::shared_ptr<MemFile>> files;
+  uint32_t clock = 0;
+};
+
+extern MemFS SD_MMC;
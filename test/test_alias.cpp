@@ -0,0 +1,56 @@
+// Host test: alias table draws follow the declared weights (src/rpg_alias.cpp).
+// Each table is sampled with a fixed-seed generator; every entry's frequency
+// must land within TOLERANCE of weight / total, and zero weights never come up.
+#include <cmath>
+#include <random>
+#include "rpg_alias.h"
+
+unsigned long millis() { return 0; }
+
+static const int DRAWS = 1000000;
+static const double TOLERANCE = 0.003;   // about six standard deviations at p = 0.5
+
+static void fail(const char* what, const char* why, int entry, double got, double want) {
+  fprintf(stderr, "FAIL %s: %s (entry %d: %.5f, want %.5f)\n", what, why, entry, got, want);
+  exit(1);
+}
+
+static void expectWeights(const std::vector<uint16_t>& weights, const char* what) {
+  AliasTable table;
+  if (!table.build(weights.data(), weights.size()) || table.size() != weights.size()) {
+    fail(what, "build failed", -1, 0, 0);
+  }
+
+  std::mt19937 rng(12345);
+  std::vector<int> hits(weights.size(), 0);
+  for (int i = 0; i < DRAWS; i++) {
+    uint8_t e = table.pick(rng());
+    if (e >= weights.size()) fail(what, "entry out of range", e, 0, 0);
+    hits[e]++;
+  }
+
+  uint32_t total = 0;
+  for (uint16_t w : weights) total += w;
+  for (size_t e = 0; e < weights.size(); e++) {
+    double got = (double)hits[e] / DRAWS;
+    double want = (double)weights[e] / total;
+    if (weights[e] == 0 && hits[e] != 0) fail(what, "zero weight drawn", e, got, want);
+    if (std::fabs(got - want) > TOLERANCE) fail(what, "frequency off", e, got, want);
+  }
+  printf("ok   %s\n", what);
+}
+
+int main() {
+  expectWeights({ 1 }, "single entry");
+  expectWeights({ 1, 1, 1, 1 }, "uniform");
+  expectWeights({ 60, 25, 10, 5 }, "encounter-style weights");
+  expectWeights({ 0, 3, 0, 7, 0 }, "zero weights");
+  expectWeights({ 65535, 1, 1 }, "one dominant entry");
+  expectWeights({ 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15, 16 }, "full table");
+
+  AliasTable empty;
+  const uint16_t zeros[3] = { 0, 0, 0 };
+  if (empty.build(zeros, 3) || empty.size() != 0) fail("all zero", "built a table", -1, 0, 0);
+  printf("ok   all zero\n");
+  return 0;
+}
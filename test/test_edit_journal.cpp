@@ -0,0 +1,140 @@
+// Host test: TXT editor journal replay round trip (src/edit_journal.cpp).
+// The editor model below journals the way OS_APPS/TXT_NEW.cpp does: INS/DEL
+// as paragraphs are created or removed, SETs for edited paragraphs at flush.
+#include <cassert>
+#include "edit_journal.h"
+#include "io_session.h"
+
+MemFS SD_MMC;
+unsigned long millis() { return 0; }
+void IoSessionManager::begin() {}
+void IoSessionManager::end() {}
+IoSessionManager& IOSESSION() {
+  static IoSessionManager instance;
+  return instance;
+}
+
+struct Para {
+  std::string text;
+  bool journal = false;
+};
+
+static const String NOTE = "/note.txt";
+static std::vector<Para> doc;
+
+static void saveNote(const std::vector<std::string>& lines) {
+  File f = SD_MMC.open(NOTE.c_str(), FILE_WRITE);
+  for (const std::string& line : lines) {
+    f.write((const uint8_t*)line.data(), line.size());
+    f.write((const uint8_t*)"\n", 1);
+  }
+  f.close();
+}
+
+// Replay targets, as in TXT_NEW.cpp
+static void replayInsert(uint32_t index) {
+  if (index > doc.size()) index = doc.size();
+  doc.insert(doc.begin() + index, Para());
+}
+static void replayDelete(uint32_t index) {
+  if (index < doc.size() && doc.size() > 1) doc.erase(doc.begin() + index);
+}
+static void replaySet(uint32_t index, char, const String& text) {
+  if (index < doc.size()) doc[index].text = text.c_str();
+}
+
+static void loadNote() {
+  doc.clear();
+  File f = SD_MMC.open(NOTE.c_str(), FILE_READ);
+  std::string all(f.size(), 0);
+  f.read((uint8_t*)&all[0], all.size());
+  size_t start = 0, nl;
+  while ((nl = all.find('\n', start)) != std::string::npos) {
+    doc.push_back({ all.substr(start, nl - start) });
+    start = nl + 1;
+  }
+  EDITJOURNAL().replay(NOTE, replayInsert, replayDelete, replaySet);
+  EDITJOURNAL().begin(NOTE);
+}
+
+// Editor actions
+static void type(size_t para, const char* text) {
+  doc[para].text += text;
+  doc[para].journal = true;
+}
+static void untype(size_t para, size_t chars) {
+  doc[para].text.resize(doc[para].text.size() - chars);
+  doc[para].journal = true;
+}
+static void enter(size_t after) {
+  doc.insert(doc.begin() + after + 1, Para());
+  doc[after + 1].journal = true;
+  EDITJOURNAL().insertLine(after + 1);
+}
+static void undoEnter(size_t para) {
+  doc.erase(doc.begin() + para);
+  EDITJOURNAL().deleteLine(para);
+}
+static void sleepFlush() {
+  for (size_t i = 0; i < doc.size(); i++) {
+    if (!doc[i].journal) continue;
+    EDITJOURNAL().setLine(i, 'T', String(doc[i].text));
+    doc[i].journal = false;
+  }
+  assert(EDITJOURNAL().flush());
+  EDITJOURNAL().end();
+}
+
+static void expect(const std::vector<std::string>& want, const char* what) {
+  std::vector<std::string> got;
+  for (const Para& p : doc) got.push_back(p.text);
+  if (got != want) {
+    fprintf(stderr, "FAIL %s:", what);
+    for (const std::string& s : got) fprintf(stderr, " [%s]", s.c_str());
+    fprintf(stderr, "\n");
+    exit(1);
+  }
+  printf("ok   %s\n", what);
+}
+
+int main() {
+  // Type, ENTER, type, undo both, sleep, reload
+  saveNote({ "one", "two" });
+  SD_MMC.remove("/note.txt.journal");
+  loadNote();
+  type(1, "!");
+  enter(1);
+  type(2, "three");
+  sleepFlush();          // timed flush in the middle of the session
+  EDITJOURNAL().begin(NOTE);
+  untype(2, 5);
+  undoEnter(2);
+  sleepFlush();
+  loadNote();
+  expect({ "one", "two!" }, "undo of a split at the end");
+
+  // New paragraphs at the end survive
+  saveNote({ "one", "two" });
+  SD_MMC.remove("/note.txt.journal");
+  loadNote();
+  enter(1);
+  type(2, "three");
+  enter(2);
+  type(3, "four");
+  sleepFlush();
+  loadNote();
+  expect({ "one", "two", "three", "four" }, "paragraphs added at the end");
+
+  // A split mid-note keeps later edits on their paragraphs
+  saveNote({ "a", "b", "c" });
+  SD_MMC.remove("/note.txt.journal");
+  loadNote();
+  type(2, "+");
+  enter(0);
+  type(1, "new");
+  type(3, "+");
+  sleepFlush();
+  loadNote();
+  expect({ "a", "new", "b", "c++" }, "split in the middle");
+  return 0;
+}